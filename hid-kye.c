@@ -795,6 +795,12 @@ static struct hid_driver kye_driver = {
 	.id_table = kye_devices,
 	.probe = kye_probe,
 	.report_fixup = kye_report_fixup,
+#if KERNEL_VERSION(4, 2, 0) <= LINUX_VERSION_CODE
+	/* Let other devices probe while the tablet is being enabled */
+	.driver = {
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
+#endif
 };
 module_hid_driver(kye_driver);
 
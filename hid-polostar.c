@@ -150,6 +150,30 @@ static __u8 pt1001_rdesc_fixed[] = {
 	0xC0,               /*  End Collection                          */
 };
 
+/**
+ * polostar_iface_num() - get the USB interface number of a device.
+ *
+ * @hdev:	The HID device to get the interface number of.
+ *
+ * Returns:
+ *	The interface number, or -1 if the device is not attached via USB,
+ *	e.g. if it was created with uhid.
+ */
+static int polostar_iface_num(struct hid_device *hdev)
+{
+	struct usb_interface *iface;
+
+#if KERNEL_VERSION(6, 3, 0) <= LINUX_VERSION_CODE
+	if (!hid_is_usb(hdev))
+		return -1;
+#elif KERNEL_VERSION(4, 14, 0) <= LINUX_VERSION_CODE
+	if (!hid_is_using_ll_driver(hdev, &usb_hid_driver))
+		return -1;
+#endif
+	iface = to_usb_interface(hdev->dev.parent);
+	return iface->cur_altsetting->desc.bInterfaceNumber;
+}
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(6, 12, 0)
 static __u8 *polostar_report_fixup(struct hid_device *hdev, __u8 *rdesc,
 				   unsigned int *rsize)
@@ -158,12 +182,13 @@ static const __u8 *polostar_report_fixup(struct hid_device *hdev, __u8 *rdesc,
 				   unsigned int *rsize)
 #endif
 {
-	struct usb_interface *iface = to_usb_interface(hdev->dev.parent);
-	__u8 iface_num = iface->cur_altsetting->desc.bInterfaceNumber;
+	int iface_num = polostar_iface_num(hdev);
 
 	switch (hdev->product) {
 	case USB_DEVICE_ID_POLOSTAR_TABLET_PT1001:
-		if (iface_num == 1 && *rsize == PT1001_RDESC_ORIG_SIZE) {
+		/* Devices not on USB, e.g. uhid, are the pen interface */
+		if ((iface_num == 1 || iface_num < 0) &&
+		    *rsize == PT1001_RDESC_ORIG_SIZE) {
 			rdesc = pt1001_rdesc_fixed;
 			*rsize = sizeof(pt1001_rdesc_fixed);
 		}
@@ -176,12 +201,10 @@ static const __u8 *polostar_report_fixup(struct hid_device *hdev, __u8 *rdesc,
 static int polostar_probe(struct hid_device *hdev,
 			  const struct hid_device_id *id)
 {
-	struct usb_interface *iface = to_usb_interface(hdev->dev.parent);
-	__u8 iface_num = iface->cur_altsetting->desc.bInterfaceNumber;
 	int rc;
 
 	if (hdev->product == USB_DEVICE_ID_POLOSTAR_TABLET_PT1001 &&
-	    iface_num == 2)
+	    polostar_iface_num(hdev) == 2)
 		return -ENODEV;
 
 	hdev->quirks |= id->driver_data;
@@ -0,0 +1,1119 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - report replay corpus
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+/*
+ * Report sequences replayed through uclogic_raw_event() by the replay test,
+ * one per tablet model, each with the parameters the model is probed with.
+ *
+ * The sequences follow the report formats of the respective tablets. The
+ * expected bytes are the ones produced by the report handling before it was
+ * compiled into rewrite programs, so any change to the hot path is checked
+ * against the original behavior. A step without a report lets the pen
+ * in-range timer expire, and checks whether the pen went out of range then.
+ *
+ * The corpus also has the shapes of parameters and reports to benchmark
+ * the report handling with, both in KUnit and in the userspace build.
+ *
+ * Keep the reports no longer than UCLOGIC_REPLAY_REPORT_MAX bytes.
+ */
+
+#ifndef _HID_UCLOGIC_CORE_TEST_CORPUS_H
+#define _HID_UCLOGIC_CORE_TEST_CORPUS_H
+
+#include "hid-uclogic-params.h"
+#include "hid-uclogic-rdesc.h"
+
+/* Maximum size of a replayed report */
+#define UCLOGIC_REPLAY_REPORT_MAX 16
+
+/* A step of a replayed report sequence */
+struct uclogic_replay_step {
+	/* Size of the report, zero to let the pen in-range timer expire */
+	__u8 size;
+	/* The report, as sent by the tablet */
+	__u8 report[UCLOGIC_REPLAY_REPORT_MAX];
+	/* The report, as passed on by the driver */
+	__u8 expected[UCLOGIC_REPLAY_REPORT_MAX];
+	/* True if the pen went out of range, when the timer expired */
+	bool pen_out;
+};
+
+/* A tablet model's report sequence */
+struct uclogic_replay_model {
+	const char *name;
+	/* Fill in the parameters the model is probed with */
+	void (*init)(struct uclogic_params *params);
+	const struct uclogic_replay_step *steps;
+	size_t num_steps;
+};
+
+/* Huion v1 pen with inverted in-range reports, and v1 frame buttons */
+static const struct uclogic_replay_step uclogic_replay_huion_v1_steps[] = {
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x80, 0xe8, 0x03, 0xd0, 0x07, 0x00, 0x00,
+		},
+		.expected = {
+			0x07, 0xc0, 0xe8, 0x03, 0xd0, 0x07, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x81, 0xf2, 0x03, 0xd5, 0x07, 0x2c, 0x01,
+		},
+		.expected = {
+			0x07, 0xc1, 0xf2, 0x03, 0xd5, 0x07, 0x2c, 0x01,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x81, 0x06, 0x04, 0xdb, 0x07, 0x8a, 0x02,
+		},
+		.expected = {
+			0x07, 0xc1, 0x06, 0x04, 0xdb, 0x07, 0x8a, 0x02,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x80, 0x10, 0x04, 0xdf, 0x07, 0x00, 0x00,
+		},
+		.expected = {
+			0x07, 0xc0, 0x10, 0x04, 0xdf, 0x07, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x07, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = false },
+	{
+		.size = 8,
+		.report = {
+			0x07, 0xe0, 0x01, 0x01, 0x05, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xe0, 0x01, 0x01, 0x05, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0xe0, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xe0, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x80, 0xb0, 0x04, 0x98, 0x08, 0x00, 0x00,
+		},
+		.expected = {
+			0x07, 0xc0, 0xb0, 0x04, 0x98, 0x08, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x82, 0xb0, 0x04, 0x98, 0x08, 0x00, 0x00,
+		},
+		.expected = {
+			0x07, 0xc2, 0xb0, 0x04, 0x98, 0x08, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = false },
+};
+
+static void uclogic_replay_init_huion_v1(struct uclogic_params *p)
+{
+	p->pen.id = UCLOGIC_RDESC_V1_PEN_ID;
+	p->pen.inrange = UCLOGIC_PARAMS_PEN_INRANGE_INVERTED;
+	p->pen.subreport_list[0].value = 0xe0;
+	p->pen.subreport_list[0].id = UCLOGIC_RDESC_V1_FRAME_ID;
+	p->frame_list[0].id = UCLOGIC_RDESC_V1_FRAME_ID;
+}
+
+/* Huion v2 pen with emulated in-range, frame buttons, touch ring, dial
+ * and group buttons */
+static const struct uclogic_replay_step uclogic_replay_huion_v2_touch_ring_steps[] = {
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x45, 0x23, 0xcd, 0xab, 0x00, 0x00,
+			0x01, 0x00, 0x0c, 0xec,
+		},
+		.expected = {
+			0x08, 0xc0, 0x45, 0x23, 0x01, 0xcd, 0xab, 0x00,
+			0x00, 0x00, 0x0c, 0x14,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x81, 0x50, 0x23, 0xd0, 0xab, 0x00, 0x04,
+			0x01, 0x00, 0x0c, 0xec,
+		},
+		.expected = {
+			0x08, 0xc1, 0x50, 0x23, 0x01, 0xd0, 0xab, 0x00,
+			0x00, 0x04, 0x0c, 0x14,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x81, 0x60, 0x23, 0xe0, 0xab, 0x00, 0x08,
+			0x01, 0x00, 0x0a, 0xee,
+		},
+		.expected = {
+			0x08, 0xc1, 0x60, 0x23, 0x01, 0xe0, 0xab, 0x00,
+			0x00, 0x08, 0x0a, 0x12,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x83, 0x70, 0x23, 0xf0, 0xab, 0x00, 0x0c,
+			0x01, 0x00, 0x08, 0xf0,
+		},
+		.expected = {
+			0x08, 0xc3, 0x70, 0x23, 0x01, 0xf0, 0xab, 0x00,
+			0x00, 0x0c, 0x08, 0x10,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x80, 0x23, 0x00, 0xac, 0x00, 0x00,
+			0x01, 0x00, 0x08, 0xf0,
+		},
+		.expected = {
+			0x08, 0xc0, 0x80, 0x23, 0x01, 0x00, 0xac, 0x00,
+			0x00, 0x00, 0x08, 0x10,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = false },
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xe0, 0x01, 0x01, 0x03, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xe0, 0x01, 0x01, 0x03, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xe0, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xe0, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x05, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x03, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x03, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x07, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x0b, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x09, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x09, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x0c, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x06, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x02, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0xff, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xe3, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xfa, 0xe3, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x02, 0x01, 0xfb, 0x05,
+		},
+		.expected = {
+			0x08, 0xc0, 0x00, 0x00, 0x02, 0x00, 0x00, 0x01,
+			0x00, 0x00, 0xfb, 0xfb,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x81, 0x10, 0x00, 0x10, 0x00, 0xff, 0x1f,
+			0x02, 0x01, 0xfb, 0x05,
+		},
+		.expected = {
+			0x08, 0xc1, 0x10, 0x00, 0x02, 0x10, 0x00, 0x01,
+			0xff, 0x1f, 0xfb, 0xfb,
+		},
+	},
+	{ .pen_out = true },
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x20, 0x00, 0x20, 0x00, 0x00, 0x00,
+			0x02, 0x01, 0x00, 0x00,
+		},
+		.expected = {
+			0x08, 0xc0, 0x20, 0x00, 0x02, 0x20, 0x00, 0x01,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = true },
+};
+
+static void uclogic_replay_init_huion_v2(struct uclogic_params *p)
+{
+	p->pen.id = UCLOGIC_RDESC_V2_PEN_ID;
+	p->pen.inrange = UCLOGIC_PARAMS_PEN_INRANGE_NONE;
+	p->pen.proximity_out_list[0].byte = 1;
+	p->pen.proximity_out_list[0].mask = 0xff;
+	p->pen.proximity_out_list[0].value = 0xc0;
+	p->pen.fragmented_hires = true;
+	p->pen.tilt_y_flipped = true;
+	p->pen.subreport_list[0].value = 0xe0;
+	p->pen.subreport_list[0].id = UCLOGIC_RDESC_V2_FRAME_BUTTONS_ID;
+	p->pen.subreport_list[1].value = 0xf0;
+	p->pen.subreport_list[1].id = UCLOGIC_RDESC_V2_FRAME_TOUCH_ID;
+	p->pen.subreport_list[2].value = 0xf1;
+	p->pen.subreport_list[2].id = UCLOGIC_RDESC_V2_FRAME_DIAL_ID;
+	p->pen.subreport_list[3].value = 0xe3;
+	p->pen.subreport_list[3].id = UCLOGIC_RDESC_V2_FRAME_GBUTTONS_ID;
+	p->frame_list[0].id = UCLOGIC_RDESC_V2_FRAME_BUTTONS_ID;
+	p->frame_list[1].id = UCLOGIC_RDESC_V2_FRAME_TOUCH_ID;
+	p->frame_list[1].dev_id_byte = UCLOGIC_RDESC_V2_FRAME_TOUCH_DEV_ID_BYTE;
+	p->frame_list[1].touch_byte = 5;
+	p->frame_list[2].id = UCLOGIC_RDESC_V2_FRAME_DIAL_ID;
+	p->frame_list[2].dev_id_byte = UCLOGIC_RDESC_V2_FRAME_DIAL_DEV_ID_BYTE;
+	p->frame_list[2].bitmap_dial_byte = 5;
+	p->frame_list[3].id = UCLOGIC_RDESC_V2_FRAME_GBUTTONS_ID;
+}
+
+static void uclogic_replay_init_huion_v2_touch_ring(struct uclogic_params *p)
+{
+	uclogic_replay_init_huion_v2(p);
+	p->frame_list[1].touch_max = 12;
+	p->frame_list[1].touch_flip_at = 7;
+}
+
+/* Huion v2 pen with emulated in-range, frame buttons, touch strip, dial
+ * and group buttons */
+static const struct uclogic_replay_step uclogic_replay_huion_v2_touch_strip_steps[] = {
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x45, 0x23, 0xcd, 0xab, 0x00, 0x00,
+			0x01, 0x00, 0x0c, 0xec,
+		},
+		.expected = {
+			0x08, 0xc0, 0x45, 0x23, 0x01, 0xcd, 0xab, 0x00,
+			0x00, 0x00, 0x0c, 0x14,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x81, 0x50, 0x23, 0xd0, 0xab, 0x00, 0x04,
+			0x01, 0x00, 0x0c, 0xec,
+		},
+		.expected = {
+			0x08, 0xc1, 0x50, 0x23, 0x01, 0xd0, 0xab, 0x00,
+			0x00, 0x04, 0x0c, 0x14,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x81, 0x60, 0x23, 0xe0, 0xab, 0x00, 0x08,
+			0x01, 0x00, 0x0a, 0xee,
+		},
+		.expected = {
+			0x08, 0xc1, 0x60, 0x23, 0x01, 0xe0, 0xab, 0x00,
+			0x00, 0x08, 0x0a, 0x12,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x83, 0x70, 0x23, 0xf0, 0xab, 0x00, 0x0c,
+			0x01, 0x00, 0x08, 0xf0,
+		},
+		.expected = {
+			0x08, 0xc3, 0x70, 0x23, 0x01, 0xf0, 0xab, 0x00,
+			0x00, 0x0c, 0x08, 0x10,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x80, 0x23, 0x00, 0xac, 0x00, 0x00,
+			0x01, 0x00, 0x08, 0xf0,
+		},
+		.expected = {
+			0x08, 0xc0, 0x80, 0x23, 0x01, 0x00, 0xac, 0x00,
+			0x00, 0x00, 0x08, 0x10,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = false },
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xe0, 0x01, 0x01, 0x03, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xe0, 0x01, 0x01, 0x03, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xe0, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xe0, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x04, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x03, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x08, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x0f, 0x07, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf0, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf8, 0xf0, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x02, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0xff, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0x01, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xf1, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf9, 0xf1, 0x01, 0x02, 0x0f, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0xe3, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xfa, 0xe3, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x02, 0x01, 0xfb, 0x05,
+		},
+		.expected = {
+			0x08, 0xc0, 0x00, 0x00, 0x02, 0x00, 0x00, 0x01,
+			0x00, 0x00, 0xfb, 0xfb,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x81, 0x10, 0x00, 0x10, 0x00, 0xff, 0x1f,
+			0x02, 0x01, 0xfb, 0x05,
+		},
+		.expected = {
+			0x08, 0xc1, 0x10, 0x00, 0x02, 0x10, 0x00, 0x01,
+			0xff, 0x1f, 0xfb, 0xfb,
+		},
+	},
+	{ .pen_out = true },
+	{
+		.size = 12,
+		.report = {
+			0x08, 0x80, 0x20, 0x00, 0x20, 0x00, 0x00, 0x00,
+			0x02, 0x01, 0x00, 0x00,
+		},
+		.expected = {
+			0x08, 0xc0, 0x20, 0x00, 0x02, 0x20, 0x00, 0x01,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = true },
+};
+
+static void uclogic_replay_init_huion_v2_touch_strip(struct uclogic_params *p)
+{
+	uclogic_replay_init_huion_v2(p);
+	p->frame_list[1].touch_max = 8;
+}
+
+/* UGEE v2 pen, and buttons frame */
+static const struct uclogic_replay_step uclogic_replay_ugee_v2_buttons_steps[] = {
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xa0, 0x64, 0x00, 0xc8, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x02, 0xa0, 0x64, 0x00, 0xc8, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xa1, 0x6e, 0x00, 0xd2, 0x00, 0x20, 0x03,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x02, 0xa1, 0x6e, 0x00, 0xd2, 0x00, 0x20, 0x03,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xa0, 0x78, 0x00, 0xdc, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x02, 0xa0, 0x78, 0x00, 0xdc, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x02, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xf0, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xf0, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{ .pen_out = false },
+};
+
+static void uclogic_replay_init_ugee_v2_buttons(struct uclogic_params *p)
+{
+	p->pen.id = 0x02;
+	p->pen.subreport_list[0].value = 0xf0;
+	p->pen.subreport_list[0].id = UCLOGIC_RDESC_V1_FRAME_ID;
+	p->frame_list[0].id = UCLOGIC_RDESC_V1_FRAME_ID;
+}
+
+/* UGEE v2 pen, and dial frame */
+static const struct uclogic_replay_step uclogic_replay_ugee_v2_dial_steps[] = {
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xa0, 0x64, 0x00, 0xc8, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x02, 0xa0, 0x64, 0x00, 0xc8, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x02,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 12,
+		.report = {
+			0x02, 0xf0, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0xf0, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+};
+
+static void uclogic_replay_init_ugee_v2_dial(struct uclogic_params *p)
+{
+	uclogic_replay_init_ugee_v2_buttons(p);
+	p->frame_list[0].bitmap_dial_byte = 7;
+}
+
+/* UGEE v2 mouse frame interface */
+static const struct uclogic_replay_step uclogic_replay_ugee_v2_mouse_steps[] = {
+	{
+		.size = 12,
+		.report = {
+			0xf7, 0x01, 0x02, 0x03, 0x04, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0xf7, 0x01, 0x02, 0x03, 0x04, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 5,
+		.report = {
+			0x01, 0x01, 0x05, 0xfb, 0x00,
+		},
+		.expected = {
+			0x01, 0x01, 0x05, 0xfb, 0x00,
+		},
+	},
+};
+
+static void uclogic_replay_init_ugee_v2_mouse(struct uclogic_params *p)
+{
+	p->frame_list[1].id = UCLOGIC_RDESC_V1_FRAME_ID;
+}
+
+/* UGEE G5 pen, and frame with a rotary encoder */
+static const struct uclogic_replay_step uclogic_replay_ugee_g5_steps[] = {
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x80, 0xf4, 0x01, 0x58, 0x02, 0x00, 0x00,
+		},
+		.expected = {
+			0x07, 0xc0, 0xf4, 0x01, 0x58, 0x02, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x07, 0x81, 0xf4, 0x01, 0x58, 0x02, 0x64, 0x00,
+		},
+		.expected = {
+			0x07, 0xc1, 0xf4, 0x01, 0x58, 0x02, 0x64, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x40, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0xc0, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0xc0, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x40, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x01, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+	{
+		.size = 8,
+		.report = {
+			0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+		.expected = {
+			0x06, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00,
+		},
+	},
+};
+
+static void uclogic_replay_init_ugee_g5(struct uclogic_params *p)
+{
+	p->pen.id = UCLOGIC_RDESC_V1_PEN_ID;
+	p->pen.inrange = UCLOGIC_PARAMS_PEN_INRANGE_INVERTED;
+	p->frame_list[0].id = UCLOGIC_RDESC_UGEE_G5_FRAME_ID;
+	p->frame_list[0].re_lsb = UCLOGIC_RDESC_UGEE_G5_FRAME_RE_LSB;
+	p->frame_list[0].dev_id_byte = UCLOGIC_RDESC_UGEE_G5_FRAME_DEV_ID_BYTE;
+}
+
+#define UCLOGIC_REPLAY_MODEL(_name) \
+	{ \
+		.name = #_name, \
+		.init = uclogic_replay_init_##_name, \
+		.steps = uclogic_replay_##_name##_steps, \
+		.num_steps = ARRAY_SIZE(uclogic_replay_##_name##_steps), \
+	}
+
+static const struct uclogic_replay_model uclogic_replay_models[] = {
+	UCLOGIC_REPLAY_MODEL(huion_v1),
+	UCLOGIC_REPLAY_MODEL(huion_v2_touch_ring),
+	UCLOGIC_REPLAY_MODEL(huion_v2_touch_strip),
+	UCLOGIC_REPLAY_MODEL(ugee_v2_buttons),
+	UCLOGIC_REPLAY_MODEL(ugee_v2_dial),
+	UCLOGIC_REPLAY_MODEL(ugee_v2_mouse),
+	UCLOGIC_REPLAY_MODEL(ugee_g5),
+};
+
+#undef UCLOGIC_REPLAY_MODEL
+
+/* A shape of parameters, and a report to benchmark with it */
+struct uclogic_bench_shape {
+	const char *name;
+	/* Fill in the parameters, NULL to leave them empty */
+	void (*init)(struct uclogic_params *params);
+	/* Number of event hooks to add, not matching the report */
+	unsigned int hooks;
+	__u8 size;
+	__u8 report[UCLOGIC_REPLAY_REPORT_MAX];
+};
+
+static const struct uclogic_bench_shape uclogic_bench_shapes[] = {
+	{
+		.name = "passthrough",
+		.size = 8,
+		.report = { 0x01, 0x01, 0x10, 0x20, 0x30, 0x40, 0x00, 0x00 },
+	},
+	{
+		.name = "pen_v1_inverted",
+		.init = uclogic_replay_init_huion_v1,
+		.size = 8,
+		.report = { 0x07, 0x81, 0xf2, 0x03, 0xd5, 0x07, 0x2c, 0x01 },
+	},
+	{
+		.name = "pen_v2_hires_tilt",
+		.init = uclogic_replay_init_huion_v2_touch_ring,
+		.size = 12,
+		.report = { 0x08, 0x81, 0x50, 0x23, 0xd0, 0xab, 0x00, 0x04,
+			    0x01, 0x00, 0x0c, 0xec },
+	},
+	{
+		.name = "frame_buttons",
+		.init = uclogic_replay_init_huion_v2_touch_ring,
+		.size = 12,
+		.report = { 0x08, 0xe0, 0x01, 0x01, 0x03 },
+	},
+	{
+		.name = "frame_touch_ring",
+		.init = uclogic_replay_init_huion_v2_touch_ring,
+		.size = 12,
+		.report = { 0x08, 0xf0, 0x01, 0x02, 0x00, 0x09 },
+	},
+	{
+		.name = "frame_touch_strip",
+		.init = uclogic_replay_init_huion_v2_touch_strip,
+		.size = 12,
+		.report = { 0x08, 0xf0, 0x01, 0x02, 0x00, 0x04 },
+	},
+	{
+		.name = "frame_dial",
+		.init = uclogic_replay_init_huion_v2_touch_ring,
+		.size = 12,
+		.report = { 0x08, 0xf1, 0x01, 0x02, 0x00, 0x02 },
+	},
+	{
+		.name = "frame_gbuttons",
+		.init = uclogic_replay_init_huion_v2_touch_ring,
+		.size = 12,
+		.report = { 0x08, 0xe3, 0x01, 0x01, 0x01 },
+	},
+	{
+		.name = "frame_ugee_dial",
+		.init = uclogic_replay_init_ugee_v2_dial,
+		.size = 12,
+		.report = { 0x02, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x02 },
+	},
+	{
+		.name = "frame_encoder",
+		.init = uclogic_replay_init_ugee_g5,
+		.size = 8,
+		.report = { 0x06, 0x00, 0x00, 0x00, 0x40 },
+	},
+	{
+		.name = "event_hooks",
+		.init = uclogic_replay_init_ugee_v2_buttons,
+		.hooks = 64,
+		.size = 12,
+		.report = { 0x02, 0xa1, 0x6e, 0x00, 0xd2, 0x00, 0x20, 0x03 },
+	},
+};
+
+/**
+ * uclogic_bench_shape_init() - fill in the parameters of a benchmark shape.
+ *
+ * @shape:	The shape to fill in the parameters of.
+ * @params:	The parameters to fill in, zeroed. Cleanup with
+ *		uclogic_params_cleanup() regardless of the outcome.
+ * @hook_func:	The work function of the event hooks to add.
+ *
+ * Returns:
+ *	Zero, if successful. A negative errno code on error.
+ */
+static int uclogic_bench_shape_init(const struct uclogic_bench_shape *shape,
+				    struct uclogic_params *params,
+				    work_func_t hook_func)
+{
+	__u8 event[4] = { shape->report[0], 0x00, 0x00, 0x00 };
+	unsigned int n;
+	int rc;
+
+	if (shape->init != NULL)
+		shape->init(params);
+	/* Hooks on the same report ID, none matching the report */
+	for (n = 0; n < shape->hooks; n++) {
+		event[1] = n == shape->report[1] ? U8_MAX : n;
+		rc = uclogic_params_add_event_hook(params, NULL, event, NULL,
+						   sizeof(event), hook_func);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+#endif /* _HID_UCLOGIC_CORE_TEST_CORPUS_H */
@@ -7,7 +7,10 @@
  */
 
 #include <kunit/test.h>
+#include <linux/delay.h>
+#include <linux/kthread.h>
 #include "./hid-uclogic-params.h"
+#include "./hid-uclogic-rdesc.h"
 
 #define MAX_EVENT_SIZE 12
 
@@ -61,42 +64,1254 @@ static void fake_work(struct work_struct *work)
 
 }
 
+static void fake_timeout(struct timer_list *t)
+{
+
+}
+
 static void hid_test_uclogic_exec_event_hook_test(struct kunit *test)
 {
 	struct uclogic_params p = {0, };
-	struct uclogic_raw_event_hook *filter;
 	bool res;
-	int n;
-
-	/* Initialize the list of events to hook */
-	p.event_hooks = kunit_kzalloc(test, sizeof(*p.event_hooks), GFP_KERNEL);
-	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, p.event_hooks);
-	INIT_LIST_HEAD(&p.event_hooks->list);
+	int rc, n;
 
+	/* Register the events to hook */
 	for (n = 0; n < ARRAY_SIZE(hook_events); n++) {
-		filter = kunit_kzalloc(test, sizeof(*filter), GFP_KERNEL);
-		KUNIT_ASSERT_NOT_ERR_OR_NULL(test, filter);
-
-		filter->size = hook_events[n].size;
-		filter->event = kunit_kzalloc(test, filter->size, GFP_KERNEL);
-		KUNIT_ASSERT_NOT_ERR_OR_NULL(test, filter->event);
-		memcpy(filter->event, &hook_events[n].event[0], filter->size);
-
-		INIT_WORK(&filter->work, fake_work);
-
-		list_add_tail(&filter->list, &p.event_hooks->list);
+		rc = uclogic_params_add_event_hook(&p, NULL,
+						   &hook_events[n].event[0],
+						   NULL, hook_events[n].size,
+						   fake_work);
+		KUNIT_ASSERT_EQ(test, rc, 0);
 	}
 
 	/* Test uclogic_exec_event_hook() */
 	for (n = 0; n < ARRAY_SIZE(test_events); n++) {
-		res = uclogic_exec_event_hook(&p, &test_events[n].event[0],
+		res = uclogic_exec_event_hook(NULL, &p,
+					      &test_events[n].event[0],
 					      test_events[n].size);
 		KUNIT_ASSERT_EQ(test, res, test_events[n].expected);
 	}
+
+	uclogic_params_cleanup(&p);
+	KUNIT_EXPECT_PTR_EQ(test, p.event_hooks, NULL);
+}
+
+struct uclogic_raw_event_hook_masked_test {
+	u8 event[MAX_EVENT_SIZE];
+	u8 mask[MAX_EVENT_SIZE];
+	size_t size;
+};
+
+static struct uclogic_raw_event_hook_masked_test masked_hook_events[] = {
+	{
+		/* Any third byte */
+		.event = { 0x02, 0xF8, 0x00, 0x01 },
+		.mask = { 0xFF, 0xFF, 0x00, 0xFF },
+		.size = 4,
+	},
+	{
+		/* Any low nibble in the first byte, any second byte */
+		.event = { 0x10, 0x00, 0x3D },
+		.mask = { 0xF0, 0x00, 0xFF },
+		.size = 3,
+	},
+};
+
+static struct uclogic_raw_event_hook_test masked_test_events[] = {
+	{
+		.event = { 0x02, 0xF8, 0x02, 0x01 },
+		.size = 4,
+		.expected = true,
+	},
+	{
+		.event = { 0x02, 0xF8, 0xC0, 0x01 },
+		.size = 4,
+		.expected = true,
+	},
+	{
+		.event = { 0x02, 0xF8, 0x02, 0x02 },
+		.size = 4,
+		.expected = false,
+	},
+	{
+		.event = { 0x02, 0xF8, 0x02, 0x01, 0x00 },
+		.size = 5,
+		.expected = false,
+	},
+	{
+		.event = { 0x1F, 0xAB, 0x3D },
+		.size = 3,
+		.expected = true,
+	},
+	{
+		.event = { 0x10, 0x00, 0x3D },
+		.size = 3,
+		.expected = true,
+	},
+	{
+		.event = { 0x20, 0x00, 0x3D },
+		.size = 3,
+		.expected = false,
+	},
+	{
+		.event = { 0x1F, 0xAB, 0x3E },
+		.size = 3,
+		.expected = false,
+	},
+};
+
+static void hid_test_uclogic_exec_event_hook_masked_test(struct kunit *test)
+{
+	struct uclogic_params p = {0, };
+	bool res;
+	int rc, n;
+
+	for (n = 0; n < ARRAY_SIZE(masked_hook_events); n++) {
+		rc = uclogic_params_add_event_hook(
+				&p, NULL, &masked_hook_events[n].event[0],
+				&masked_hook_events[n].mask[0],
+				masked_hook_events[n].size, fake_work);
+		KUNIT_ASSERT_EQ(test, rc, 0);
+	}
+
+	for (n = 0; n < ARRAY_SIZE(masked_test_events); n++) {
+		res = uclogic_exec_event_hook(NULL, &p,
+					      &masked_test_events[n].event[0],
+					      masked_test_events[n].size);
+		KUNIT_EXPECT_EQ(test, res, masked_test_events[n].expected);
+	}
+
+	uclogic_params_cleanup(&p);
+}
+
+static void hid_test_uclogic_match_event_hook_order_test(struct kunit *test)
+{
+	struct uclogic_params p = {0, };
+	struct uclogic_raw_event_hook *hook;
+	const u8 event[] = { 0x02, 0xF8, 0x02, 0x01 };
+	const u8 other_event[] = { 0x02, 0xF8, 0x03, 0x01 };
+	const u8 mask[] = { 0xFF, 0x00, 0x00, 0xFF };
+	int rc, n;
+
+	/* Register an exact hook before a wildcard one, then vice versa */
+	for (n = 0; n < 2; n++) {
+		rc = uclogic_params_add_event_hook(&p, NULL, event,
+						   n == 0 ? NULL : mask,
+						   sizeof(event), fake_work);
+		KUNIT_ASSERT_EQ(test, rc, 0);
+	}
+	hook = uclogic_match_event_hook(p.event_hooks, event, sizeof(event));
+	KUNIT_ASSERT_NOT_NULL(test, hook);
+	KUNIT_EXPECT_EQ(test, hook->index, 0);
+	hook = uclogic_match_event_hook(p.event_hooks, other_event,
+					sizeof(other_event));
+	KUNIT_ASSERT_NOT_NULL(test, hook);
+	KUNIT_EXPECT_EQ(test, hook->index, 1);
+	uclogic_params_cleanup(&p);
+
+	for (n = 0; n < 2; n++) {
+		rc = uclogic_params_add_event_hook(&p, NULL, event,
+						   n == 0 ? mask : NULL,
+						   sizeof(event), fake_work);
+		KUNIT_ASSERT_EQ(test, rc, 0);
+	}
+	hook = uclogic_match_event_hook(p.event_hooks, event, sizeof(event));
+	KUNIT_ASSERT_NOT_NULL(test, hook);
+	KUNIT_EXPECT_EQ(test, hook->index, 0);
+	uclogic_params_cleanup(&p);
+}
+
+static void hid_test_uclogic_match_event_hook_many_test(struct kunit *test)
+{
+	struct uclogic_params p = {0, };
+	struct uclogic_raw_event_hook *hook;
+	u8 event[MAX_EVENT_SIZE] = { 0x02, 0xF8, 0x00, 0x01 };
+	int rc, n;
+
+	/* Register hooks of varying size and second byte */
+	for (n = 0; n < 64; n++) {
+		event[1] = n;
+		rc = uclogic_params_add_event_hook(&p, NULL, event, NULL,
+						   4 + n % 8, fake_work);
+		KUNIT_ASSERT_EQ(test, rc, 0);
+	}
+	KUNIT_EXPECT_EQ(test, p.event_hooks->num, 64);
+
+	/* Each registered event matches its own hook only */
+	for (n = 0; n < 64; n++) {
+		event[1] = n;
+		hook = uclogic_match_event_hook(p.event_hooks, event,
+						4 + n % 8);
+		KUNIT_ASSERT_NOT_NULL(test, hook);
+		KUNIT_EXPECT_EQ(test, hook->index, n);
+		KUNIT_EXPECT_NULL(test, uclogic_match_event_hook(
+					p.event_hooks, event, 4 + (n + 1) % 8));
+	}
+
+	/* Events with other first bytes, sizes or contents are rejected */
+	event[0] = 0x03;
+	event[1] = 0;
+	KUNIT_EXPECT_NULL(test, uclogic_match_event_hook(p.event_hooks,
+							 event, 4));
+	event[0] = 0x02;
+	KUNIT_EXPECT_NULL(test, uclogic_match_event_hook(p.event_hooks,
+							 event, 3));
+	KUNIT_EXPECT_NULL(test, uclogic_match_event_hook(p.event_hooks,
+							 event, 0));
+	event[1] = 64;
+	KUNIT_EXPECT_NULL(test, uclogic_match_event_hook(p.event_hooks,
+							 event, 4));
+
+	uclogic_params_cleanup(&p);
+}
+
+struct uclogic_raw_prog_test {
+	const char *name;
+	struct uclogic_params_pen pen;
+	struct uclogic_params_frame frame;
+	u8 report[MAX_EVENT_SIZE];
+	u8 expected[MAX_EVENT_SIZE];
+	int size;
+};
+
+static struct uclogic_raw_prog_test raw_prog_tests[] = {
+	{
+		.name = "inverted_fragmented_tilt",
+		.pen = {
+			.id = 0x08,
+			.inrange = UCLOGIC_PARAMS_PEN_INRANGE_INVERTED,
+			.fragmented_hires = true,
+			.tilt_y_flipped = true,
+		},
+		.report = { 0x08, 0x80, 0x11, 0x22, 0x33, 0x44,
+			    0x55, 0x66, 0x77, 0x88, 0x99, 0x05 },
+		.expected = { 0x08, 0xC0, 0x11, 0x22, 0x77, 0x33,
+			      0x44, 0x88, 0x55, 0x66, 0x99, 0xFB },
+		.size = 12,
+	},
+	{
+		.name = "inverted_fragmented_tilt_short",
+		.pen = {
+			.id = 0x08,
+			.inrange = UCLOGIC_PARAMS_PEN_INRANGE_INVERTED,
+			.fragmented_hires = true,
+			.tilt_y_flipped = true,
+		},
+		.report = { 0x08, 0xC0, 0x11, 0x22, 0x33, 0x44,
+			    0x55, 0x66, 0x77 },
+		.expected = { 0x08, 0x80, 0x11, 0x22, 0x33, 0x44,
+			      0x55, 0x66, 0x77 },
+		.size = 9,
+	},
+	{
+		.name = "emulated_inrange",
+		.pen = {
+			.id = 0x08,
+			.inrange = UCLOGIC_PARAMS_PEN_INRANGE_NONE,
+			.proximity_out_list = { { 1, 0xff, 0xc0 } },
+		},
+		.report = { 0x08, 0x81, 0x11, 0x22 },
+		.expected = { 0x08, 0xC1, 0x11, 0x22 },
+		.size = 4,
+	},
+	{
+		.name = "emulated_inrange_proximity_out",
+		.pen = {
+			.id = 0x08,
+			.inrange = UCLOGIC_PARAMS_PEN_INRANGE_NONE,
+			.proximity_out_list = { { 1, 0xff, 0xc0 } },
+		},
+		.report = { 0x08, 0xC0, 0x11, 0x22 },
+		.expected = { 0x08, 0x80, 0x11, 0x22 },
+		.size = 4,
+	},
+	{
+		.name = "frame_touch_ring_lift",
+		.frame = {
+			.id = 0xf7,
+			.dev_id_byte = 2,
+			.touch_byte = 5,
+			.touch_max = 12,
+			.touch_flip_at = 7,
+		},
+		.report = { 0xf7, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+		.expected = { 0xf7, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+		.size = 8,
+	},
+	{
+		.name = "frame_touch_ring_flip",
+		.frame = {
+			.id = 0xf7,
+			.dev_id_byte = 2,
+			.touch_byte = 5,
+			.touch_max = 12,
+			.touch_flip_at = 7,
+		},
+		.report = { 0xf7, 0xf0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00 },
+		.expected = { 0xf7, 0xf0, 0x0f, 0x00, 0x00, 0x05, 0x00, 0x00 },
+		.size = 8,
+	},
+	{
+		.name = "frame_bitmap_dial_short",
+		.frame = {
+			.id = 0xf7,
+			.dev_id_byte = 2,
+			.bitmap_dial_byte = 5,
+		},
+		.report = { 0xf7, 0xf0, 0x00, 0x00, 0x02 },
+		.expected = { 0xf7, 0xf0, 0x0f, 0x00, 0x02 },
+		.size = 5,
+	},
+	{
+		.name = "frame_bitmap_dial",
+		.frame = {
+			.id = 0xf7,
+			.dev_id_byte = 2,
+			.bitmap_dial_byte = 5,
+		},
+		.report = { 0xf7, 0xf0, 0x00, 0x00, 0x00, 0x02 },
+		.expected = { 0xf7, 0xf0, 0x0f, 0x00, 0x00, 0xFF },
+		.size = 6,
+	},
+};
+
+static void uclogic_raw_prog_test_desc(const struct uclogic_raw_prog_test *t,
+				       char *desc)
+{
+	strscpy(desc, t->name, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(uclogic_raw_prog, raw_prog_tests, uclogic_raw_prog_test_desc);
+
+static void hid_test_uclogic_raw_prog_test(struct kunit *test)
+{
+	const struct uclogic_raw_prog_test *params = test->param_value;
+	struct uclogic_drvdata *drvdata;
+	u8 data[MAX_EVENT_SIZE];
+
+	drvdata = kunit_kzalloc(test, sizeof(*drvdata), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata);
+	drvdata->params.pen = params->pen;
+	drvdata->params.frame_list[0] = params->frame;
+	KUNIT_ASSERT_EQ(test,
+			uclogic_params_get_raw(&drvdata->params, &drvdata->raw),
+			0);
+	timer_setup(&drvdata->inrange_timer, fake_timeout, 0);
+
+	memcpy(data, params->report, sizeof(data));
+	if (params->pen.id != 0)
+		uclogic_raw_event_pen(drvdata, data, params->size);
+	else
+		uclogic_raw_event_frame(drvdata, &drvdata->raw.frame_list[0],
+					data, params->size);
+	KUNIT_EXPECT_MEMEQ(test, data, params->expected, params->size);
+	/* The in-range timeout is only left running while the pen is in */
+	KUNIT_EXPECT_EQ(test, !!timer_pending(&drvdata->inrange_timer),
+			params->pen.inrange == UCLOGIC_PARAMS_PEN_INRANGE_NONE &&
+			(params->expected[1] & 0x40));
+	del_timer_sync(&drvdata->inrange_timer);
+}
+
+#define FRAME_REPORT_SIZE 12
+
+/*
+ * Reference frame report handling, as done before the rewrite programs and
+ * their lookup tables, to compare them against.
+ */
+static void uclogic_raw_event_frame_ref(const struct uclogic_params_frame *frame,
+					u8 *re_state, u8 *data, int size)
+{
+	if (frame->dev_id_byte > 0 && frame->dev_id_byte < size) {
+		if (frame->touch_byte > 0 && frame->touch_byte < size &&
+		    data[frame->touch_byte] == 0) {
+			data[frame->dev_id_byte] = 0;
+		} else {
+			data[frame->dev_id_byte] = 0xf;
+		}
+	}
+
+	if (frame->re_lsb > 0 && frame->re_lsb / 8 < size) {
+		unsigned int byte = frame->re_lsb / 8;
+		unsigned int bit = frame->re_lsb % 8;
+		u8 change;
+		u8 prev_state = *re_state;
+		u8 state = (data[byte] >> bit) & 0x3;
+
+		if ((prev_state == 1 && state == 0) ||
+		    (prev_state == 2 && state == 3)) {
+			change = 1;
+		} else if ((prev_state == 2 && state == 0) ||
+			   (prev_state == 1 && state == 3)) {
+			change = 3;
+		} else {
+			change = 0;
+		}
+		data[byte] = (data[byte] & ~((u8)3 << bit)) | (change << bit);
+		*re_state = state;
+	}
+
+	if (frame->touch_byte > 0 && frame->touch_byte < size) {
+		__s8 value = data[frame->touch_byte];
+
+		if (value != 0) {
+			if (frame->touch_flip_at != 0) {
+				value = frame->touch_flip_at - value;
+				if (value <= 0)
+					value = frame->touch_max + value;
+			}
+			data[frame->touch_byte] = value - 1;
+		}
+	}
+
+	if (frame->bitmap_dial_byte > 0 && frame->bitmap_dial_byte < size) {
+		if (data[frame->bitmap_dial_byte] == 2)
+			data[frame->bitmap_dial_byte] = -1;
+	}
+}
+
+struct uclogic_raw_frame_lut_test {
+	const char *name;
+	struct uclogic_params_frame frame;
+};
+
+static struct uclogic_raw_frame_lut_test raw_frame_lut_tests[] = {
+	{
+		.name = "v2_touch_ring",
+		.frame = {
+			.id = UCLOGIC_RDESC_V2_FRAME_TOUCH_ID,
+			.dev_id_byte = UCLOGIC_RDESC_V2_FRAME_TOUCH_DEV_ID_BYTE,
+			.touch_byte = 5,
+			.touch_max = 12,
+			.touch_flip_at = 7,
+		},
+	},
+	{
+		.name = "v2_touch_strip",
+		.frame = {
+			.id = UCLOGIC_RDESC_V2_FRAME_TOUCH_ID,
+			.dev_id_byte = UCLOGIC_RDESC_V2_FRAME_TOUCH_DEV_ID_BYTE,
+			.touch_byte = 5,
+			.touch_max = 8,
+		},
+	},
+	{
+		.name = "v2_dial",
+		.frame = {
+			.id = UCLOGIC_RDESC_V2_FRAME_DIAL_ID,
+			.dev_id_byte = UCLOGIC_RDESC_V2_FRAME_DIAL_DEV_ID_BYTE,
+			.bitmap_dial_byte = 5,
+		},
+	},
+	{
+		.name = "ugee_v2_bitmap_dial",
+		.frame = {
+			.id = UCLOGIC_RDESC_V1_FRAME_ID,
+			.bitmap_dial_byte = 7,
+		},
+	},
+	{
+		.name = "ugee_g5_encoder",
+		.frame = {
+			.id = UCLOGIC_RDESC_UGEE_G5_FRAME_ID,
+			.re_lsb = UCLOGIC_RDESC_UGEE_G5_FRAME_RE_LSB,
+			.dev_id_byte = UCLOGIC_RDESC_UGEE_G5_FRAME_DEV_ID_BYTE,
+		},
+	},
+	{
+		.name = "encoder_low_bits",
+		.frame = {
+			.id = UCLOGIC_RDESC_V1_FRAME_ID,
+			.re_lsb = 8,
+		},
+	},
+	{
+		.name = "encoder_high_bits",
+		.frame = {
+			.id = UCLOGIC_RDESC_V1_FRAME_ID,
+			.re_lsb = 8 * (FRAME_REPORT_SIZE - 1) + 6,
+		},
+	},
+};
+
+static void uclogic_raw_frame_lut_test_desc(
+			const struct uclogic_raw_frame_lut_test *t, char *desc)
+{
+	strscpy(desc, t->name, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(uclogic_raw_frame_lut, raw_frame_lut_tests,
+		  uclogic_raw_frame_lut_test_desc);
+
+static void hid_test_uclogic_raw_frame_lut_test(struct kunit *test)
+{
+	const struct uclogic_raw_frame_lut_test *params = test->param_value;
+	const struct uclogic_params_frame *frame = &params->frame;
+	struct uclogic_drvdata *drvdata;
+	u8 data[FRAME_REPORT_SIZE];
+	u8 expected[FRAME_REPORT_SIZE];
+	u8 initial_state, ref_state;
+	unsigned int offset, prev, value;
+
+	drvdata = kunit_kzalloc(test, sizeof(*drvdata), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata);
+	drvdata->params.frame_list[0] = *frame;
+	KUNIT_ASSERT_EQ(test,
+			uclogic_params_get_raw(&drvdata->params, &drvdata->raw),
+			0);
+	initial_state = drvdata->raw.re_state;
+
+/* Handle a report both ways, and expect identical results */
+#define HANDLE_REPORT() \
+	do {                                                                \
+		memcpy(expected, data, sizeof(expected));                   \
+		uclogic_raw_event_frame_ref(frame, &ref_state, expected,    \
+					    sizeof(expected));              \
+		uclogic_raw_event_frame(drvdata,                            \
+					&drvdata->raw.frame_list[0],        \
+					data, sizeof(data));                \
+		if (memcmp(data, expected, sizeof(data)) != 0) {            \
+			KUNIT_FAIL(test,                                    \
+				   "mismatch at byte %u = 0x%02x, prev %u", \
+				   offset, value, prev);                    \
+			return;                                             \
+		}                                                           \
+	} while (0)
+
+	/*
+	 * Try every value of every byte, after every possible previous
+	 * rotary encoder state, with 4 meaning none
+	 */
+	for (offset = 1; offset < FRAME_REPORT_SIZE; offset++) {
+		for (prev = 0; prev <= 4; prev++) {
+			for (value = 0; value <= U8_MAX; value++) {
+				ref_state = U8_MAX;
+				drvdata->raw.re_state = initial_state;
+				if (prev < 4 && frame->re_lsb > 0) {
+					memset(data, 0, sizeof(data));
+					data[frame->re_lsb / 8] =
+						prev << (frame->re_lsb % 8);
+					HANDLE_REPORT();
+				}
+				memset(data, 0, sizeof(data));
+				data[0] = frame->id;
+				data[offset] = value;
+				HANDLE_REPORT();
+			}
+		}
+	}
+
+#undef HANDLE_REPORT
+}
+
+static void hid_test_uclogic_inrange_update_timeout_test(struct kunit *test)
+{
+	struct uclogic_drvdata *drvdata;
+	struct uclogic_raw *raw;
+	unsigned int n;
+
+	drvdata = kunit_kzalloc(test, sizeof(*drvdata), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata);
+	raw = &drvdata->raw;
+
+	/* Too few intervals to learn from keep the default */
+	for (n = 0; n < ARRAY_SIZE(raw->inrange_intervals) / 2 - 1; n++)
+		raw->inrange_intervals[n] = 3759398;
+	uclogic_inrange_update_timeout(drvdata);
+	KUNIT_EXPECT_EQ(test, drvdata->inrange_interval_us, 0);
+	KUNIT_EXPECT_EQ(test, raw->inrange_timeout_ms,
+			UCLOGIC_INRANGE_TIMEOUT_MS);
+
+	/* A 266 Hz tablet with a few outliers */
+	for (n = 0; n < ARRAY_SIZE(raw->inrange_intervals); n++)
+		raw->inrange_intervals[n] = 3759398;
+	raw->inrange_intervals[1] = 12000000;
+	raw->inrange_intervals[5] = 1000;
+	uclogic_inrange_update_timeout(drvdata);
+	KUNIT_EXPECT_EQ(test, drvdata->inrange_interval_us, 3759);
+	KUNIT_EXPECT_EQ(test, raw->inrange_timeout_ms,
+			DIV_ROUND_UP(3759 * UCLOGIC_INRANGE_TIMEOUT_INTERVALS,
+				     1000));
+
+	/* Very fast and very slow tablets get the timeout clamped */
+	for (n = 0; n < ARRAY_SIZE(raw->inrange_intervals); n++)
+		raw->inrange_intervals[n] = 1000000;
+	uclogic_inrange_update_timeout(drvdata);
+	KUNIT_EXPECT_EQ(test, raw->inrange_timeout_ms,
+			UCLOGIC_INRANGE_TIMEOUT_MIN_MS);
+	for (n = 0; n < ARRAY_SIZE(raw->inrange_intervals); n++)
+		raw->inrange_intervals[n] = 50000000;
+	uclogic_inrange_update_timeout(drvdata);
+	KUNIT_EXPECT_EQ(test, raw->inrange_timeout_ms,
+			UCLOGIC_INRANGE_TIMEOUT_MAX_MS);
+
+	/* The override wins, until reset */
+	drvdata->inrange_timeout_override_ms = 250;
+	uclogic_inrange_update_timeout(drvdata);
+	KUNIT_EXPECT_EQ(test, raw->inrange_timeout_ms, 250);
+	KUNIT_EXPECT_EQ(test, drvdata->inrange_interval_us, 50000);
+	drvdata->inrange_timeout_override_ms = 0;
+	uclogic_inrange_update_timeout(drvdata);
+	KUNIT_EXPECT_EQ(test, raw->inrange_timeout_ms,
+			UCLOGIC_INRANGE_TIMEOUT_MAX_MS);
+}
+
+/*
+ * Allocate and register a pen input device for the tests handling reports
+ * the way hid-input does, as only registered devices accept events.
+ */
+static struct input_dev *uclogic_test_pen_input(void)
+{
+	struct input_dev *input;
+
+	input = input_allocate_device();
+	if (input == NULL)
+		return NULL;
+	input->name = "UC-Logic test pen";
+	input_set_capability(input, EV_KEY, BTN_TOOL_PEN);
+	input_set_capability(input, EV_KEY, BTN_TOUCH);
+	input_set_abs_params(input, ABS_X, 0, U16_MAX, 0, 0);
+	input_set_abs_params(input, ABS_PRESSURE, 0, 8191, 0, 0);
+	if (input_register_device(input) != 0) {
+		input_free_device(input);
+		return NULL;
+	}
+	return input;
+}
+
+/* A tablet interface handling input reports, for the tests */
+struct uclogic_test_iface {
+	struct hid_device hdev;
+	/* An input report, with the ID to be set by the test */
+	struct hid_report report;
+	struct uclogic_drvdata drvdata;
+};
+
+/* Free what the report handling of a test interface allocated */
+static void uclogic_test_iface_cleanup(void *data)
+{
+	struct uclogic_drvdata *drvdata = data;
+
+	uclogic_params_cleanup(&drvdata->params);
+	free_percpu(drvdata->stats);
+	kvfree(drvdata->capture);
+}
+
+/*
+ * Create a tablet interface handling input reports, with the parameters
+ * set up by "init", collecting the statistics, if "stats" is true, and
+ * cleaned up at the end of the test. Returns NULL on failure.
+ */
+static struct uclogic_test_iface *uclogic_test_iface(struct kunit *test,
+				void (*init)(struct uclogic_params *params),
+				bool stats)
+{
+	struct uclogic_test_iface *iface;
+	struct uclogic_drvdata *drvdata;
+
+	iface = kunit_kzalloc(test, sizeof(*iface), GFP_KERNEL);
+	if (iface == NULL)
+		return NULL;
+	drvdata = &iface->drvdata;
+	mutex_init(&drvdata->stats_lock);
+	mutex_init(&drvdata->capture_lock);
+	if (kunit_add_action_or_reset(test, uclogic_test_iface_cleanup,
+				      drvdata) != 0)
+		return NULL;
+	init(&drvdata->params);
+	if (uclogic_params_get_raw(&drvdata->params, &drvdata->raw) != 0)
+		return NULL;
+	if (stats && uclogic_stats_enable_set(drvdata, 1) != 0)
+		return NULL;
+	sema_init(&iface->hdev.driver_input_lock, 1);
+	drvdata->hdev = &iface->hdev;
+	hid_set_drvdata(&iface->hdev, drvdata);
+	iface->report.type = HID_INPUT_REPORT;
+	return iface;
+}
+
+/* Pen 0x08, with subreport 0xf0 routed to frame 0xf7, with an encoder */
+static void uclogic_test_init_pen_frame(struct uclogic_params *params)
+{
+	params->pen.id = 0x08;
+	params->pen.subreport_list[0].value = 0xf0;
+	params->pen.subreport_list[0].id = 0xf7;
+	params->frame_list[0].id = 0xf7;
+	params->frame_list[0].re_lsb = 8;
+}
+
+static void hid_test_uclogic_stats_test(struct kunit *test)
+{
+	static const struct {
+		u8 data[2];
+		int size;
+	} reports[] = {
+		/* Pen */
+		{ { 0x08, 0x80 }, 2 },
+		/* Frame subreport, encoder state 0 */
+		{ { 0x08, 0xf0 }, 2 },
+		/* Frame, encoder state 1, clockwise to 0, 1, counterclockwise */
+		{ { 0xf7, 0x01 }, 2 },
+		{ { 0xf7, 0x00 }, 2 },
+		{ { 0xf7, 0x01 }, 2 },
+		{ { 0xf7, 0x03 }, 2 },
+		/* Short pen and frame */
+		{ { 0x08 }, 1 },
+		{ { 0xf7 }, 1 },
+		/* Unmatched */
+		{ { 0x09, 0x00 }, 2 },
+	};
+	struct uclogic_test_iface *iface;
+	struct uclogic_stats __percpu *stats;
+	unsigned long intervals = 0;
+	u8 data[2];
+	unsigned int n;
+
+	iface = uclogic_test_iface(test, uclogic_test_init_pen_frame, true);
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	stats = iface->drvdata.stats;
+
+	for (n = 0; n < ARRAY_SIZE(reports); n++) {
+		memcpy(data, reports[n].data, sizeof(data));
+		iface->report.id = data[0];
+		uclogic_raw_event(&iface->hdev, &iface->report, data,
+				  reports[n].size);
+	}
+
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, reports[0x08]), 3);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, reports[0xf7]), 5);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, reports[0x09]), 1);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, subreports[0xf7]), 1);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, unmatched), 1);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, short_reports), 2);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, hooks), 0);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, encoder_cw), 1);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, encoder_ccw), 1);
+	/* Every report but the first has an interval */
+	for (n = 0; n < UCLOGIC_STATS_INTERVALS; n++)
+		intervals += UCLOGIC_STATS_SUM(stats, intervals[n]);
+	KUNIT_EXPECT_EQ(test, intervals, ARRAY_SIZE(reports) - 1);
+}
+
+static void hid_test_uclogic_stats_enable_test(struct kunit *test)
+{
+	struct uclogic_test_iface *iface;
+	struct uclogic_drvdata *drvdata;
+	struct uclogic_stats __percpu *stats;
+	u64 val;
+
+	iface = uclogic_test_iface(test, uclogic_test_init_pen_frame, false);
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	drvdata = &iface->drvdata;
+	iface->report.id = 0x08;
+
+	/* Nothing is allocated, or timed, until enabled */
+	uclogic_raw_event(&iface->hdev, &iface->report,
+			  (u8 []){ 0x08, 0x80 }, 2);
+	KUNIT_ASSERT_EQ(test, uclogic_stats_enable_get(drvdata, &val), 0);
+	KUNIT_EXPECT_EQ(test, val, 0);
+	KUNIT_EXPECT_NULL(test, drvdata->stats);
+	KUNIT_EXPECT_EQ(test, drvdata->stats_last, 0);
+
+	KUNIT_ASSERT_EQ(test, uclogic_stats_enable_set(drvdata, 1), 0);
+	stats = drvdata->stats;
+	KUNIT_ASSERT_NOT_NULL(test, stats);
+	KUNIT_ASSERT_EQ(test, uclogic_stats_enable_get(drvdata, &val), 0);
+	KUNIT_EXPECT_EQ(test, val, 1);
+	uclogic_raw_event(&iface->hdev, &iface->report,
+			  (u8 []){ 0x08, 0x80 }, 2);
+
+	/* The statistics are kept, but not updated, once disabled */
+	KUNIT_ASSERT_EQ(test, uclogic_stats_enable_set(drvdata, 0), 0);
+	KUNIT_EXPECT_PTR_EQ(test, drvdata->stats, stats);
+	KUNIT_EXPECT_NULL(test, drvdata->stats_active);
+	uclogic_raw_event(&iface->hdev, &iface->report,
+			  (u8 []){ 0x08, 0x80 }, 2);
+	KUNIT_EXPECT_EQ(test, UCLOGIC_STATS_SUM(stats, reports[0x08]), 1);
+}
+
+static void hid_test_uclogic_capture_test(struct kunit *test)
+{
+	struct uclogic_test_iface *iface;
+	struct uclogic_drvdata *drvdata;
+	struct hid_device *hdev;
+	struct hid_report *report;
+	struct uclogic_capture *capture;
+	char line[UCLOGIC_CAPTURE_LINE_MAX];
+	u8 data[3];
+	unsigned int n;
+	u64 val;
+	int len;
+
+	iface = uclogic_test_iface(test, uclogic_test_init_pen_frame, false);
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	drvdata = &iface->drvdata;
+	hdev = &iface->hdev;
+	report = &iface->report;
+	report->id = 0x08;
+
+	/* Nothing is captured until enabled */
+	uclogic_raw_event(hdev, report, (u8 []){ 0x08, 0xf0, 0x00 }, 3);
+	KUNIT_ASSERT_EQ(test, uclogic_capture_enable_get(drvdata, &val), 0);
+	KUNIT_EXPECT_EQ(test, val, 0);
+	KUNIT_ASSERT_EQ(test, uclogic_capture_enable_set(drvdata, 1), 0);
+	KUNIT_ASSERT_EQ(test, uclogic_capture_enable_get(drvdata, &val), 0);
+	KUNIT_EXPECT_EQ(test, val, 1);
+	capture = drvdata->capture;
+	KUNIT_ASSERT_NOT_NULL(test, capture);
+	KUNIT_EXPECT_EQ(test, capture->head, 0);
+
+	/* Fill the ring and then some */
+	for (n = 0; n < UCLOGIC_CAPTURE_ENTRIES + 2; n++) {
+		data[0] = 0x08;
+		data[1] = 0xf0;
+		data[2] = n;
+		uclogic_raw_event(hdev, report, data, sizeof(data));
+	}
+	KUNIT_EXPECT_EQ(test, capture->head, UCLOGIC_CAPTURE_ENTRIES);
+	KUNIT_EXPECT_EQ(test, capture->dropped, 2);
+
+	/* Both the received and the rewritten reports are captured */
+	KUNIT_EXPECT_EQ(test, capture->entries[1].size, 3);
+	KUNIT_EXPECT_MEMEQ(test, capture->entries[1].orig,
+			   ((u8 []){ 0x08, 0xf0, 0x01 }), 3);
+	KUNIT_EXPECT_MEMEQ(test, capture->entries[1].data,
+			   ((u8 []){ 0xf7, 0xf0, 0x01 }), 3);
+	len = uclogic_capture_format(&capture->entries[1], line);
+	KUNIT_ASSERT_GT(test, len, 17);
+	KUNIT_EXPECT_MEMEQ(test, line + len - 17, " 3 08f001 f7f001\n", 17);
+
+	/* The ring is reused once read */
+	smp_store_release(&capture->tail, 1);
+	uclogic_raw_event(hdev, report, (u8 []){ 0x08, 0x00, 0x00 }, 3);
+	KUNIT_EXPECT_EQ(test, capture->head, UCLOGIC_CAPTURE_ENTRIES + 1);
+	KUNIT_EXPECT_EQ(test, capture->entries[0].orig[1], 0x00);
+
+	/* Stopping keeps the ring, but stops capturing */
+	KUNIT_ASSERT_EQ(test, uclogic_capture_enable_set(drvdata, 0), 0);
+	uclogic_raw_event(hdev, report, (u8 []){ 0x08, 0x00, 0x00 }, 3);
+	KUNIT_EXPECT_PTR_EQ(test, drvdata->capture, capture);
+	KUNIT_EXPECT_EQ(test, capture->dropped, 2);
+}
+
+/* Number of pen reports the stress test delivers between pen-outs */
+#define UCLOGIC_INRANGE_STRESS_BURST	64
+
+/*
+ * State of the in-range stress test, with an input handler receiving the
+ * frames delivered by the pen input device.
+ */
+struct uclogic_inrange_stress {
+	struct input_handler handler;
+	struct input_handle handle;
+	struct uclogic_drvdata *drvdata;
+	struct hid_report report;
+	/* Pen reports delivered by the report thread */
+	unsigned long reports;
+	/* Pen report frames received */
+	unsigned long report_frames;
+	/* Pen-out frames received */
+	unsigned long out_frames;
+	/* Frames mixing a pen report with a pen-out */
+	unsigned long mixed_frames;
+	/* Pen report frames received with the pen out of range after them */
+	unsigned long out_reports;
+	/* True if the frame being received has a pen report */
+	bool frame_report;
+	/* True if the frame being received has a pen-out */
+	bool frame_out;
+	/* True if the pen is in range after the received frames */
+	bool inrange;
+};
+
+static void uclogic_inrange_stress_event(struct input_handle *handle,
+					 unsigned int type, unsigned int code,
+					 int value)
+{
+	struct uclogic_inrange_stress *s = handle->private;
+
+	/* Each pen report moves the pen, and only the pen-out drops it */
+	if (type == EV_ABS && code == ABS_X) {
+		s->frame_report = true;
+	} else if (type == EV_KEY && code == BTN_TOOL_PEN) {
+		s->inrange = value;
+		if (!value)
+			s->frame_out = true;
+	} else if (type == EV_SYN && code == SYN_REPORT) {
+		if (s->frame_report && s->frame_out)
+			s->mixed_frames++;
+		else if (s->frame_report)
+			s->report_frames++;
+		else if (s->frame_out)
+			s->out_frames++;
+		if (s->frame_report && !s->inrange)
+			s->out_reports++;
+		s->frame_report = false;
+		s->frame_out = false;
+	}
+}
+
+static int uclogic_inrange_stress_connect(struct input_handler *handler,
+					  struct input_dev *dev,
+					  const struct input_device_id *id)
+{
+	struct uclogic_inrange_stress *s = handler->private;
+	int rc;
+
+	if (dev != s->drvdata->pen_input)
+		return -ENODEV;
+	s->handle.dev = dev;
+	s->handle.handler = handler;
+	s->handle.name = handler->name;
+	s->handle.private = s;
+	rc = input_register_handle(&s->handle);
+	if (rc != 0)
+		return rc;
+	rc = input_open_device(&s->handle);
+	if (rc != 0)
+		input_unregister_handle(&s->handle);
+	return rc;
+}
+
+static void uclogic_inrange_stress_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+}
+
+static const struct input_device_id uclogic_inrange_stress_ids[] = {
+	/* Match all, the connect callback picks the pen */
+	{ .driver_info = 1 },
+	{ },
+};
+
+/* Deliver pen reports back to back, the way HID core and hid-input do */
+static int uclogic_inrange_stress_report(void *data)
+{
+	struct uclogic_inrange_stress *s = data;
+	struct uclogic_drvdata *drvdata = s->drvdata;
+	struct input_dev *input = drvdata->pen_input;
+	u8 report[] = { 0x08, 0x81, 0x11, 0x22 };
+	unsigned long out_frames;
+	unsigned int i;
+
+	while (!kthread_should_stop()) {
+		uclogic_raw_event(drvdata->hdev, &s->report, report,
+				  sizeof(report));
+		/* Report the fields, giving the timer a chance to cut in */
+		input_report_abs(input, ABS_X, s->reports % U16_MAX + 1);
+		cond_resched();
+		input_report_abs(input, ABS_PRESSURE, 1);
+		cond_resched();
+		input_report_key(input, BTN_TOOL_PEN, report[1] & 0x40);
+		cond_resched();
+		uclogic_report(drvdata->hdev, &s->report);
+		input_sync(input);
+		/* Let the pen go out of range now and then */
+		if (++s->reports % UCLOGIC_INRANGE_STRESS_BURST != 0)
+			continue;
+		out_frames = READ_ONCE(s->out_frames);
+		for (i = 0; i < 1000 && READ_ONCE(s->out_frames) == out_frames &&
+			    !kthread_should_stop(); i++)
+			cond_resched();
+	}
+	return 0;
+}
+
+/* Expire the in-range timer as soon as it's started, racing the reports */
+static int uclogic_inrange_stress_timer(void *data)
+{
+	struct uclogic_inrange_stress *s = data;
+	struct uclogic_drvdata *drvdata = s->drvdata;
+
+	while (!kthread_should_stop()) {
+		if (del_timer(&drvdata->inrange_timer))
+			uclogic_inrange_timeout(&drvdata->inrange_timer);
+		cond_resched();
+	}
+	return 0;
+}
+
+static void hid_test_uclogic_inrange_stress_test(struct kunit *test)
+{
+	struct uclogic_inrange_stress *s;
+	struct uclogic_drvdata *drvdata;
+	struct task_struct *report_task;
+	struct task_struct *timer_task;
+	int rc;
+
+	s = kunit_kzalloc(test, sizeof(*s), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, s);
+	drvdata = kunit_kzalloc(test, sizeof(*drvdata), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata);
+	drvdata->hdev = kunit_kzalloc(test, sizeof(*drvdata->hdev),
+				      GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata->hdev);
+	hid_set_drvdata(drvdata->hdev, drvdata);
+	drvdata->params.pen.id = 0x08;
+	drvdata->params.pen.inrange = UCLOGIC_PARAMS_PEN_INRANGE_NONE;
+	KUNIT_ASSERT_EQ(test,
+			uclogic_params_get_raw(&drvdata->params, &drvdata->raw),
+			0);
+	/* Only let the timer expire in the timer thread */
+	drvdata->inrange_timeout_override_ms =
+		UCLOGIC_INRANGE_TIMEOUT_OVERRIDE_MAX_MS;
+	uclogic_inrange_update_timeout(drvdata);
+	timer_setup(&drvdata->inrange_timer, uclogic_inrange_timeout, 0);
+	drvdata->pen_input = uclogic_test_pen_input();
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata->pen_input);
+	s->drvdata = drvdata;
+	s->report.type = HID_INPUT_REPORT;
+	s->report.id = 0x08;
+	s->handler.private = s;
+	s->handler.event = uclogic_inrange_stress_event;
+	s->handler.connect = uclogic_inrange_stress_connect;
+	s->handler.disconnect = uclogic_inrange_stress_disconnect;
+	s->handler.name = "uclogic_stress";
+	s->handler.id_table = uclogic_inrange_stress_ids;
+	rc = input_register_handler(&s->handler);
+	if (rc != 0)
+		input_unregister_device(drvdata->pen_input);
+	KUNIT_ASSERT_EQ(test, rc, 0);
+
+	report_task = kthread_run(uclogic_inrange_stress_report, s,
+				  "uclogic_stress_report");
+	timer_task = IS_ERR(report_task) ? report_task :
+		kthread_run(uclogic_inrange_stress_timer, s,
+			    "uclogic_stress_timer");
+	if (!IS_ERR(timer_task)) {
+		msleep(500);
+		kthread_stop(timer_task);
+	}
+	if (!IS_ERR(report_task))
+		kthread_stop(report_task);
+	del_timer_sync(&drvdata->inrange_timer);
+	input_unregister_handler(&s->handler);
+	input_unregister_device(drvdata->pen_input);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(timer_task));
+
+	kunit_info(test, "%lu reports, %lu report frames, %lu pen-out frames\n",
+		   s->reports, s->report_frames, s->out_frames);
+	/*
+	 * Both paths ran, every report was delivered in a frame of its own,
+	 * with the pen in range, and the pen-outs only came between them
+	 */
+	KUNIT_EXPECT_GT(test, s->reports, 0);
+	KUNIT_EXPECT_GT(test, s->out_frames, 0);
+	KUNIT_EXPECT_EQ(test, s->mixed_frames, 0);
+	KUNIT_EXPECT_EQ(test, s->report_frames, s->reports);
+	KUNIT_EXPECT_EQ(test, s->out_reports, 0);
+}
+
+#include "./hid-uclogic-core-test-corpus.h"
+
+static void uclogic_replay_model_desc(const struct uclogic_replay_model *m,
+				      char *desc)
+{
+	strscpy(desc, m->name, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(uclogic_replay, uclogic_replay_models,
+		  uclogic_replay_model_desc);
+
+static void hid_test_uclogic_replay_test(struct kunit *test)
+{
+	const struct uclogic_replay_model *model = test->param_value;
+	const struct uclogic_replay_step *step;
+	struct uclogic_test_iface *iface;
+	struct uclogic_drvdata *drvdata;
+	struct uclogic_stats __percpu *stats;
+	struct hid_device *hdev;
+	struct hid_report *report;
+	struct input_dev *input;
+	__u8 data[UCLOGIC_REPLAY_REPORT_MAX];
+	unsigned long pen_outs;
+	unsigned long timeouts;
+	unsigned int reports = 0;
+	unsigned int n, i;
+	u64 elapsed = 0;
+	u64 start;
+
+	iface = uclogic_test_iface(test, model->init, true);
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	drvdata = &iface->drvdata;
+	stats = drvdata->stats;
+	hdev = &iface->hdev;
+	report = &iface->report;
+	/* Only let the timer expire when the sequence says so */
+	drvdata->inrange_timeout_override_ms =
+		UCLOGIC_INRANGE_TIMEOUT_OVERRIDE_MAX_MS;
+	uclogic_inrange_update_timeout(drvdata);
+	timer_setup(&drvdata->inrange_timer, uclogic_inrange_timeout, 0);
+	input = uclogic_test_pen_input();
+	KUNIT_ASSERT_NOT_NULL(test, input);
+	drvdata->pen_input = input;
+
+	for (n = 0; n < model->num_steps; n++) {
+		step = &model->steps[n];
+		if (step->size == 0) {
+			pen_outs = UCLOGIC_STATS_SUM(stats, pen_outs);
+			timeouts = UCLOGIC_STATS_SUM(stats, inrange_timeouts);
+			/* Expire the timer, including after it restarts */
+			for (i = 0; i < 3 &&
+				    del_timer(&drvdata->inrange_timer); i++)
+				uclogic_inrange_timeout(&drvdata->inrange_timer);
+			KUNIT_EXPECT_EQ_MSG(test,
+				UCLOGIC_STATS_SUM(stats, pen_outs) - pen_outs,
+				step->pen_out ? 1 : 0, "step %u", n);
+			if (step->pen_out) {
+				KUNIT_EXPECT_FALSE_MSG(test,
+					test_bit(BTN_TOOL_PEN, input->key),
+					"step %u", n);
+				KUNIT_EXPECT_GT_MSG(test,
+					UCLOGIC_STATS_SUM(stats,
+							  inrange_timeouts) -
+						timeouts,
+					0, "step %u", n);
+			}
+			continue;
+		}
+
+		memcpy(data, step->report, step->size);
+		report->id = data[0];
+		/* Handle the report like HID core and hid-input do */
+		down(&hdev->driver_input_lock);
+		start = ktime_get_ns();
+		uclogic_raw_event(hdev, report, data, step->size);
+		elapsed += ktime_get_ns() - start;
+		reports++;
+		if (data[0] == drvdata->params.pen.id)
+			input_report_key(input, BTN_TOOL_PEN, data[1] & 0x40);
+		uclogic_report(hdev, report);
+		input_sync(input);
+		up(&hdev->driver_input_lock);
+		KUNIT_EXPECT_MEMEQ_MSG(test, data, step->expected, step->size,
+				       "step %u", n);
+	}
+
+	del_timer_sync(&drvdata->inrange_timer);
+	input_unregister_device(input);
+
+	if (reports != 0)
+		kunit_info(test, "%u reports, %llu ns per report\n", reports,
+			   div_u64(elapsed, reports));
+}
+
+/* Number of reports to time for each benchmark shape */
+#define UCLOGIC_BENCH_REPORTS	(1 << 20)
+/* Number of reports to time between rescheduling points */
+#define UCLOGIC_BENCH_BATCH	4096
+
+static void uclogic_bench_shape_desc(const struct uclogic_bench_shape *shape,
+				     char *desc)
+{
+	strscpy(desc, shape->name, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(uclogic_bench, uclogic_bench_shapes,
+		  uclogic_bench_shape_desc);
+
+/*
+ * Time uclogic_raw_event() over many copies of a report, and print the
+ * result as a "uclogic_bench" line of space-separated key=value pairs.
+ * The report is copied before each call, like HID core passes each report
+ * in a fresh buffer, and the copy is included in the time. The cycles are
+ * zero on architectures without a cycle counter, such as UML.
+ */
+static void uclogic_bench_run(struct kunit *test,
+			      const struct uclogic_bench_shape *shape,
+			      struct hid_device *hdev,
+			      struct hid_report *report)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+	__u8 data[UCLOGIC_REPLAY_REPORT_MAX];
+	unsigned int n, i;
+	u64 ns = 0;
+	u64 cycles = 0;
+	u64 start_ns;
+	cycles_t start_cycles;
+
+	for (n = 0; n < UCLOGIC_BENCH_REPORTS; n += UCLOGIC_BENCH_BATCH) {
+		start_ns = ktime_get_ns();
+		start_cycles = get_cycles();
+		for (i = 0; i < UCLOGIC_BENCH_BATCH; i++) {
+			memcpy(data, shape->report, shape->size);
+			uclogic_raw_event(hdev, report, data, shape->size);
+		}
+		cycles += get_cycles() - start_cycles;
+		ns += ktime_get_ns() - start_ns;
+		cond_resched();
+	}
+
+	kunit_info(test,
+		   "uclogic_bench shape=%s stats=%d reports=%u ns=%llu ns_per_report=%llu.%03llu cycles_per_report=%llu\n",
+		   shape->name, drvdata->stats_active != NULL,
+		   UCLOGIC_BENCH_REPORTS, ns,
+		   div_u64(ns, UCLOGIC_BENCH_REPORTS),
+		   div_u64((ns % UCLOGIC_BENCH_REPORTS) * 1000,
+			   UCLOGIC_BENCH_REPORTS),
+		   div_u64(cycles, UCLOGIC_BENCH_REPORTS));
+}
+
+/*
+ * Benchmark a params shape without the statistics, as configured by
+ * default, and then with them, to see what they cost.
+ */
+static void hid_test_uclogic_bench_test(struct kunit *test)
+{
+	const struct uclogic_bench_shape *shape = test->param_value;
+	struct uclogic_drvdata *drvdata;
+	struct uclogic_stats __percpu *stats;
+	struct hid_device *hdev;
+	struct hid_report *report;
+	int rc;
+
+	drvdata = kunit_kzalloc(test, sizeof(*drvdata), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, drvdata);
+	hdev = kunit_kzalloc(test, sizeof(*hdev), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, hdev);
+	report = kunit_kzalloc(test, sizeof(*report), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, report);
+	rc = uclogic_bench_shape_init(shape, &drvdata->params, fake_work);
+	if (rc == 0)
+		rc = uclogic_params_get_raw(&drvdata->params, &drvdata->raw);
+	stats = rc == 0 ? alloc_percpu(struct uclogic_stats) : NULL;
+	if (stats == NULL)
+		uclogic_params_cleanup(&drvdata->params);
+	KUNIT_ASSERT_EQ(test, rc, 0);
+	KUNIT_ASSERT_NOT_NULL(test, stats);
+	drvdata->hdev = hdev;
+	hid_set_drvdata(hdev, drvdata);
+	uclogic_inrange_update_timeout(drvdata);
+	timer_setup(&drvdata->inrange_timer, uclogic_inrange_timeout, 0);
+	report->type = HID_INPUT_REPORT;
+	report->id = shape->report[0];
+
+	uclogic_bench_run(test, shape, hdev, report);
+	drvdata->stats_active = stats;
+	uclogic_bench_run(test, shape, hdev, report);
+
+	del_timer_sync(&drvdata->inrange_timer);
+	uclogic_params_cleanup(&drvdata->params);
+	KUNIT_EXPECT_EQ(test,
+			UCLOGIC_STATS_SUM(stats, reports[report->id]),
+			UCLOGIC_BENCH_REPORTS);
+	free_percpu(stats);
 }
 
 static struct kunit_case hid_uclogic_core_test_cases[] = {
 	KUNIT_CASE(hid_test_uclogic_exec_event_hook_test),
+	KUNIT_CASE(hid_test_uclogic_exec_event_hook_masked_test),
+	KUNIT_CASE(hid_test_uclogic_match_event_hook_order_test),
+	KUNIT_CASE(hid_test_uclogic_match_event_hook_many_test),
+	KUNIT_CASE_PARAM(hid_test_uclogic_raw_prog_test,
+			 uclogic_raw_prog_gen_params),
+	KUNIT_CASE_PARAM(hid_test_uclogic_raw_frame_lut_test,
+			 uclogic_raw_frame_lut_gen_params),
+	KUNIT_CASE(hid_test_uclogic_inrange_update_timeout_test),
+	KUNIT_CASE(hid_test_uclogic_stats_test),
+	KUNIT_CASE(hid_test_uclogic_stats_enable_test),
+	KUNIT_CASE(hid_test_uclogic_capture_test),
+	KUNIT_CASE_SLOW(hid_test_uclogic_inrange_stress_test),
 	{}
 };
 
@@ -105,7 +1320,36 @@ static struct kunit_suite hid_uclogic_core_test_suite = {
 	.test_cases = hid_uclogic_core_test_cases,
 };
 
+static struct kunit_case hid_uclogic_replay_test_cases[] = {
+	KUNIT_CASE_PARAM(hid_test_uclogic_replay_test,
+			 uclogic_replay_gen_params),
+	{}
+};
+
+static struct kunit_suite hid_uclogic_replay_test_suite = {
+	.name = "hid_uclogic_replay_test",
+	.test_cases = hid_uclogic_replay_test_cases,
+};
+
+static struct kunit_case hid_uclogic_bench_test_cases[] = {
+	KUNIT_CASE_PARAM_ATTR(hid_test_uclogic_bench_test,
+			      uclogic_bench_gen_params,
+			      { .speed = KUNIT_SPEED_SLOW }),
+	{}
+};
+
+/*
+ * Benchmark the report handling. Slow, skip with kunit.py's
+ * --filter "speed>slow", or run alone with "hid_uclogic_bench".
+ */
+static struct kunit_suite hid_uclogic_bench_test_suite = {
+	.name = "hid_uclogic_bench",
+	.test_cases = hid_uclogic_bench_test_cases,
+};
+
 kunit_test_suite(hid_uclogic_core_test_suite);
+kunit_test_suite(hid_uclogic_replay_test_suite);
+kunit_test_suite(hid_uclogic_bench_test_suite);
 
 MODULE_DESCRIPTION("KUnit tests for the UC-Logic driver");
 MODULE_LICENSE("GPL");
@@ -13,10 +13,18 @@
  * any later version.
  */
 
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/hid.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
+#include <linux/sysfs.h>
 #include <linux/timer.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
 #include "usbhid/usbhid.h"
 #include "hid-uclogic-params.h"
 
@@ -25,10 +33,171 @@
 #include "compat.h"
 #include <linux/version.h>
 
+#define CREATE_TRACE_POINTS
+#include "hid-uclogic-trace.h"
+
+/*
+ * Time without pen reports to emulate pen going out of range after, ms,
+ * until the report interval is learned
+ */
+#define UCLOGIC_INRANGE_TIMEOUT_MS		100
+/* Learned pen in-range timeout, as the number of median report intervals */
+#define UCLOGIC_INRANGE_TIMEOUT_INTERVALS	8
+/* Minimum learned pen in-range timeout, ms */
+#define UCLOGIC_INRANGE_TIMEOUT_MIN_MS		20
+/* Maximum learned pen in-range timeout, and report interval, ms */
+#define UCLOGIC_INRANGE_TIMEOUT_MAX_MS		100
+/* Maximum pen in-range timeout set by the user, ms */
+#define UCLOGIC_INRANGE_TIMEOUT_OVERRIDE_MAX_MS	10000
+
+/*
+ * Bind to virtual tablets too, i.e. ones not attached via USB, taking their
+ * parameters from the handshake instead of the USB descriptors
+ */
+static bool uclogic_virtual;
+module_param_named(virtual, uclogic_virtual, bool, 0644);
+MODULE_PARM_DESC(virtual,
+		 "Bind to tablets not attached via USB, e.g. created with uhid, getting their parameters with a feature report handshake");
+
+#ifdef CONFIG_PM
+/*
+ * Re-enable tablets on resume by replaying the transfers which enabled them
+ * on probe, instead of discovering their parameters again
+ */
+static bool uclogic_quick_resume = true;
+module_param_named(quick_resume, uclogic_quick_resume, bool, 0644);
+MODULE_PARM_DESC(quick_resume,
+		 "Replay the enabling transfers on resume, discovering the parameters again only if the tablet answers them differently");
+#endif
+
+/*
+ * Time a probe or resume may spend talking to a tablet before giving up,
+ * ms, zero for no limit
+ */
+static unsigned int uclogic_probe_budget_ms = 4000;
+module_param_named(probe_budget_ms, uclogic_probe_budget_ms, uint, 0644);
+MODULE_PARM_DESC(probe_budget_ms,
+		 "Time a probe or resume may spend talking to a tablet, ms, 0 for no limit");
+
+/* Timeout of control transfers to tablets, ms, zero for the USB default */
+static unsigned int uclogic_ctrl_timeout_ms = 1000;
+module_param_named(ctrl_timeout_ms, uclogic_ctrl_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(ctrl_timeout_ms,
+		 "Timeout of control transfers to tablets, ms, 0 for the USB default");
+
+/* Timeout of interrupt transfers to tablets, ms, zero for the default */
+static unsigned int uclogic_intr_timeout_ms = 500;
+module_param_named(intr_timeout_ms, uclogic_intr_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(intr_timeout_ms,
+		 "Timeout of interrupt transfers to tablets, ms, 0 for the default of 1000");
+
+/* Number of times to retry a transfer to a tablet failing transiently */
+static unsigned int uclogic_xfer_retries = 2;
+module_param_named(xfer_retries, uclogic_xfer_retries, uint, 0644);
+MODULE_PARM_DESC(xfer_retries,
+		 "Number of times to retry a transfer to a tablet which timed out or failed with a protocol error, within the probe budget");
+
+static int uclogic_params_cache_param_set(const char *val,
+					  const struct kernel_param *kp)
+{
+	return uclogic_params_cache_set(val);
+}
+
+static int uclogic_params_cache_param_get(char *buf,
+					  const struct kernel_param *kp)
+{
+	return uclogic_params_cache_show(buf, PAGE_SIZE);
+}
+
+static const struct kernel_param_ops uclogic_params_cache_param_ops = {
+	.set = uclogic_params_cache_param_set,
+	.get = uclogic_params_cache_param_get,
+};
+
+/*
+ * Parameters learned from tablets on probe, reused when they're plugged
+ * again, and seeded by the user, e.g. for all their tablets at boot
+ */
+module_param_cb(params_cache, &uclogic_params_cache_param_ops, NULL, 0644);
+MODULE_PARM_DESC(params_cache,
+		 "Cached tablet parameters, one \"VENDOR:PRODUCT:INTERFACE:DATA:FIRMWARE\" per line when read, with IDs and DATA in hex, and FIRMWARE being the product string. Write entries separated by commas or newlines to add them, or an empty string to clear");
+
+/* Increment a report handling statistics counter, if collected */
+#define UCLOGIC_STATS_INC(_drvdata, _field) \
+	do { \
+		struct uclogic_stats __percpu *__stats = \
+			READ_ONCE((_drvdata)->stats_active); \
+		if (__stats) \
+			this_cpu_inc(__stats->_field); \
+	} while (0)
+
+static int uclogic_cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a;
+	u32 y = *(const u32 *)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * uclogic_inrange_update_timeout - update the pen in-range timeout from
+ * the recently measured pen report intervals, or the user override.
+ *
+ * @drvdata:	Driver data.
+ */
+static void uclogic_inrange_update_timeout(struct uclogic_drvdata *drvdata)
+{
+	struct uclogic_raw *raw = &drvdata->raw;
+	u32 intervals[ARRAY_SIZE(raw->inrange_intervals)];
+	unsigned int num = 0;
+	unsigned int i;
+	unsigned int interval_us;
+	unsigned int timeout_ms;
+
+	/* Take the median of the recorded intervals, if there's enough */
+	for (i = 0; i < ARRAY_SIZE(intervals); i++) {
+		intervals[num] = READ_ONCE(raw->inrange_intervals[i]);
+		if (intervals[num] != 0)
+			num++;
+	}
+	if (num >= ARRAY_SIZE(intervals) / 2) {
+		sort(intervals, num, sizeof(intervals[0]), uclogic_cmp_u32,
+		     NULL);
+		WRITE_ONCE(drvdata->inrange_interval_us,
+			   intervals[num / 2] / NSEC_PER_USEC);
+	}
+
+	interval_us = READ_ONCE(drvdata->inrange_interval_us);
+	timeout_ms = READ_ONCE(drvdata->inrange_timeout_override_ms);
+	if (timeout_ms == 0 && interval_us != 0) {
+		timeout_ms = clamp_t(unsigned int,
+				     DIV_ROUND_UP(interval_us *
+					UCLOGIC_INRANGE_TIMEOUT_INTERVALS,
+					USEC_PER_MSEC),
+				     UCLOGIC_INRANGE_TIMEOUT_MIN_MS,
+				     UCLOGIC_INRANGE_TIMEOUT_MAX_MS);
+	} else if (timeout_ms == 0) {
+		timeout_ms = UCLOGIC_INRANGE_TIMEOUT_MS;
+	}
+	WRITE_ONCE(raw->inrange_timeout_ms, timeout_ms);
+}
+
 /**
  * uclogic_inrange_timeout - handle pen in-range state timeout.
  * Emulate input events normally generated when pen goes out of range for
- * tablets which don't report that.
+ * tablets which don't report that. The timer is not restarted for every
+ * pen report, so restart it instead, if there were pen reports since it
+ * was started.
+ *
+ * The pen is handed off between the reports and the timer without locking,
+ * through the "inrange_state" atomic word: each pen report increments it
+ * and sets UCLOGIC_INRANGE_REPORT in the raw event, and clears the flag in
+ * the report callback, once its events are delivered. The timer claims
+ * the pen-out by setting UCLOGIC_INRANGE_OUT, only if the word still
+ * matches the snapshot taken when the timer (re)started, i.e. no pen
+ * report arrived, or is being delivered. A report arriving during the
+ * pen-out waits for the flag to clear, before its events are delivered,
+ * so the two never mix in one input frame.
  *
  * @t:	The timer the timeout handler is attached to, stored in a struct
  *	uclogic_drvdata.
@@ -37,10 +206,44 @@ static void uclogic_inrange_timeout(struct timer_list *t)
 {
 	struct uclogic_drvdata *drvdata = from_timer(drvdata, t,
 							inrange_timer);
+	struct uclogic_raw *raw = &drvdata->raw;
 	struct input_dev *input = drvdata->pen_input;
+	unsigned long flags;
+	u64 elapsed;
+	u64 timeout;
+	int state;
 
 	if (input == NULL)
 		return;
+	UCLOGIC_STATS_INC(drvdata, inrange_timeouts);
+	uclogic_inrange_update_timeout(drvdata);
+	/*
+	 * Claim the pen-out with interrupts disabled, so a report waiting
+	 * for it can't interrupt it
+	 */
+	local_irq_save(flags);
+	state = atomic_read(&raw->inrange_state);
+	if (state != READ_ONCE(raw->inrange_timer_state) ||
+	    atomic_cmpxchg(&raw->inrange_state, state,
+			   state | UCLOGIC_INRANGE_OUT) != state) {
+		local_irq_restore(flags);
+		/* There were pen reports since the timer started, wait more */
+		WRITE_ONCE(raw->inrange_timer_state,
+			   atomic_read(&raw->inrange_state) &
+				~UCLOGIC_INRANGE_REPORT);
+		elapsed = ktime_get_ns() - READ_ONCE(raw->inrange_last);
+		timeout = (u64)raw->inrange_timeout_ms * NSEC_PER_MSEC;
+		mod_timer(&drvdata->inrange_timer,
+			  jiffies + max_t(unsigned long,
+					  elapsed < timeout ?
+						nsecs_to_jiffies(timeout -
+								 elapsed) : 0,
+					  1));
+		trace_uclogic_inrange_timeout(
+			drvdata->hdev, UCLOGIC_TRACE_INRANGE_RESTART,
+			raw->inrange_timeout_ms, elapsed);
+		return;
+	}
 	input_report_abs(input, ABS_PRESSURE, 0);
 	/* If BTN_TOUCH state is changing */
 	if (test_bit(BTN_TOUCH, input->key)) {
@@ -51,6 +254,69 @@ static void uclogic_inrange_timeout(struct timer_list *t)
 	}
 	input_report_key(input, BTN_TOOL_PEN, 0);
 	input_sync(input);
+	/* Let the reports through */
+	atomic_sub(UCLOGIC_INRANGE_OUT, &raw->inrange_state);
+	local_irq_restore(flags);
+	UCLOGIC_STATS_INC(drvdata, pen_outs);
+	if (trace_uclogic_inrange_timeout_enabled())
+		trace_uclogic_inrange_timeout(
+			drvdata->hdev, UCLOGIC_TRACE_INRANGE_OUT,
+			raw->inrange_timeout_ms,
+			ktime_get_ns() - READ_ONCE(raw->inrange_last));
+}
+
+/**
+ * uclogic_inrange_report_begin - take the pen from the in-range timer for
+ * delivering a pen report, waiting for a pen-out it claimed to finish.
+ * The wait is as short as the pen-out is, and only happens if the timer
+ * expired just as the report arrived.
+ *
+ * @raw:	Raw report handling data of the interface.
+ *
+ * Returns:
+ *	The new value of the "inrange_state" of the interface.
+ */
+static int uclogic_inrange_report_begin(struct uclogic_raw *raw)
+{
+	int state = atomic_read(&raw->inrange_state);
+	int prev;
+
+	/* Only the timer can race us, as HID core serializes the reports */
+	for (;;) {
+		if (state & UCLOGIC_INRANGE_OUT) {
+			cpu_relax();
+			state = atomic_read(&raw->inrange_state);
+			continue;
+		}
+		prev = atomic_cmpxchg(&raw->inrange_state, state,
+				      (state + UCLOGIC_INRANGE_GEN) |
+					UCLOGIC_INRANGE_REPORT);
+		if (prev == state)
+			return (state + UCLOGIC_INRANGE_GEN) |
+				UCLOGIC_INRANGE_REPORT;
+		state = prev;
+	}
+}
+
+/**
+ * uclogic_report - finish delivering a report, after HID core reported
+ * all its fields. Deliver the pen report events, and hand the pen back to
+ * the in-range timer, if it was taken by uclogic_inrange_report_begin().
+ *
+ * @hdev:	The HID device the report came from.
+ * @report:	The delivered report, can have the ID changed by the raw event.
+ */
+static void uclogic_report(struct hid_device *hdev, struct hid_report *report)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+	struct uclogic_raw *raw = &drvdata->raw;
+
+	if (!(atomic_read(&raw->inrange_state) & UCLOGIC_INRANGE_REPORT))
+		return;
+	/* Sync now, before the timer can cut in, hid-input's sync is empty */
+	if (drvdata->pen_input != NULL)
+		input_sync(drvdata->pen_input);
+	atomic_sub(UCLOGIC_INRANGE_REPORT, &raw->inrange_state);
 }
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(6, 12, 0)
@@ -168,12 +434,474 @@ static int uclogic_input_configured(struct hid_device *hdev,
 #undef RETURN_SUCCESS
 
 
+static ssize_t inrange_timeout_ms_show(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	struct uclogic_drvdata *drvdata = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 READ_ONCE(drvdata->raw.inrange_timeout_ms));
+}
+
+static DEVICE_ATTR_RO(inrange_timeout_ms);
+
+static ssize_t inrange_timeout_override_ms_show(struct device *dev,
+						struct device_attribute *attr,
+						char *buf)
+{
+	struct uclogic_drvdata *drvdata = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 READ_ONCE(drvdata->inrange_timeout_override_ms));
+}
+
+static ssize_t inrange_timeout_override_ms_store(struct device *dev,
+						 struct device_attribute *attr,
+						 const char *buf, size_t count)
+{
+	struct uclogic_drvdata *drvdata = dev_get_drvdata(dev);
+	unsigned int value;
+	int rc;
+
+	rc = kstrtouint(buf, 0, &value);
+	if (rc)
+		return rc;
+	if (value > UCLOGIC_INRANGE_TIMEOUT_OVERRIDE_MAX_MS)
+		return -ERANGE;
+
+	WRITE_ONCE(drvdata->inrange_timeout_override_ms, value);
+	uclogic_inrange_update_timeout(drvdata);
+	return count;
+}
+
+static DEVICE_ATTR_RW(inrange_timeout_override_ms);
+
+static ssize_t inrange_interval_us_show(struct device *dev,
+					struct device_attribute *attr,
+					char *buf)
+{
+	struct uclogic_drvdata *drvdata = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 READ_ONCE(drvdata->inrange_interval_us));
+}
+
+static DEVICE_ATTR_RO(inrange_interval_us);
+
+static struct attribute *uclogic_attrs[] = {
+	&dev_attr_inrange_timeout_ms.attr,
+	&dev_attr_inrange_timeout_override_ms.attr,
+	&dev_attr_inrange_interval_us.attr,
+	NULL,
+};
+
+static umode_t uclogic_attr_is_visible(struct kobject *kobj,
+				       struct attribute *attr, int n)
+{
+	struct device *dev = kobj_to_dev(kobj);
+	struct uclogic_drvdata *drvdata = dev_get_drvdata(dev);
+
+	/* Only show the in-range timeout, if in-range is emulated */
+	if (drvdata->params.pen.id == 0 ||
+	    drvdata->params.pen.inrange != UCLOGIC_PARAMS_PEN_INRANGE_NONE)
+		return 0;
+
+	return attr->mode;
+}
+
+/**
+ * uclogic_stats_sum - sum a report handling statistics counter over all
+ * CPUs.
+ *
+ * @stats:	The per-CPU statistics.
+ * @offset:	Offset of the counter in struct uclogic_stats.
+ * @size:	Size of the counter, either of u32, or of unsigned long.
+ *
+ * Returns:
+ *	The counter sum.
+ */
+static unsigned long uclogic_stats_sum(struct uclogic_stats __percpu *stats,
+				       size_t offset, size_t size)
+{
+	unsigned long sum = 0;
+	const u8 *ptr;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ptr = (const u8 *)per_cpu_ptr(stats, cpu) + offset;
+		if (size == sizeof(u32))
+			sum += *(const u32 *)ptr;
+		else
+			sum += *(const unsigned long *)ptr;
+	}
+	return sum;
+}
+
+#define UCLOGIC_STATS_SUM(_stats, _field) \
+	uclogic_stats_sum(_stats, offsetof(struct uclogic_stats, _field), \
+			  sizeof(((struct uclogic_stats *)NULL)->_field))
+
+static int uclogic_stats_show(struct seq_file *m, void *v)
+{
+	struct uclogic_drvdata *drvdata = m->private;
+	struct uclogic_stats __percpu *stats;
+	unsigned long sum;
+	unsigned int i;
+
+	mutex_lock(&drvdata->stats_lock);
+	stats = drvdata->stats;
+	mutex_unlock(&drvdata->stats_lock);
+	/* Nothing to show, if never enabled */
+	if (stats == NULL)
+		return 0;
+
+	/* Only show the report IDs seen */
+	for (i = 0; i < ARRAY_SIZE(stats->reports); i++) {
+		sum = UCLOGIC_STATS_SUM(stats, reports[i]);
+		if (sum != 0)
+			seq_printf(m, "report_%02x: %lu\n", i, sum);
+	}
+	for (i = 0; i < ARRAY_SIZE(stats->subreports); i++) {
+		sum = UCLOGIC_STATS_SUM(stats, subreports[i]);
+		if (sum != 0)
+			seq_printf(m, "subreport_%02x: %lu\n", i, sum);
+	}
+	seq_printf(m, "unmatched: %lu\n", UCLOGIC_STATS_SUM(stats, unmatched));
+	seq_printf(m, "short: %lu\n",
+		   UCLOGIC_STATS_SUM(stats, short_reports));
+	seq_printf(m, "hooks: %lu\n", UCLOGIC_STATS_SUM(stats, hooks));
+	seq_printf(m, "pen_outs: %lu\n", UCLOGIC_STATS_SUM(stats, pen_outs));
+	seq_printf(m, "inrange_timeouts: %lu\n",
+		   UCLOGIC_STATS_SUM(stats, inrange_timeouts));
+	seq_printf(m, "encoder_cw: %lu\n",
+		   UCLOGIC_STATS_SUM(stats, encoder_cw));
+	seq_printf(m, "encoder_ccw: %lu\n",
+		   UCLOGIC_STATS_SUM(stats, encoder_ccw));
+	/* Name the interval buckets by their lower bound, us */
+	for (i = 0; i < ARRAY_SIZE(stats->intervals); i++)
+		seq_printf(m, "interval_us_%lu: %lu\n",
+			   i == 0 ? 0 : 1UL << (i - 1),
+			   UCLOGIC_STATS_SUM(stats, intervals[i]));
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(uclogic_stats);
+
+static int uclogic_stats_enable_get(void *data, u64 *val)
+{
+	struct uclogic_drvdata *drvdata = data;
+
+	*val = READ_ONCE(drvdata->stats_active) != NULL;
+	return 0;
+}
+
+/*
+ * Start or stop collecting the report handling statistics. They're
+ * allocated when first started, and kept until the driver is removed, so
+ * the reports being handled while stopping can still update them, and
+ * they can be read after stopping.
+ */
+static int uclogic_stats_enable_set(void *data, u64 val)
+{
+	struct uclogic_drvdata *drvdata = data;
+	int rc = 0;
+
+	mutex_lock(&drvdata->stats_lock);
+	if (val && drvdata->stats == NULL) {
+		drvdata->stats = alloc_percpu(struct uclogic_stats);
+		if (drvdata->stats == NULL) {
+			rc = -ENOMEM;
+			goto unlock;
+		}
+	}
+	/* Publish the initialized statistics to the report handling */
+	smp_store_release(&drvdata->stats_active, val ? drvdata->stats : NULL);
+unlock:
+	mutex_unlock(&drvdata->stats_lock);
+	return rc;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(uclogic_stats_enable_fops,
+			uclogic_stats_enable_get,
+			uclogic_stats_enable_set, "%llu\n");
+
+/* Maximum length of a captured report's text line time and size */
+#define UCLOGIC_CAPTURE_LINE_HEAD_MAX	48
+/* Maximum length of a captured report's text line */
+#define UCLOGIC_CAPTURE_LINE_MAX \
+	(UCLOGIC_CAPTURE_LINE_HEAD_MAX + 4 * UCLOGIC_CAPTURE_DATA_MAX + 2)
+
+/**
+ * uclogic_capture_format - format a captured report as a text line: the
+ * time in seconds, the size, and the received and the rewritten bytes in
+ * hex, separated by spaces.
+ *
+ * @entry:	The captured report.
+ * @line:	Buffer for the line, UCLOGIC_CAPTURE_LINE_MAX bytes long.
+ *
+ * Returns:
+ *	Length of the line, including the newline.
+ */
+static int uclogic_capture_format(const struct uclogic_capture_entry *entry,
+				  char *line)
+{
+	int len = clamp(entry->size, 0, UCLOGIC_CAPTURE_DATA_MAX);
+	u64 sec = entry->time;
+	u32 nsec = do_div(sec, NSEC_PER_SEC);
+	char *p = line;
+
+	p += scnprintf(p, UCLOGIC_CAPTURE_LINE_HEAD_MAX, "%llu.%09u %d ",
+		       sec, nsec, entry->size);
+	p = bin2hex(p, entry->orig, len);
+	*p++ = ' ';
+	p = bin2hex(p, entry->data, len);
+	*p++ = '\n';
+	return p - line;
+}
+
+/*
+ * Read captured reports, one per line, removing them from the ring.
+ * Report the number of reports dropped since the last read first, if any.
+ * Return what's captured so far, without waiting for more. Refuse buffers
+ * which might not fit a line, so nothing is mistaken for the end of file
+ * while reports are still captured.
+ */
+static ssize_t uclogic_capture_read(struct file *file, char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct uclogic_drvdata *drvdata = file->private_data;
+	struct uclogic_capture *capture;
+	char line[UCLOGIC_CAPTURE_LINE_MAX];
+	unsigned long dropped;
+	unsigned int head;
+	unsigned int tail;
+	size_t done = 0;
+	ssize_t rc = 0;
+	int len;
+
+	if (count < UCLOGIC_CAPTURE_LINE_MAX)
+		return -EINVAL;
+
+	mutex_lock(&drvdata->capture_lock);
+	capture = drvdata->capture;
+	if (capture == NULL)
+		goto unlock;
+
+	dropped = READ_ONCE(capture->dropped);
+	if (dropped != drvdata->capture_dropped) {
+		len = scnprintf(line, sizeof(line), "dropped %lu\n",
+				dropped - drvdata->capture_dropped);
+		if (copy_to_user(buf, line, len)) {
+			rc = -EFAULT;
+			goto unlock;
+		}
+		drvdata->capture_dropped = dropped;
+		done += len;
+	}
+
+	tail = capture->tail;
+	head = smp_load_acquire(&capture->head);
+	for (; tail != head; tail++) {
+		len = uclogic_capture_format(
+			&capture->entries[tail % UCLOGIC_CAPTURE_ENTRIES],
+			line);
+		if (len > count - done)
+			break;
+		if (copy_to_user(buf + done, line, len)) {
+			rc = -EFAULT;
+			break;
+		}
+		done += len;
+		/* Let the producer reuse the entry */
+		smp_store_release(&capture->tail, tail + 1);
+	}
+
+unlock:
+	mutex_unlock(&drvdata->capture_lock);
+	return done > 0 ? done : rc;
+}
+
+/* The captured reports are consumed by reading, so there's no position */
+static int uclogic_capture_open(struct inode *inode, struct file *file)
+{
+	file->private_data = inode->i_private;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 2, 0)
+	return nonseekable_open(inode, file);
+#else
+	return stream_open(inode, file);
+#endif
+}
+
+static const struct file_operations uclogic_capture_fops = {
+	.owner = THIS_MODULE,
+	.open = uclogic_capture_open,
+	.read = uclogic_capture_read,
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 12, 0)
+	.llseek = no_llseek,
+#endif
+};
+
+static int uclogic_capture_enable_get(void *data, u64 *val)
+{
+	struct uclogic_drvdata *drvdata = data;
+
+	*val = READ_ONCE(drvdata->capture_active) != NULL;
+	return 0;
+}
+
+/*
+ * Start or stop capturing reports. The ring is allocated when capturing is
+ * first started, and kept until the driver is removed, so the reports
+ * being handled while stopping can still finish capturing into it.
+ */
+static int uclogic_capture_enable_set(void *data, u64 val)
+{
+	struct uclogic_drvdata *drvdata = data;
+	int rc = 0;
+
+	mutex_lock(&drvdata->capture_lock);
+	if (val && drvdata->capture == NULL) {
+		drvdata->capture = kvzalloc(sizeof(*drvdata->capture),
+					    GFP_KERNEL);
+		if (drvdata->capture == NULL) {
+			rc = -ENOMEM;
+			goto unlock;
+		}
+	}
+	/* Publish the initialized ring to the report handling */
+	smp_store_release(&drvdata->capture_active,
+			  val ? drvdata->capture : NULL);
+unlock:
+	mutex_unlock(&drvdata->capture_lock);
+	return rc;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(uclogic_capture_enable_fops,
+			uclogic_capture_enable_get,
+			uclogic_capture_enable_set, "%llu\n");
+
+static const struct attribute_group uclogic_attr_group = {
+	.attrs = uclogic_attrs,
+	.is_visible = uclogic_attr_is_visible,
+};
+
+/* Probe phase names, as used in the timing debugfs file */
+static const char * const uclogic_probe_phase_names[UCLOGIC_PROBE_PHASES] = {
+	[UCLOGIC_PROBE_PHASE_STRING] = "string",
+	[UCLOGIC_PROBE_PHASE_STR_DESC] = "str_desc",
+	[UCLOGIC_PROBE_PHASE_INTERRUPT] = "interrupt",
+	[UCLOGIC_PROBE_PHASE_PARAMS] = "params",
+	[UCLOGIC_PROBE_PHASE_DESC] = "desc",
+	[UCLOGIC_PROBE_PHASE_PARSE] = "parse",
+	[UCLOGIC_PROBE_PHASE_HW_START] = "hw_start",
+	[UCLOGIC_PROBE_PHASE_TOTAL] = "total",
+};
+
+static int uclogic_probe_show(struct seq_file *m, void *v)
+{
+	struct uclogic_drvdata *drvdata = m->private;
+	unsigned int i;
+
+	seq_printf(m, "event: %s\n",
+		   drvdata->probe_resume ? "resume" : "probe");
+	for (i = 0; i < UCLOGIC_PROBE_PHASES; i++)
+		seq_printf(m, "%s_ns: %llu\n", uclogic_probe_phase_names[i],
+			   drvdata->probe_ns[i]);
+	seq_printf(m, "first_report_ns: %llu\n",
+		   READ_ONCE(drvdata->first_report_ns));
+	seq_printf(m, "retries: %u\n", drvdata->probe_retries);
+	seq_printf(m, "over_budget: %d\n", drvdata->probe_over_budget);
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(uclogic_probe);
+
+/**
+ * uclogic_probe_begin - start timing a probe or resume of a tablet
+ * interface, and set the time budget, timeouts, and retries of the
+ * transfers it makes, from the module parameters.
+ *
+ * @drvdata:	Driver data of the interface.
+ * @resume:	True if it's a resume, false if a probe.
+ * @start:	The time the probe or resume started, ns.
+ */
+static void uclogic_probe_begin(struct uclogic_drvdata *drvdata, bool resume,
+				u64 start)
+{
+	unsigned int budget_ms = READ_ONCE(uclogic_probe_budget_ms);
+
+	memset(drvdata->probe_ns, 0, sizeof(drvdata->probe_ns));
+	drvdata->probe_resume = resume;
+	drvdata->probe_retries = 0;
+	drvdata->probe_over_budget = false;
+	drvdata->probe_deadline = budget_ms == 0 ? 0 :
+				  start + (u64)budget_ms * NSEC_PER_MSEC;
+	drvdata->ctrl_timeout_ms = READ_ONCE(uclogic_ctrl_timeout_ms);
+	drvdata->intr_timeout_ms = READ_ONCE(uclogic_intr_timeout_ms);
+	drvdata->xfer_retries = READ_ONCE(uclogic_xfer_retries);
+}
+
+/**
+ * uclogic_probe_end - finish timing a probe or resume of a tablet
+ * interface, lift its time budget, report it if it was exceeded, and
+ * trace the durations of its phases.
+ *
+ * @drvdata:	Driver data of the interface.
+ * @start:	The time the probe or resume started, ns.
+ */
+static void uclogic_probe_end(struct uclogic_drvdata *drvdata, u64 start)
+{
+	unsigned int i;
+
+	uclogic_probe_phase_end(drvdata->hdev, UCLOGIC_PROBE_PHASE_TOTAL,
+				start);
+	drvdata->probe_deadline = 0;
+	if (drvdata->probe_over_budget)
+		hid_warn(drvdata->hdev,
+			 "%s ran out of its %u ms budget after %u retries\n",
+			 drvdata->probe_resume ? "resume" : "probe",
+			 READ_ONCE(uclogic_probe_budget_ms),
+			 drvdata->probe_retries);
+	else if (drvdata->probe_retries != 0)
+		hid_info(drvdata->hdev, "%s needed %u transfer retries\n",
+			 drvdata->probe_resume ? "resume" : "probe",
+			 drvdata->probe_retries);
+
+	if (!trace_uclogic_probe_phase_enabled())
+		return;
+	for (i = 0; i < UCLOGIC_PROBE_PHASES; i++)
+		trace_uclogic_probe_phase(drvdata->hdev, drvdata->probe_resume,
+					  i, drvdata->probe_ns[i]);
+}
+
+/**
+ * uclogic_probe_first_report - record the time from the start of the last
+ * probe or resume of a tablet interface to its first input report.
+ * Called for the first report after it only.
+ *
+ * @drvdata:	Driver data of the interface.
+ * @start:	The time the probe or resume started, ns.
+ */
+static void uclogic_probe_first_report(struct uclogic_drvdata *drvdata,
+				       u64 start)
+{
+	u64 elapsed = ktime_get_ns() - start;
+
+	WRITE_ONCE(drvdata->probe_start, 0);
+	WRITE_ONCE(drvdata->first_report_ns, elapsed);
+	trace_uclogic_probe_first_report(drvdata->hdev,
+					 drvdata->probe_resume, elapsed);
+}
+
 static int uclogic_probe(struct hid_device *hdev,
 		const struct hid_device_id *id)
 {
 	int rc;
 	struct uclogic_drvdata *drvdata = NULL;
 	bool params_initialized = false;
+	u64 start = ktime_get_ns();
+	u64 phase_start;
 
 	/*
 	 * libinput requires the pad interface to be on a different node
@@ -192,12 +920,20 @@ static int uclogic_probe(struct hid_device *hdev,
 		goto failure;
 	}
 	timer_setup(&drvdata->inrange_timer, uclogic_inrange_timeout, 0);
-	drvdata->re_state = U8_MAX;
+	mutex_init(&drvdata->stats_lock);
+	mutex_init(&drvdata->capture_lock);
+	drvdata->hdev = hdev;
+	drvdata->transport = &uclogic_transport_usb;
+	if (uclogic_virtual && !uclogic_transport_is_usb(hdev))
+		drvdata->transport = &uclogic_transport_virtual;
 	drvdata->quirks = id->driver_data;
 	hid_set_drvdata(hdev, drvdata);
+	uclogic_probe_begin(drvdata, false, start);
 
 	/* Initialize the device and retrieve interface parameters */
+	phase_start = ktime_get_ns();
 	rc = uclogic_params_init(&drvdata->params, hdev);
+	uclogic_probe_phase_end(hdev, UCLOGIC_PROBE_PHASE_PARAMS, phase_start);
 	if (rc != 0) {
 		hid_err(hdev, "failed probing parameters: %d\n", rc);
 		goto failure;
@@ -212,9 +948,11 @@ static int uclogic_probe(struct hid_device *hdev,
 	}
 
 	/* Generate replacement report descriptor */
+	phase_start = ktime_get_ns();
 	rc = uclogic_params_get_desc(&drvdata->params,
 				     &drvdata->desc_ptr,
 				     &drvdata->desc_size);
+	uclogic_probe_phase_end(hdev, UCLOGIC_PROBE_PHASE_DESC, phase_start);
 	if (rc) {
 		hid_err(hdev,
 			"failed generating replacement report descriptor: %d\n",
@@ -222,23 +960,77 @@ static int uclogic_probe(struct hid_device *hdev,
 		goto failure;
 	}
 
+	/* Build the raw report handling data */
+	rc = uclogic_params_get_raw(&drvdata->params, &drvdata->raw);
+	if (rc) {
+		hid_err(hdev,
+			"failed building raw report handling data: %d\n",
+			rc);
+		goto failure;
+	}
+	drvdata->raw.inrange_timeout_ms = UCLOGIC_INRANGE_TIMEOUT_MS;
+	drvdata->probe_start = start;
+
+	phase_start = ktime_get_ns();
 	rc = hid_parse(hdev);
+	uclogic_probe_phase_end(hdev, UCLOGIC_PROBE_PHASE_PARSE, phase_start);
 	if (rc) {
 		hid_err(hdev, "parse failed\n");
 		goto failure;
 	}
 
+	phase_start = ktime_get_ns();
 	rc = hid_hw_start(hdev, HID_CONNECT_DEFAULT);
+	uclogic_probe_phase_end(hdev, UCLOGIC_PROBE_PHASE_HW_START,
+				phase_start);
 	if (rc) {
 		hid_err(hdev, "hw start failed\n");
 		goto failure;
 	}
 
+	rc = sysfs_create_group(&hdev->dev.kobj, &uclogic_attr_group);
+	if (rc) {
+		hid_err(hdev, "failed creating sysfs attributes: %d\n", rc);
+		hid_hw_stop(hdev);
+		goto failure;
+	}
+
+	/*
+	 * Expose the statistics, the report capture, and the probe timing
+	 * next to HID core's debug files, if any
+	 */
+	if (!IS_ERR_OR_NULL(hdev->debug_dir)) {
+		drvdata->stats_file = debugfs_create_file("uclogic_stats", 0444,
+							  hdev->debug_dir,
+							  drvdata,
+							  &uclogic_stats_fops);
+		drvdata->stats_enable_file = debugfs_create_file(
+						"uclogic_stats_enable", 0600,
+						hdev->debug_dir, drvdata,
+						&uclogic_stats_enable_fops);
+		drvdata->capture_file = debugfs_create_file(
+						"uclogic_capture", 0400,
+						hdev->debug_dir, drvdata,
+						&uclogic_capture_fops);
+		drvdata->capture_enable_file = debugfs_create_file(
+						"uclogic_capture_enable", 0600,
+						hdev->debug_dir, drvdata,
+						&uclogic_capture_enable_fops);
+		drvdata->probe_file = debugfs_create_file("uclogic_probe", 0444,
+							  hdev->debug_dir,
+							  drvdata,
+							  &uclogic_probe_fops);
+	}
+
+	uclogic_probe_end(drvdata, start);
 	return 0;
 failure:
 	/* Assume "remove" might not be called if "probe" failed */
 	if (params_initialized)
 		uclogic_params_cleanup(&drvdata->params);
+	if (drvdata != NULL) {
+		uclogic_probe_end(drvdata, start);
+	}
 	return rc;
 }
 
@@ -246,23 +1038,119 @@ failure:
 static int uclogic_resume(struct hid_device *hdev)
 {
 	int rc;
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
 	struct uclogic_params params;
+	u64 start = ktime_get_ns();
+
+	/* Time this resume instead of the last probe or resume */
+	uclogic_probe_begin(drvdata, true, start);
+	WRITE_ONCE(drvdata->first_report_ns, 0);
+	WRITE_ONCE(drvdata->probe_start, start);
+
+	/* Replay the enabling transfers, if the tablet answers the same */
+	rc = -ESTALE;
+	if (uclogic_quick_resume) {
+		rc = uclogic_params_resume(hdev);
+		if (rc != 0)
+			hid_dbg(hdev,
+				"failed replaying enabling transfers: %d, re-initializing\n",
+				rc);
+	}
 
 	/* Re-initialize the device, but discard parameters */
-	rc = uclogic_params_init(&params, hdev);
-	if (rc != 0)
-		hid_err(hdev, "failed to re-initialize the device\n");
-	else
-		uclogic_params_cleanup(&params);
+	if (rc != 0) {
+		rc = uclogic_params_init(&params, hdev);
+		if (rc != 0)
+			hid_err(hdev, "failed to re-initialize the device\n");
+		else
+			uclogic_params_cleanup(&params);
+	}
+	uclogic_probe_phase_end(hdev, UCLOGIC_PROBE_PHASE_PARAMS, start);
 
+	uclogic_probe_end(drvdata, start);
 	return rc;
 }
 #endif
 
+/**
+ * uclogic_raw_event_hook_matches - check if a raw event matches a hook.
+ *
+ * @hook:	The hook to match against.
+ * @event:	Raw event.
+ * @size:	The size of event.
+ *
+ * Returns:
+ *	True if the event matches the hook, false otherwise.
+ */
+static bool uclogic_raw_event_hook_matches(
+			const struct uclogic_raw_event_hook *hook,
+			const u8 *event, size_t size)
+{
+	size_t i;
+
+	if (hook->size != size)
+		return false;
+	if (hook->mask == NULL)
+		return memcmp(hook->event, event, size) == 0;
+	for (i = 0; i < size; i++) {
+		if ((hook->event[i] ^ event[i]) & hook->mask[i])
+			return false;
+	}
+	return true;
+}
+
+/**
+ * uclogic_match_event_hook - find the first registered hook matching a raw
+ * event.
+ *
+ * @hooks:	Raw event hooks to search.
+ * @event:	Raw event.
+ * @size:	The size of event.
+ *
+ * Returns:
+ *	The matching hook, or NULL if none matched.
+ */
+static struct uclogic_raw_event_hook *uclogic_match_event_hook(
+			const struct uclogic_raw_event_hooks *hooks,
+			const u8 *event, int size)
+{
+	struct uclogic_raw_event_hook *curr;
+	struct uclogic_raw_event_hook *match = NULL;
+
+	/* Reject most events on their size and first byte */
+	if (size <= 0 ||
+	    !(hooks->sizes & uclogic_raw_event_hooks_size_bit(size)) ||
+	    !test_bit(event[0], hooks->first_bytes))
+		return NULL;
+
+	/* Look up the hooks with the first two bytes fixed */
+	if (size >= 2) {
+		curr = hooks->buckets[uclogic_raw_event_hooks_bucket(event,
+								     size)];
+		for (; curr != NULL; curr = curr->next) {
+			if (uclogic_raw_event_hook_matches(curr, event, size)) {
+				match = curr;
+				break;
+			}
+		}
+	}
+
+	/* Check the rest of the hooks registered before the match, if any */
+	for (curr = hooks->wildcards;
+	     curr != NULL && (match == NULL || curr->index < match->index);
+	     curr = curr->next) {
+		if (uclogic_raw_event_hook_matches(curr, event, size))
+			return curr;
+	}
+
+	return match;
+}
+
 /**
  * uclogic_exec_event_hook - if the received event is hooked schedules the
  * associated work.
  *
+ * @hdev:	The HID device the event came from.
  * @p:		Tablet interface report parameters.
  * @event:	Raw event.
  * @size:	The size of event.
@@ -270,21 +1158,192 @@ static int uclogic_resume(struct hid_device *hdev)
  * Returns:
  *	Whether the event was hooked or not.
  */
-static bool uclogic_exec_event_hook(struct uclogic_params *p, u8 *event, int size)
+static bool uclogic_exec_event_hook(struct hid_device *hdev,
+				    struct uclogic_params *p,
+				    u8 *event, int size)
 {
-	struct uclogic_raw_event_hook *curr;
+	struct uclogic_raw_event_hook *hook;
+	u64 start = 0;
 
 	if (!p->event_hooks)
 		return false;
 
-	list_for_each_entry(curr, &p->event_hooks->list, list) {
-		if (curr->size == size && memcmp(curr->event, event, size) == 0) {
-			schedule_work(&curr->work);
-			return true;
+	if (trace_uclogic_exec_event_hook_enabled())
+		start = ktime_get_ns();
+
+	hook = uclogic_match_event_hook(p->event_hooks, event, size);
+	if (hook != NULL)
+		schedule_work(&hook->work);
+
+	/* Trace the scans which didn't match too, they cost all the same */
+	if (trace_uclogic_exec_event_hook_enabled() && start != 0)
+		trace_uclogic_exec_event_hook(hdev, event, size, hook,
+					      ktime_get_ns() - start);
+	return hook != NULL;
+}
+
+/*
+ * Rotary encoder state changes, encoded into 2-bit signed integers, indexed
+ * by the previous and the current 2-bit Gray-coded states.
+ */
+static const u8 uclogic_raw_encoder_changes[4][4] = {
+	/* From 0 - no change detected */
+	{ 0, 0, 0, 0 },
+	/* From 1 - 0 is clockwise, 3 is counterclockwise */
+	{ 1, 0, 0, 3 },
+	/* From 2 - 3 is clockwise, 0 is counterclockwise */
+	{ 3, 0, 0, 1 },
+	/* From 3 - no change detected */
+	{ 0, 0, 0, 0 },
+};
+
+/**
+ * uclogic_raw_prog_run - run a raw report rewrite program on a report.
+ *
+ * @drvdata:	Driver data.
+ * @prog:	The program to run.
+ * @data:	Report data buffer, can be modified.
+ * @size:	Report data size, bytes.
+ */
+static void uclogic_raw_prog_run(struct uclogic_drvdata *drvdata,
+				 const struct uclogic_raw_prog *prog,
+				 u8 *data, int size)
+{
+	struct uclogic_raw *raw = &drvdata->raw;
+	const struct uclogic_raw_op *op = prog->ops;
+	const struct uclogic_raw_op *end = prog->ops + ARRAY_SIZE(prog->ops);
+	u8 src[UCLOGIC_RAW_PROG_SRC_MAX];
+	bool short_report = false;
+
+	if (size <= 0)
+		return;
+
+	/* Keep the original bytes the operations read */
+	memcpy(src, data, min_t(int, size, prog->src_size));
+
+	for (; op < end && op->code != UCLOGIC_RAW_OP_END; op++) {
+		if (size < op->min_size) {
+			short_report = true;
+			continue;
+		}
+		switch (op->code) {
+		case UCLOGIC_RAW_OP_MOVE:
+			data[op->dst] = src[op->src];
+			break;
+		case UCLOGIC_RAW_OP_XOR:
+			data[op->dst] ^= op->arg;
+			break;
+		case UCLOGIC_RAW_OP_OR:
+			data[op->dst] |= op->arg;
+			break;
+		case UCLOGIC_RAW_OP_NEG:
+			data[op->dst] = -data[op->dst];
+			break;
+		case UCLOGIC_RAW_OP_SET:
+			data[op->dst] = op->arg;
+			break;
+		case UCLOGIC_RAW_OP_MAP:
+			data[op->dst] = raw->tables[op->arg][src[op->src]];
+			break;
+		case UCLOGIC_RAW_OP_ENCODER: {
+			/* Read Gray-coded state */
+			u8 state = (data[op->dst] >> op->arg) & 0x3;
+			u8 change = uclogic_raw_encoder_changes[raw->re_state]
+							       [state];
+
+			/* Write change */
+			data[op->dst] = (data[op->dst] & ~((u8)3 << op->arg)) |
+				(change << op->arg);
+			/* Remember state */
+			raw->re_state = state;
+			if (change == 1)
+				UCLOGIC_STATS_INC(drvdata, encoder_cw);
+			else if (change == 3)
+				UCLOGIC_STATS_INC(drvdata, encoder_ccw);
+			break;
+		}
+		case UCLOGIC_RAW_OP_INRANGE: {
+			u64 now = ktime_get_ns();
+			u64 interval = now - raw->inrange_last;
+			int state;
+
+			/* Record the report interval, if within a stroke */
+			if (interval < UCLOGIC_INRANGE_TIMEOUT_MAX_MS *
+					NSEC_PER_MSEC)
+				raw->inrange_intervals[
+					raw->inrange_interval_idx++ %
+					ARRAY_SIZE(raw->inrange_intervals)] =
+						interval;
+			/*
+			 * Count the report, taking the pen from the timer, and
+			 * start in-range timeout, if not started yet, with a
+			 * snapshot of the state to expire on. The timeout
+			 * handler restarts it, if it expires after more
+			 * reports.
+			 */
+			WRITE_ONCE(raw->inrange_last, now);
+			state = uclogic_inrange_report_begin(raw);
+			if (!timer_pending(&drvdata->inrange_timer)) {
+				WRITE_ONCE(raw->inrange_timer_state,
+					   state & ~UCLOGIC_INRANGE_REPORT);
+				mod_timer(&drvdata->inrange_timer,
+					  jiffies + msecs_to_jiffies(
+						raw->inrange_timeout_ms));
+			}
+			break;
+		}
+		case UCLOGIC_RAW_OP_PROXIMITY_OUT: {
+			u8 clear = raw->tables[op->arg][src[op->src]];
+
+			if (clear != 0) {
+				data[op->dst] &= ~clear;
+				/* The pen is already out, don't emulate that */
+				del_timer(&drvdata->inrange_timer);
+			}
+			break;
+		}
 		}
 	}
 
-	return false;
+	if (short_report)
+		UCLOGIC_STATS_INC(drvdata, short_reports);
+}
+
+/**
+ * uclogic_raw_prog_run_traced - run a raw report rewrite program on a
+ * report, and trace the bytes it changed and the time it took.
+ *
+ * @drvdata:	Driver data.
+ * @prog:	The program to run, either the pen's, or one of the frames'.
+ * @data:	Report data buffer, can be modified.
+ * @size:	Report data size, bytes.
+ */
+static void uclogic_raw_prog_run_traced(struct uclogic_drvdata *drvdata,
+					const struct uclogic_raw_prog *prog,
+					u8 *data, int size)
+{
+	u8 orig[32];
+	int len = clamp(size, 0, (int)sizeof(orig));
+	u32 changed = 0;
+	u64 duration;
+	int i;
+
+	if (len > 0)
+		memcpy(orig, data, len);
+	duration = ktime_get_ns();
+	uclogic_raw_prog_run(drvdata, prog, data, size);
+	duration = ktime_get_ns() - duration;
+	for (i = 0; i < len; i++)
+		if (data[i] != orig[i])
+			changed |= BIT(i);
+
+	if (prog == &drvdata->raw.pen)
+		trace_uclogic_raw_event_pen(drvdata->hdev, -1, data, size,
+					    changed, duration);
+	else
+		trace_uclogic_raw_event_frame(drvdata->hdev,
+					      prog - drvdata->raw.frame_list,
+					      data, size, changed, duration);
 }
 
 /**
@@ -300,54 +1359,14 @@ static bool uclogic_exec_event_hook(struct uclogic_params *p, u8 *event, int siz
 static int uclogic_raw_event_pen(struct uclogic_drvdata *drvdata,
 					u8 *data, int size)
 {
-	struct uclogic_params_pen *pen = &drvdata->params.pen;
-
 	WARN_ON(drvdata == NULL);
 	WARN_ON(data == NULL && size != 0);
 
-	/* If in-range reports are inverted */
-	if (pen->inrange ==
-		UCLOGIC_PARAMS_PEN_INRANGE_INVERTED) {
-		/* Invert the in-range bit */
-		data[1] ^= 0x40;
-	}
-	/*
-	 * If report contains fragmented high-resolution pen
-	 * coordinates
-	 */
-	if (size >= 10 && pen->fragmented_hires) {
-		u8 pressure_low_byte;
-		u8 pressure_high_byte;
-
-		/* Lift pressure bytes */
-		pressure_low_byte = data[6];
-		pressure_high_byte = data[7];
-		/*
-		 * Move Y coord to make space for high-order X
-		 * coord byte
-		 */
-		data[6] = data[5];
-		data[5] = data[4];
-		/* Move high-order X coord byte */
-		data[4] = data[8];
-		/* Move high-order Y coord byte */
-		data[7] = data[9];
-		/* Place pressure bytes */
-		data[8] = pressure_low_byte;
-		data[9] = pressure_high_byte;
-	}
-	/* If we need to emulate in-range detection */
-	if (pen->inrange == UCLOGIC_PARAMS_PEN_INRANGE_NONE) {
-		/* Set in-range bit */
-		data[1] |= 0x40;
-		/* (Re-)start in-range timeout */
-		mod_timer(&drvdata->inrange_timer,
-				jiffies + msecs_to_jiffies(100));
-	}
-	/* If we report tilt and Y direction is flipped */
-	if (size >= 12 && pen->tilt_y_flipped)
-		data[11] = -data[11];
-
+	if (trace_uclogic_raw_event_pen_enabled())
+		uclogic_raw_prog_run_traced(drvdata, &drvdata->raw.pen,
+					    data, size);
+	else
+		uclogic_raw_prog_run(drvdata, &drvdata->raw.pen, data, size);
 	return 0;
 }
 
@@ -355,7 +1374,7 @@ static int uclogic_raw_event_pen(struct uclogic_drvdata *drvdata,
  * uclogic_raw_event_frame - handle raw frame events (frame HID reports).
  *
  * @drvdata:	Driver data.
- * @frame:	The parameters of the frame controls to handle.
+ * @prog:	The rewrite program of the frame controls to handle.
  * @data:	Report data buffer, can be modified.
  * @size:	Report data size, bytes.
  *
@@ -364,137 +1383,209 @@ static int uclogic_raw_event_pen(struct uclogic_drvdata *drvdata,
  */
 static int uclogic_raw_event_frame(
 		struct uclogic_drvdata *drvdata,
-		const struct uclogic_params_frame *frame,
+		const struct uclogic_raw_prog *prog,
 		u8 *data, int size)
 {
 	WARN_ON(drvdata == NULL);
 	WARN_ON(data == NULL && size != 0);
 
-	/* If need to, and can, set pad device ID for Wacom drivers */
-	if (frame->dev_id_byte > 0 && frame->dev_id_byte < size) {
-		/* If we also have a touch ring and the finger left it */
-		if (frame->touch_byte > 0 && frame->touch_byte < size &&
-		    data[frame->touch_byte] == 0) {
-			data[frame->dev_id_byte] = 0;
-		} else {
-			data[frame->dev_id_byte] = 0xf;
-		}
-	}
+	if (trace_uclogic_raw_event_frame_enabled())
+		uclogic_raw_prog_run_traced(drvdata, prog, data, size);
+	else
+		uclogic_raw_prog_run(drvdata, prog, data, size);
+	return 0;
+}
 
-	/* If need to, and can, read rotary encoder state change */
-	if (frame->re_lsb > 0 && frame->re_lsb / 8 < size) {
-		unsigned int byte = frame->re_lsb / 8;
-		unsigned int bit = frame->re_lsb % 8;
-
-		u8 change;
-		u8 prev_state = drvdata->re_state;
-		/* Read Gray-coded state */
-		u8 state = (data[byte] >> bit) & 0x3;
-		/* Encode state change into 2-bit signed integer */
-		if ((prev_state == 1 && state == 0) ||
-		    (prev_state == 2 && state == 3)) {
-			change = 1;
-		} else if ((prev_state == 2 && state == 0) ||
-			   (prev_state == 1 && state == 3)) {
-			change = 3;
-		} else {
-			change = 0;
-		}
-		/* Write change */
-		data[byte] = (data[byte] & ~((u8)3 << bit)) |
-				(change << bit);
-		/* Remember state */
-		drvdata->re_state = state;
-	}
-
-	/* If need to, and can, transform the touch ring reports */
-	if (frame->touch_byte > 0 && frame->touch_byte < size) {
-		__s8 value = data[frame->touch_byte];
-
-		if (value != 0) {
-			if (frame->touch_flip_at != 0) {
-				value = frame->touch_flip_at - value;
-				if (value <= 0)
-					value = frame->touch_max + value;
-			}
-			data[frame->touch_byte] = value - 1;
-		}
-	}
+/**
+ * uclogic_stats_report - count an input report and the interval since the
+ * previous one in the report handling statistics.
+ *
+ * @drvdata:	Driver data.
+ * @stats:	The statistics to update.
+ * @id:		The report ID.
+ */
+static void uclogic_stats_report(struct uclogic_drvdata *drvdata,
+				 struct uclogic_stats __percpu *stats,
+				 unsigned int id)
+{
+	u64 now = ktime_get_ns();
+	u64 interval_us = div_u64(now - drvdata->stats_last, NSEC_PER_USEC);
+	unsigned int bucket;
 
-	/* If need to, and can, transform the bitmap dial reports */
-	if (frame->bitmap_dial_byte > 0 && frame->bitmap_dial_byte < size) {
-		if (data[frame->bitmap_dial_byte] == 2)
-			data[frame->bitmap_dial_byte] = -1;
+	this_cpu_inc(stats->reports[id & U8_MAX]);
+	if (drvdata->stats_last != 0) {
+		bucket = interval_us == 0 ? 0 : ilog2(interval_us) + 1;
+		this_cpu_inc(stats->intervals[
+			min_t(unsigned int, bucket,
+			      UCLOGIC_STATS_INTERVALS - 1)]);
 	}
-
-	return 0;
+	drvdata->stats_last = now;
 }
 
-static int uclogic_raw_event(struct hid_device *hdev,
-				struct hid_report *report,
-				u8 *data, int size)
+static int uclogic_raw_event_dispatch(struct hid_device *hdev,
+					struct hid_report *report,
+					u8 *data, int size)
 {
-	unsigned int report_id = report->id;
 	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
-	struct uclogic_params *params = &drvdata->params;
-	struct uclogic_params_pen_subreport *subreport;
-	struct uclogic_params_pen_subreport *subreport_list_end;
-	size_t i;
+	struct uclogic_raw *raw = &drvdata->raw;
+	const struct uclogic_raw_map *map = &raw->map;
+	struct uclogic_stats __percpu *stats;
+	unsigned int handler;
+	u8 subreport_id;
 
 	/* Do not handle anything but input reports */
 	if (report->type != HID_INPUT_REPORT)
 		return 0;
 
-	if (uclogic_exec_event_hook(params, data, size))
+	/* Only take the time, if the statistics are collected */
+	stats = smp_load_acquire(&drvdata->stats_active);
+	if (stats)
+		uclogic_stats_report(drvdata, stats, report->id);
+
+	if (raw->event_hooks &&
+	    uclogic_exec_event_hook(hdev, &drvdata->params,
+				    data, size)) {
+		UCLOGIC_STATS_INC(drvdata, hooks);
 		return 0;
+	}
 
-	while (true) {
-		/* Tweak pen reports, if necessary */
-		if ((report_id == params->pen.id) && (size >= 2)) {
-			subreport_list_end =
-				params->pen.subreport_list +
-				ARRAY_SIZE(params->pen.subreport_list);
-			/* Try to match a subreport */
-			for (subreport = params->pen.subreport_list;
-			     subreport < subreport_list_end; subreport++) {
-				if (subreport->value != 0 &&
-				    subreport->value == data[1]) {
-					break;
-				}
-			}
-			/* If a subreport matched */
-			if (subreport < subreport_list_end) {
-				/* Change to subreport ID, and restart */
-				report_id = data[0] = subreport->id;
-				continue;
-			} else {
-				return uclogic_raw_event_pen(drvdata, data, size);
-			}
-		}
+	/* Leave the reports alone, if there is nothing to tweak */
+	if (map->passthrough)
+		goto unmatched;
 
-		/* Tweak frame control reports, if necessary */
-		for (i = 0; i < ARRAY_SIZE(params->frame_list); i++) {
-			if (report_id == params->frame_list[i].id) {
-				return uclogic_raw_event_frame(
-					drvdata, &params->frame_list[i],
-					data, size);
-			}
-		}
+	handler = map->handler[report->id & U8_MAX];
 
-		break;
+	/* Tweak pen reports, if necessary */
+	if (handler == UCLOGIC_RAW_HANDLER_PEN) {
+		if (size < 2) {
+			UCLOGIC_STATS_INC(drvdata, short_reports);
+			return 0;
+		}
+		subreport_id = map->subreport_id[data[1]];
+		if (subreport_id == 0)
+			return uclogic_raw_event_pen(drvdata, data, size);
+		/* Change to subreport ID, and handle it instead */
+		data[0] = subreport_id;
+		handler = map->handler[subreport_id];
+		UCLOGIC_STATS_INC(drvdata, subreports[subreport_id]);
 	}
 
+	/* Tweak frame control reports, if necessary */
+	if (handler >= UCLOGIC_RAW_HANDLER_FRAME)
+		return uclogic_raw_event_frame(
+			drvdata,
+			&raw->frame_list[handler - UCLOGIC_RAW_HANDLER_FRAME],
+			data, size);
+
+unmatched:
+	UCLOGIC_STATS_INC(drvdata, unmatched);
 	return 0;
 }
 
+/**
+ * uclogic_capture_begin - start capturing a raw report into a ring, if it
+ * has space for it.
+ *
+ * @capture:	The ring to capture into.
+ * @data:	Report data buffer, as received.
+ * @size:	Report data size, bytes.
+ *
+ * Returns:
+ *	The entry to finish capturing the report into with
+ *	uclogic_capture_end(), or NULL if the ring was full, and the report
+ *	was dropped.
+ */
+static struct uclogic_capture_entry *uclogic_capture_begin(
+					struct uclogic_capture *capture,
+					const u8 *data, int size)
+{
+	unsigned int head = capture->head;
+	struct uclogic_capture_entry *entry;
+
+	/* Drop the report, if the reader hasn't caught up */
+	if (head - smp_load_acquire(&capture->tail) >=
+	    UCLOGIC_CAPTURE_ENTRIES) {
+		WRITE_ONCE(capture->dropped, capture->dropped + 1);
+		return NULL;
+	}
+
+	entry = &capture->entries[head % UCLOGIC_CAPTURE_ENTRIES];
+	entry->time = ktime_get_ns();
+	entry->size = size;
+	memcpy(entry->orig, data, clamp(size, 0, UCLOGIC_CAPTURE_DATA_MAX));
+	return entry;
+}
+
+/**
+ * uclogic_capture_end - finish capturing a raw report into a ring, and
+ * pass it to the reader.
+ *
+ * @capture:	The ring to capture into.
+ * @entry:	The entry returned by uclogic_capture_begin().
+ * @data:	Report data buffer, as rewritten.
+ * @size:	Report data size, bytes.
+ */
+static void uclogic_capture_end(struct uclogic_capture *capture,
+				struct uclogic_capture_entry *entry,
+				const u8 *data, int size)
+{
+	memcpy(entry->data, data, clamp(size, 0, UCLOGIC_CAPTURE_DATA_MAX));
+	smp_store_release(&capture->head, capture->head + 1);
+}
+
+static int uclogic_raw_event(struct hid_device *hdev,
+				struct hid_report *report,
+				u8 *data, int size)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+	struct uclogic_capture *capture = READ_ONCE(drvdata->capture_active);
+	struct uclogic_capture_entry *entry = NULL;
+	u64 start;
+	int rc;
+
+	if (capture != NULL)
+		entry = uclogic_capture_begin(capture, data, size);
+
+	start = READ_ONCE(drvdata->probe_start);
+	if (unlikely(start != 0))
+		uclogic_probe_first_report(drvdata, start);
+
+	/* Only take the time if it's traced */
+	if (!trace_uclogic_raw_event_enabled()) {
+		rc = uclogic_raw_event_dispatch(hdev, report, data, size);
+	} else {
+		start = ktime_get_ns();
+		rc = uclogic_raw_event_dispatch(hdev, report, data, size);
+		/* Pen reports might have been changed to a subreport ID */
+		trace_uclogic_raw_event(hdev, report->id,
+					report->id != 0 && size > 0 &&
+					data[0] != report->id ? data[0] : 0,
+					size, ktime_get_ns() - start);
+	}
+
+	if (entry != NULL)
+		uclogic_capture_end(capture, entry, data, size);
+	return rc;
+}
+
 static void uclogic_remove(struct hid_device *hdev)
 {
 	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
 
+	debugfs_remove(drvdata->probe_file);
+	debugfs_remove(drvdata->capture_enable_file);
+	debugfs_remove(drvdata->capture_file);
+	debugfs_remove(drvdata->stats_enable_file);
+	debugfs_remove(drvdata->stats_file);
+	sysfs_remove_group(&hdev->dev.kobj, &uclogic_attr_group);
 	del_timer_sync(&drvdata->inrange_timer);
 	hid_hw_stop(hdev);
 	kfree(drvdata->desc_ptr);
 	uclogic_params_cleanup(&drvdata->params);
+	free_percpu(drvdata->stats);
+	kvfree(drvdata->capture);
+	mutex_destroy(&drvdata->capture_lock);
+	mutex_destroy(&drvdata->stats_lock);
 }
 
 static const struct hid_device_id uclogic_devices[] = {
@@ -587,12 +1678,19 @@ static struct hid_driver uclogic_driver = {
 	.remove = uclogic_remove,
 	.report_fixup = uclogic_report_fixup,
 	.raw_event = uclogic_raw_event,
+	.report = uclogic_report,
 	.input_mapping = uclogic_input_mapping,
 	.input_configured = uclogic_input_configured,
 #ifdef CONFIG_PM
 	.resume	          = uclogic_resume,
 	.reset_resume     = uclogic_resume,
 #endif
+#if KERNEL_VERSION(4, 2, 0) <= LINUX_VERSION_CODE
+	/* Don't hold up probing other devices while talking to the tablet */
+	.driver = {
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
+#endif
 };
 module_hid_driver(uclogic_driver);
 
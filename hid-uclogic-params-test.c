@@ -7,6 +7,9 @@
  */
 
 #include <kunit/test.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <trace/events/kmem.h>
 #include "./hid-uclogic-params.h"
 #include "./hid-uclogic-rdesc.h"
 
@@ -203,19 +206,1466 @@ static void hid_test_uclogic_params_cleanup_event_hooks(struct kunit *test)
 	}
 }
 
+static void hid_test_uclogic_params_get_raw(struct kunit *test)
+{
+	struct uclogic_params p = {0, };
+	struct uclogic_raw *raw;
+	struct uclogic_raw_map *map;
+	unsigned int n;
+
+	raw = kunit_kzalloc(test, sizeof(*raw), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, raw);
+	map = &raw->map;
+
+	/* Noop parameters pass everything through */
+	KUNIT_ASSERT_EQ(test, uclogic_params_get_raw(&p, raw), 0);
+	KUNIT_EXPECT_FALSE(test, raw->event_hooks);
+	KUNIT_EXPECT_EQ(test, raw->re_state, 0);
+	KUNIT_EXPECT_TRUE(test, map->passthrough);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[0].code, UCLOGIC_RAW_OP_END);
+	for (n = 0; n < ARRAY_SIZE(map->handler); n++) {
+		KUNIT_EXPECT_EQ(test, map->handler[n], UCLOGIC_RAW_HANDLER_NONE);
+		KUNIT_EXPECT_EQ(test, map->subreport_id[n], 0);
+	}
+
+	/* Huion v2 pen with frame buttons and a dial, linked by subreports */
+	p.pen.id = UCLOGIC_RDESC_V2_PEN_ID;
+	p.pen.inrange = UCLOGIC_PARAMS_PEN_INRANGE_NONE;
+	p.pen.tilt_y_flipped = true;
+	p.pen.subreport_list[0].value = 0xe0;
+	p.pen.subreport_list[0].id = UCLOGIC_RDESC_V2_FRAME_BUTTONS_ID;
+	p.pen.subreport_list[1].value = 0xf1;
+	p.pen.subreport_list[1].id = UCLOGIC_RDESC_V2_FRAME_DIAL_ID;
+	/* A later duplicate must not override the first match */
+	p.pen.subreport_list[2].value = 0xe0;
+	p.pen.subreport_list[2].id = UCLOGIC_RDESC_V2_FRAME_DIAL_ID;
+	p.frame_list[0].id = UCLOGIC_RDESC_V2_FRAME_BUTTONS_ID;
+	p.frame_list[2].id = UCLOGIC_RDESC_V2_FRAME_DIAL_ID;
+	p.frame_list[2].re_lsb = 4;
+	p.frame_list[2].bitmap_dial_byte = 5;
+	/* IDs no report can have are never matched */
+	p.frame_list[3].id = U8_MAX + 1;
+
+	/* Offsets which don't fit a rewrite program are rejected */
+	p.frame_list[2].dev_id_byte = 300;
+	KUNIT_EXPECT_EQ(test, uclogic_params_get_raw(&p, raw), -ERANGE);
+	p.frame_list[2].dev_id_byte = 6;
+
+	KUNIT_ASSERT_EQ(test, uclogic_params_get_raw(&p, raw), 0);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[0].code, UCLOGIC_RAW_OP_OR);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[0].dst, 1);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[0].arg, 0x40);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[1].code, UCLOGIC_RAW_OP_INRANGE);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[2].code, UCLOGIC_RAW_OP_NEG);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[2].min_size, 12);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[2].dst, 11);
+	KUNIT_EXPECT_EQ(test, raw->pen.ops[3].code, UCLOGIC_RAW_OP_END);
+	KUNIT_EXPECT_EQ(test, raw->pen.src_size, 0);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[0].ops[0].code,
+			UCLOGIC_RAW_OP_END);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[0].code,
+			UCLOGIC_RAW_OP_SET);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[0].dst, 6);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[0].arg, 0xf);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[1].code,
+			UCLOGIC_RAW_OP_ENCODER);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[1].dst, 0);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[1].arg, 4);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[2].code,
+			UCLOGIC_RAW_OP_MAP);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].ops[2].src, 5);
+	KUNIT_EXPECT_EQ(test, raw->frame_list[2].src_size, 6);
+	KUNIT_EXPECT_EQ(test,
+			raw->tables[raw->frame_list[2].ops[2].arg][2], 0xff);
+	KUNIT_EXPECT_FALSE(test, map->passthrough);
+	KUNIT_EXPECT_EQ(test, map->handler[UCLOGIC_RDESC_V2_PEN_ID],
+			UCLOGIC_RAW_HANDLER_PEN);
+	KUNIT_EXPECT_EQ(test, map->handler[UCLOGIC_RDESC_V2_FRAME_BUTTONS_ID],
+			UCLOGIC_RAW_HANDLER_FRAME + 0);
+	KUNIT_EXPECT_EQ(test, map->handler[UCLOGIC_RDESC_V2_FRAME_DIAL_ID],
+			UCLOGIC_RAW_HANDLER_FRAME + 2);
+	KUNIT_EXPECT_EQ(test, map->handler[0], UCLOGIC_RAW_HANDLER_NONE);
+	KUNIT_EXPECT_EQ(test, map->subreport_id[0xe0],
+			UCLOGIC_RDESC_V2_FRAME_BUTTONS_ID);
+	KUNIT_EXPECT_EQ(test, map->subreport_id[0xf1],
+			UCLOGIC_RDESC_V2_FRAME_DIAL_ID);
+	KUNIT_EXPECT_EQ(test, map->subreport_id[0], 0);
+	KUNIT_EXPECT_EQ(test, map->subreport_id[0xf0], 0);
+}
+
+/* Kinds of transfers of the scripted transport */
+enum uclogic_mock_xfer_type {
+	UCLOGIC_MOCK_STR_DESC,
+	UCLOGIC_MOCK_STRING,
+	UCLOGIC_MOCK_INTERRUPT,
+};
+
+/* A scripted response to a transfer */
+struct uclogic_mock_xfer {
+	enum uclogic_mock_xfer_type type;
+	/* String descriptor index, or endpoint */
+	int idx;
+	/* Negative errno code to fail the transfer with, zero to succeed */
+	int err;
+	/* Number of times to fail before succeeding, zero to always fail */
+	unsigned int err_times;
+	/* Time to take responding, ms */
+	unsigned int delay_ms;
+	/* Data to respond with, NULL for interrupt transfers */
+	const void *data;
+	size_t size;
+};
+
+#define UCLOGIC_MOCK_RESPONSE(_type, _idx, _arr) \
+	{ .type = _type, .idx = _idx, .data = _arr, .size = sizeof(_arr) }
+
+/* A scripted tablet interface, and the expected parameters */
+struct uclogic_mock_iface {
+	const char *name;
+	__u16 vendor;
+	__u16 product;
+	/* USB product string, NULL if none */
+	const char *product_str;
+	__u8 ifnum;
+	__u8 num_ifaces;
+	/* Size of the original report descriptor */
+	unsigned int rsize;
+	/* Responses, transfers without one fail with -EPIPE */
+	const struct uclogic_mock_xfer *xfers;
+	size_t num_xfers;
+	/* Expected result of uclogic_params_init() */
+	int res;
+	/* Expected parameters, if res is zero */
+	bool invalid;
+	bool desc;
+	bool pen;
+	bool pen_usage_invalid;
+	unsigned int frames;
+	bool event_hooks;
+	/* Expected numbers of transfers */
+	unsigned int ctrl_xfers;
+	unsigned int intr_xfers;
+};
+
+/* Driver data of a scripted tablet interface, with the transfer counts */
+struct uclogic_mock {
+	struct uclogic_drvdata drvdata;
+	const struct uclogic_mock_iface *iface;
+	/* True if the responses should be immediate */
+	bool no_delay;
+	/* Total time the responses took, ms */
+	unsigned int delay_ms;
+	unsigned int ctrl_xfers;
+	unsigned int intr_xfers;
+	/* The first transfers made, as "type << 8 | idx", in order */
+	unsigned int log[8];
+	/* Number of transfers made, including ones not logged */
+	unsigned int log_len;
+	/* Number of transfers failed */
+	unsigned int errs;
+	/* Last virtual tablet handshake request */
+	__u8 virtual_req[UCLOGIC_VIRTUAL_REPORT_SIZE];
+};
+
+static struct uclogic_mock *uclogic_mock_get(struct hid_device *hdev)
+{
+	return container_of(hid_get_drvdata(hdev), struct uclogic_mock,
+			    drvdata);
+}
+
+/* The response to a transfer taking longer than its timeout */
+static const struct uclogic_mock_xfer uclogic_mock_timeout = {
+	.err = -ETIMEDOUT,
+};
+
+/*
+ * Find the response to a transfer, waiting for its delay, or its timeout,
+ * like the USB transport does. Returns NULL if there is none.
+ */
+static const struct uclogic_mock_xfer *uclogic_mock_respond(
+					struct uclogic_mock *mock,
+					enum uclogic_mock_xfer_type type,
+					int idx)
+{
+	const struct uclogic_mock_xfer *xfer;
+	unsigned int timeout_ms;
+	size_t i;
+
+	if (type == UCLOGIC_MOCK_INTERRUPT)
+		timeout_ms = uclogic_transport_timeout(
+				mock->drvdata.hdev,
+				mock->drvdata.intr_timeout_ms, 1000);
+	else
+		timeout_ms = uclogic_transport_timeout(
+				mock->drvdata.hdev,
+				mock->drvdata.ctrl_timeout_ms,
+				USB_CTRL_GET_TIMEOUT);
+
+	if (mock->log_len < ARRAY_SIZE(mock->log))
+		mock->log[mock->log_len] = type << 8 | idx;
+	mock->log_len++;
+
+	for (i = 0; i < mock->iface->num_xfers; i++) {
+		xfer = &mock->iface->xfers[i];
+		if (xfer->type != type || xfer->idx != idx)
+			continue;
+		if (xfer->delay_ms > timeout_ms) {
+			if (!mock->no_delay) {
+				msleep(timeout_ms);
+				mock->delay_ms += timeout_ms;
+			}
+			return &uclogic_mock_timeout;
+		}
+		if (xfer->delay_ms != 0 && !mock->no_delay) {
+			msleep(xfer->delay_ms);
+			mock->delay_ms += xfer->delay_ms;
+		}
+		return xfer;
+	}
+	return NULL;
+}
+
+/* Get the error to fail a transfer with, zero if it should succeed */
+static int uclogic_mock_err(struct uclogic_mock *mock,
+			    const struct uclogic_mock_xfer *xfer)
+{
+	if (xfer->err == 0 ||
+	    (xfer->err_times != 0 && mock->errs >= xfer->err_times))
+		return 0;
+	mock->errs++;
+	return xfer->err;
+}
+
+static int uclogic_mock_get_iface(struct hid_device *hdev,
+				  __u8 *pnum, __u8 *pnum_ifaces)
+{
+	struct uclogic_mock *mock = uclogic_mock_get(hdev);
+
+	*pnum = mock->iface->ifnum;
+	*pnum_ifaces = mock->iface->num_ifaces;
+	return 0;
+}
+
+static int uclogic_mock_get_str_desc(struct hid_device *hdev, __u8 idx,
+				     __u8 *buf, size_t len)
+{
+	struct uclogic_mock *mock = uclogic_mock_get(hdev);
+	const struct uclogic_mock_xfer *xfer;
+
+	mock->ctrl_xfers++;
+	xfer = uclogic_mock_respond(mock, UCLOGIC_MOCK_STR_DESC, idx);
+	if (xfer == NULL)
+		return -EPIPE;
+	if (uclogic_mock_err(mock, xfer) != 0)
+		return xfer->err;
+	len = min(len, xfer->size);
+	memcpy(buf, xfer->data, len);
+	return len;
+}
+
+static int uclogic_mock_get_string(struct hid_device *hdev, __u8 idx,
+				   char *buf, size_t len)
+{
+	struct uclogic_mock *mock = uclogic_mock_get(hdev);
+	const struct uclogic_mock_xfer *xfer;
+
+	mock->ctrl_xfers++;
+	xfer = uclogic_mock_respond(mock, UCLOGIC_MOCK_STRING, idx);
+	if (xfer == NULL)
+		return -EPIPE;
+	if (uclogic_mock_err(mock, xfer) != 0)
+		return xfer->err;
+	return strscpy(buf, xfer->data, min(len, xfer->size));
+}
+
+static int uclogic_mock_send_interrupt(struct hid_device *hdev, int endpoint,
+				       __u8 *buf, size_t len, int *psent)
+{
+	struct uclogic_mock *mock = uclogic_mock_get(hdev);
+	const struct uclogic_mock_xfer *xfer;
+
+	mock->intr_xfers++;
+	xfer = uclogic_mock_respond(mock, UCLOGIC_MOCK_INTERRUPT, endpoint);
+	if (xfer == NULL)
+		return -EPIPE;
+	if (uclogic_mock_err(mock, xfer) != 0)
+		return xfer->err;
+	*psent = len;
+	return 0;
+}
+
+static int uclogic_mock_get_product(struct hid_device *hdev,
+				    char *buf, size_t len)
+{
+	const char *product = uclogic_mock_get(hdev)->iface->product_str;
+	ssize_t rc;
+
+	if (product == NULL)
+		return -ENODATA;
+	rc = strscpy(buf, product, len);
+	return rc == -E2BIG ? strlen(buf) : rc;
+}
+
+static const struct uclogic_transport uclogic_transport_mock = {
+	.get_iface = uclogic_mock_get_iface,
+	.get_str_desc = uclogic_mock_get_str_desc,
+	.get_string = uclogic_mock_get_string,
+	.send_interrupt = uclogic_mock_send_interrupt,
+	.get_product = uclogic_mock_get_product,
+};
+
+/*
+ * Answer virtual tablet handshake requests with the scripted transport's
+ * responses, as the userspace side of a uhid device would.
+ */
+static int uclogic_mock_raw_request(struct hid_device *hdev,
+				    unsigned char reportnum, __u8 *buf,
+				    size_t len, unsigned char rtype,
+				    int reqtype)
+{
+	struct uclogic_mock *mock = uclogic_mock_get(hdev);
+	const __u8 *req = mock->virtual_req;
+	int sent;
+	int rc;
+
+	if (reportnum != UCLOGIC_VIRTUAL_REPORT_ID ||
+	    rtype != HID_FEATURE_REPORT || len != UCLOGIC_VIRTUAL_REPORT_SIZE)
+		return -EIO;
+	if (reqtype == HID_REQ_SET_REPORT) {
+		memcpy(mock->virtual_req, buf, len);
+		return len;
+	}
+
+	memset(buf, 0, len);
+	switch (req[1]) {
+	case UCLOGIC_VIRTUAL_REQ_IFACE:
+		rc = uclogic_mock_get_iface(hdev, &buf[3], &buf[4]);
+		if (rc == 0)
+			rc = 2;
+		break;
+	case UCLOGIC_VIRTUAL_REQ_STR_DESC:
+		rc = uclogic_mock_get_str_desc(hdev, req[2], buf + 3,
+					       UCLOGIC_VIRTUAL_DATA_MAX);
+		break;
+	case UCLOGIC_VIRTUAL_REQ_STRING:
+		rc = uclogic_mock_get_string(hdev, req[2], buf + 3,
+					     UCLOGIC_VIRTUAL_DATA_MAX);
+		break;
+	case UCLOGIC_VIRTUAL_REQ_INTERRUPT:
+		rc = uclogic_mock_send_interrupt(hdev, req[2],
+						 (__u8 *)req + 4, req[3],
+						 &sent);
+		break;
+	case UCLOGIC_VIRTUAL_REQ_PRODUCT:
+		rc = uclogic_mock_get_product(hdev, buf + 3,
+					      UCLOGIC_VIRTUAL_DATA_MAX);
+		break;
+	default:
+		rc = -EINVAL;
+	}
+	buf[0] = UCLOGIC_VIRTUAL_REPORT_ID;
+	if (rc < 0)
+		buf[1] = -rc;
+	else
+		buf[2] = rc;
+	return len;
+}
+
+static struct hid_ll_driver uclogic_mock_ll_driver = {
+	.raw_request = uclogic_mock_raw_request,
+};
+
+/* Pen v1 parameters: 40000x25000, 2048 levels, 4000 LPI */
+static const __u8 uclogic_mock_pen_v1[] = {
+	0x0c, 0x03, 0x40, 0x9c, 0xa8, 0x61, 0x00, 0x00,
+	0xff, 0x07, 0xa0, 0x0f,
+};
+
+/* Pen v2 parameters of the Huion HS610, with a touch ring */
+static const __u8 uclogic_mock_pen_v2_touch_ring[] = {
+	0x13, 0x03, 0x70, 0xc6, 0x00, 0x06, 0x7c, 0x00,
+	0xff, 0x1f, 0xd8, 0x13, 0x03, 0x0d, 0x10, 0x01,
+	0x04, 0x3c, 0x3e,
+};
+
+/* Pen v2 parameters of a model with a touch strip */
+static const __u8 uclogic_mock_pen_v2_touch_strip[] = {
+	0x12, 0x03, 0x40, 0x9c, 0x00, 0xa8, 0x61, 0x00,
+	0xff, 0x1f, 0xa0, 0x0f, 0x00, 0x08, 0x00, 0x00,
+	0x00, 0x00,
+};
+
+/* UGEE v2 parameters of the XP-PEN Deco L, with frame buttons */
+static const __u8 uclogic_mock_ugee_v2_buttons[] = {
+	0x0e, 0x03, 0x70, 0xb2, 0x10, 0x77, 0x08, 0x00,
+	0xff, 0x1f, 0xd8, 0x13,
+};
+
+/* UGEE v2 parameters of the Parblo A610 PRO, with a dial */
+static const __u8 uclogic_mock_ugee_v2_dial[] = {
+	0x0e, 0x03, 0x96, 0xc7, 0xf9, 0x7c, 0x09, 0x01,
+	0xff, 0x1f, 0xd8, 0x13,
+};
+
+static const char uclogic_mock_huion_fw[] = "HUION_T21j_221221";
+static const char uclogic_mock_huion_fw_transition[] = "HUION_T153_160607";
+static const char uclogic_mock_frame_v1_on[] = "HK On";
+
+static const struct uclogic_mock_xfer uclogic_mock_pen_v1_xfers[] = {
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 100,
+			      uclogic_mock_pen_v1),
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_pen_v1_err_xfers[] = {
+	{ .type = UCLOGIC_MOCK_STR_DESC, .idx = 100, .err = -EIO },
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_huion_ring_xfers[] = {
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STRING, 201,
+			      uclogic_mock_huion_fw),
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 200,
+			      uclogic_mock_pen_v2_touch_ring),
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_huion_strip_xfers[] = {
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STRING, 201,
+			      uclogic_mock_huion_fw),
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 200,
+			      uclogic_mock_pen_v2_touch_strip),
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_huion_v1_xfers[] = {
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STRING, 201,
+			      uclogic_mock_huion_fw_transition),
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 100,
+			      uclogic_mock_pen_v1),
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STRING, 123,
+			      uclogic_mock_frame_v1_on),
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_huion_timeout_xfers[] = {
+	{ .type = UCLOGIC_MOCK_STRING, .idx = 201, .err = -ETIMEDOUT,
+	  .delay_ms = 20 },
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_ugee_v2_buttons_xfers[] = {
+	{ .type = UCLOGIC_MOCK_INTERRUPT, .idx = 0x03 },
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 100,
+			      uclogic_mock_ugee_v2_buttons),
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_ugee_v2_dial_xfers[] = {
+	{ .type = UCLOGIC_MOCK_INTERRUPT, .idx = 0x03 },
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 100,
+			      uclogic_mock_ugee_v2_dial),
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_ugee_v2_slow_xfers[] = {
+	{ .type = UCLOGIC_MOCK_INTERRUPT, .idx = 0x03, .delay_ms = 20 },
+	{ .type = UCLOGIC_MOCK_STR_DESC, .idx = 100, .delay_ms = 20,
+	  .data = uclogic_mock_ugee_v2_buttons,
+	  .size = sizeof(uclogic_mock_ugee_v2_buttons) },
+};
+
+static const struct uclogic_mock_xfer uclogic_mock_ugee_v2_stall_xfers[] = {
+	{ .type = UCLOGIC_MOCK_INTERRUPT, .idx = 0x03, .err = -EPIPE },
+};
+
+#define UCLOGIC_MOCK_XFERS(_name) \
+	.xfers = uclogic_mock_##_name##_xfers, \
+	.num_xfers = ARRAY_SIZE(uclogic_mock_##_name##_xfers)
+
+/* An interface for each branch of uclogic_params_init() */
+static const struct uclogic_mock_iface uclogic_mock_ifaces[] = {
+	{
+		.name = "unknown",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = 0xffff,
+		.num_ifaces = 1,
+	},
+	{
+		.name = "pf1209",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_PF1209,
+		.num_ifaces = 1,
+		.rsize = UCLOGIC_RDESC_PF1209_ORIG_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "wp4030u",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_WP4030U,
+		.num_ifaces = 1,
+		.rsize = UCLOGIC_RDESC_WPXXXXU_ORIG_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "wp5540u_v1",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_WP5540U,
+		.num_ifaces = 1,
+		.rsize = UCLOGIC_RDESC_WPXXXXU_ORIG_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "wp5540u_v2",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_WP5540U,
+		.num_ifaces = 1,
+		.rsize = UCLOGIC_RDESC_WP5540U_V2_ORIG_SIZE,
+		UCLOGIC_MOCK_XFERS(pen_v1),
+		.pen = true,
+		.ctrl_xfers = 1,
+	},
+	{
+		.name = "wp8060u",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_WP8060U,
+		.num_ifaces = 1,
+		.rsize = UCLOGIC_RDESC_WPXXXXU_ORIG_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "wp1062",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_WP1062,
+		.num_ifaces = 1,
+		.rsize = UCLOGIC_RDESC_WP1062_ORIG_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "twhl850_if2",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_WIRELESS_TABLET_TWHL850,
+		.ifnum = 2,
+		.num_ifaces = 3,
+		.rsize = UCLOGIC_RDESC_TWHL850_ORIG2_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "twha60_if1",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_TWHA60,
+		.ifnum = 1,
+		.num_ifaces = 2,
+		.rsize = UCLOGIC_RDESC_TWHA60_ORIG1_SIZE,
+		.desc = true,
+	},
+	{
+		.name = "twha60_3_ifaces",
+		.vendor = USB_VENDOR_ID_UCLOGIC,
+		.product = USB_DEVICE_ID_UCLOGIC_TABLET_TWHA60,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(huion_strip),
+		.pen = true,
+		.frames = 4,
+		.ctrl_xfers = 2,
+	},
+	{
+		.name = "huion_v2_touch_ring",
+		.vendor = USB_VENDOR_ID_HUION,
+		.product = USB_DEVICE_ID_HUION_TABLET,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(huion_ring),
+		.pen = true,
+		.frames = 4,
+		.ctrl_xfers = 2,
+	},
+	{
+		.name = "huion_v1",
+		.vendor = USB_VENDOR_ID_HUION,
+		.product = USB_DEVICE_ID_HUION_TABLET,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(huion_v1),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 3,
+	},
+	{
+		.name = "huion_not_found",
+		.vendor = USB_VENDOR_ID_HUION,
+		.product = USB_DEVICE_ID_HUION_TABLET,
+		.num_ifaces = 3,
+		.invalid = true,
+		.ctrl_xfers = 3,
+	},
+	{
+		.name = "huion_keyboard",
+		.vendor = USB_VENDOR_ID_HUION,
+		.product = USB_DEVICE_ID_HUION_TABLET,
+		.ifnum = 1,
+		.num_ifaces = 3,
+		.pen_usage_invalid = true,
+	},
+	{
+		.name = "huion_timeout",
+		.vendor = USB_VENDOR_ID_HUION,
+		.product = USB_DEVICE_ID_HUION_TABLET,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(huion_timeout),
+		.res = -ETIMEDOUT,
+		.ctrl_xfers = 1,
+	},
+	{
+		.name = "ugtizer_gp0610",
+		.vendor = USB_VENDOR_ID_UGTIZER,
+		.product = USB_DEVICE_ID_UGTIZER_TABLET_GP0610,
+		.ifnum = 1,
+		.num_ifaces = 2,
+		UCLOGIC_MOCK_XFERS(pen_v1),
+		.pen = true,
+		.ctrl_xfers = 1,
+	},
+	{
+		.name = "ugtizer_gp0610_if0",
+		.vendor = USB_VENDOR_ID_UGTIZER,
+		.product = USB_DEVICE_ID_UGTIZER_TABLET_GP0610,
+		.num_ifaces = 2,
+		.invalid = true,
+	},
+	{
+		.name = "ugtizer_gp0610_error",
+		.vendor = USB_VENDOR_ID_UGTIZER,
+		.product = USB_DEVICE_ID_UGTIZER_TABLET_GP0610,
+		.ifnum = 1,
+		.num_ifaces = 2,
+		UCLOGIC_MOCK_XFERS(pen_v1_err),
+		.res = -EIO,
+		.ctrl_xfers = 1,
+	},
+	{
+		.name = "deco01",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO01,
+		.ifnum = 1,
+		.num_ifaces = 2,
+		UCLOGIC_MOCK_XFERS(pen_v1),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 1,
+	},
+	{
+		.name = "ugee_v2_buttons",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO_L,
+		.product_str = "Deco L",
+		.ifnum = 2,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(ugee_v2_buttons),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 1,
+		.intr_xfers = 1,
+	},
+	{
+		.name = "ugee_v2_battery",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO_L,
+		.product_str = "Deco LW",
+		.ifnum = 2,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(ugee_v2_buttons),
+		.pen = true,
+		.frames = 2,
+		.event_hooks = true,
+		.ctrl_xfers = 1,
+		.intr_xfers = 1,
+	},
+	{
+		.name = "ugee_v2_dial",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_PARBLO_A610_PRO,
+		.ifnum = 2,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(ugee_v2_dial),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 1,
+		.intr_xfers = 1,
+	},
+	{
+		.name = "ugee_v2_mouse",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO_L,
+		.num_ifaces = 3,
+		.frames = 1,
+	},
+	{
+		.name = "ugee_v2_slow",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO_L,
+		.ifnum = 2,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(ugee_v2_slow),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 1,
+		.intr_xfers = 1,
+	},
+	{
+		.name = "ugee_v2_stall",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO_L,
+		.ifnum = 2,
+		.num_ifaces = 3,
+		UCLOGIC_MOCK_XFERS(ugee_v2_stall),
+		.invalid = true,
+		.intr_xfers = 1,
+	},
+	{
+		.name = "ugee_g5",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_TABLET_G5,
+		.ifnum = 1,
+		.num_ifaces = 2,
+		UCLOGIC_MOCK_XFERS(pen_v1),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 1,
+	},
+	{
+		.name = "ugee_ex07s",
+		.vendor = USB_VENDOR_ID_UGEE,
+		.product = USB_DEVICE_ID_UGEE_TABLET_EX07S,
+		.ifnum = 1,
+		.num_ifaces = 2,
+		UCLOGIC_MOCK_XFERS(pen_v1),
+		.pen = true,
+		.frames = 1,
+		.ctrl_xfers = 1,
+	},
+};
+
+static void uclogic_mock_iface_desc(const struct uclogic_mock_iface *iface,
+				    char *desc)
+{
+	strscpy(desc, iface->name, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(uclogic_mock, uclogic_mock_ifaces, uclogic_mock_iface_desc);
+
+/* Find a scripted tablet interface by name, NULL if not found */
+static const struct uclogic_mock_iface *uclogic_mock_iface_find(
+							const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(uclogic_mock_ifaces); i++)
+		if (strcmp(uclogic_mock_ifaces[i].name, name) == 0)
+			return &uclogic_mock_ifaces[i];
+	return NULL;
+}
+
+/* Create the HID device of a scripted tablet interface, NULL on failure */
+static struct hid_device *uclogic_mock_hdev(struct kunit *test,
+					const struct uclogic_mock_iface *iface)
+{
+	struct uclogic_mock *mock;
+	struct hid_device *hdev;
+
+	hdev = kunit_kzalloc(test, sizeof(*hdev), GFP_KERNEL);
+	mock = kunit_kzalloc(test, sizeof(*mock), GFP_KERNEL);
+	if (hdev == NULL || mock == NULL)
+		return NULL;
+
+	hdev->bus = BUS_USB;
+	hdev->vendor = iface->vendor;
+	hdev->product = iface->product;
+	hdev->dev_rsize = iface->rsize;
+	mock->iface = iface;
+	mock->drvdata.hdev = hdev;
+	mock->drvdata.transport = &uclogic_transport_mock;
+	hid_set_drvdata(hdev, &mock->drvdata);
+	return hdev;
+}
+
+static unsigned int uclogic_mock_frames(const struct uclogic_params *params)
+{
+	unsigned int frames = 0;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(params->frame_list); i++)
+		frames += params->frame_list[i].desc_ptr != NULL;
+	return frames;
+}
+
+static void hid_test_uclogic_params_init(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface = test->param_value;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+	u64 start_ns, ns, transfer_ns;
+	int rc;
+
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+
+	start_ns = ktime_get_ns();
+	rc = uclogic_params_init(params, hdev);
+	ns = ktime_get_ns() - start_ns;
+
+	KUNIT_EXPECT_EQ(test, rc, iface->res);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, iface->ctrl_xfers);
+	KUNIT_EXPECT_EQ(test, mock->intr_xfers, iface->intr_xfers);
+	KUNIT_EXPECT_GE(test, ns, (u64)mock->delay_ms * NSEC_PER_MSEC);
+	/* The transfer delays are attributed to the transfer phases */
+	transfer_ns = mock->drvdata.probe_ns[UCLOGIC_PROBE_PHASE_STRING] +
+		mock->drvdata.probe_ns[UCLOGIC_PROBE_PHASE_STR_DESC] +
+		mock->drvdata.probe_ns[UCLOGIC_PROBE_PHASE_INTERRUPT];
+	KUNIT_EXPECT_GE(test, transfer_ns,
+			(u64)mock->delay_ms * NSEC_PER_MSEC);
+	KUNIT_EXPECT_LE(test, transfer_ns, ns);
+	if (rc != 0)
+		return;
+
+	KUNIT_EXPECT_EQ(test, params->invalid, iface->invalid);
+	KUNIT_EXPECT_EQ(test, params->desc_ptr != NULL, iface->desc);
+	KUNIT_EXPECT_EQ(test, params->pen.desc_ptr != NULL, iface->pen);
+	KUNIT_EXPECT_EQ(test, params->pen.usage_invalid,
+			iface->pen_usage_invalid);
+	KUNIT_EXPECT_EQ(test, uclogic_mock_frames(params), iface->frames);
+	KUNIT_EXPECT_EQ(test, params->event_hooks != NULL, iface->event_hooks);
+	uclogic_params_cleanup(params);
+}
+
+/*
+ * Check the virtual tablet transport discovers the same parameters over the
+ * handshake.
+ */
+static void hid_test_uclogic_params_init_virtual(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface = test->param_value;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+	int rc;
+
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+	hdev->bus = BUS_VIRTUAL;
+	hdev->ll_driver = &uclogic_mock_ll_driver;
+	mock->drvdata.transport = &uclogic_transport_virtual;
+	mock->no_delay = true;
+
+	rc = uclogic_params_init(params, hdev);
+	KUNIT_EXPECT_EQ(test, rc, iface->res);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, iface->ctrl_xfers);
+	KUNIT_EXPECT_EQ(test, mock->intr_xfers, iface->intr_xfers);
+	if (rc != 0)
+		return;
+
+	KUNIT_EXPECT_EQ(test, params->invalid, iface->invalid);
+	KUNIT_EXPECT_EQ(test, params->desc_ptr != NULL, iface->desc);
+	KUNIT_EXPECT_EQ(test, params->pen.desc_ptr != NULL, iface->pen);
+	KUNIT_EXPECT_EQ(test, uclogic_mock_frames(params), iface->frames);
+	uclogic_params_cleanup(params);
+}
+
+/* Transfers in the order they must be made, as logged by the mock */
+struct uclogic_mock_order {
+	const char *iface;
+	unsigned int num;
+	unsigned int log[8];
+};
+
+#define UCLOGIC_MOCK_LOG(_type, _idx) (UCLOGIC_MOCK_##_type << 8 | (_idx))
+
+static const struct uclogic_mock_order uclogic_mock_orders[] = {
+	{
+		.iface = "huion_v2_touch_ring",
+		.num = 2,
+		.log = {
+			UCLOGIC_MOCK_LOG(STRING, 201),
+			UCLOGIC_MOCK_LOG(STR_DESC, 200),
+		},
+	},
+	{
+		/* The transition firmware: no #200 read */
+		.iface = "huion_v1",
+		.num = 3,
+		.log = {
+			UCLOGIC_MOCK_LOG(STRING, 201),
+			UCLOGIC_MOCK_LOG(STR_DESC, 100),
+			UCLOGIC_MOCK_LOG(STRING, 123),
+		},
+	},
+	{
+		/* #200 not found: falling back to v1, no buttons */
+		.iface = "huion_not_found",
+		.num = 3,
+		.log = {
+			UCLOGIC_MOCK_LOG(STRING, 201),
+			UCLOGIC_MOCK_LOG(STR_DESC, 200),
+			UCLOGIC_MOCK_LOG(STR_DESC, 100),
+		},
+	},
+	{
+		.iface = "ugee_v2_buttons",
+		.num = 2,
+		.log = {
+			UCLOGIC_MOCK_LOG(INTERRUPT, 0x03),
+			UCLOGIC_MOCK_LOG(STR_DESC, 100),
+		},
+	},
+	{
+		/* No parameters read, if the magic data isn't accepted */
+		.iface = "ugee_v2_stall",
+		.num = 1,
+		.log = {
+			UCLOGIC_MOCK_LOG(INTERRUPT, 0x03),
+		},
+	},
+};
+
+static void uclogic_mock_order_desc(const struct uclogic_mock_order *order,
+				    char *desc)
+{
+	strscpy(desc, order->iface, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(uclogic_mock_order, uclogic_mock_orders,
+		  uclogic_mock_order_desc);
+
+/*
+ * Check the mode-switching transfers are made one after another, in the
+ * order the tablets need them.
+ */
+static void hid_test_uclogic_params_init_order(struct kunit *test)
+{
+	const struct uclogic_mock_order *order = test->param_value;
+	const struct uclogic_mock_iface *iface;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	unsigned int i;
+
+	iface = uclogic_mock_iface_find(order->iface);
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	mock->no_delay = true;
+
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(&mock->drvdata.params, hdev),
+			0);
+	uclogic_params_cleanup(&mock->drvdata.params);
+	KUNIT_ASSERT_EQ(test, mock->log_len, order->num);
+	for (i = 0; i < order->num; i++)
+		KUNIT_EXPECT_EQ_MSG(test, mock->log[i], order->log[i],
+				    "transfer #%u", i);
+}
+
+/*
+ * Check replaying the enabling transfers re-enables an interface with
+ * only the transfers which enable it.
+ */
+static void hid_test_uclogic_params_resume(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface = test->param_value;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+	int rc;
+
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+	mock->no_delay = true;
+
+	rc = uclogic_params_init(params, hdev);
+	KUNIT_ASSERT_EQ(test, rc, iface->res);
+	if (rc != 0) {
+		/* Nothing to replay, the parameters must be discovered */
+		KUNIT_EXPECT_EQ(test, uclogic_params_resume(hdev), -ESTALE);
+		return;
+	}
+	uclogic_params_cleanup(params);
+
+	mock->ctrl_xfers = 0;
+	mock->intr_xfers = 0;
+	KUNIT_EXPECT_EQ(test, uclogic_params_resume(hdev), 0);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers + mock->intr_xfers,
+			mock->drvdata.enable.num);
+	KUNIT_EXPECT_LE(test, mock->ctrl_xfers, iface->ctrl_xfers);
+	KUNIT_EXPECT_EQ(test, mock->intr_xfers, iface->intr_xfers);
+}
+
+/*
+ * Check replaying the enabling transfers fails, if the tablet answers them
+ * differently, and succeeds again once the parameters are rediscovered.
+ */
+static void hid_test_uclogic_params_resume_changed(struct kunit *test)
+{
+	const struct uclogic_mock_iface *buttons, *dial;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+
+	buttons = uclogic_mock_iface_find("ugee_v2_buttons");
+	dial = uclogic_mock_iface_find("ugee_v2_dial");
+	KUNIT_ASSERT_NOT_NULL(test, buttons);
+	KUNIT_ASSERT_NOT_NULL(test, dial);
+	hdev = uclogic_mock_hdev(test, buttons);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(params, hdev), 0);
+	uclogic_params_cleanup(params);
+	KUNIT_EXPECT_EQ(test, mock->drvdata.enable.num, 2);
+
+	/* Answer with the parameters of a different tablet */
+	mock->iface = dial;
+	KUNIT_EXPECT_EQ(test, uclogic_params_resume(hdev), -ESTALE);
+
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(params, hdev), 0);
+	uclogic_params_cleanup(params);
+	KUNIT_EXPECT_EQ(test, uclogic_params_resume(hdev), 0);
+}
+
+/*
+ * Check the pens without in-range reporting get a proximity-out signature,
+ * and the ones with it don't need one.
+ */
+static void hid_test_uclogic_params_init_proximity_out(struct kunit *test)
+{
+	static const struct {
+		const char *iface;
+		enum uclogic_params_pen_inrange inrange;
+		bool proximity_out;
+	} cases[] = {
+		{ "huion_v2_touch_ring", UCLOGIC_PARAMS_PEN_INRANGE_NONE, true },
+		{ "ugee_v2_buttons", UCLOGIC_PARAMS_PEN_INRANGE_NORMAL, false },
+	};
+	const struct uclogic_mock_iface *iface;
+	const struct uclogic_params_pen *pen;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		iface = uclogic_mock_iface_find(cases[i].iface);
+		KUNIT_ASSERT_NOT_NULL(test, iface);
+		hdev = uclogic_mock_hdev(test, iface);
+		KUNIT_ASSERT_NOT_NULL(test, hdev);
+		mock = uclogic_mock_get(hdev);
+		mock->no_delay = true;
+		KUNIT_ASSERT_EQ(test,
+				uclogic_params_init(&mock->drvdata.params,
+						    hdev),
+				0);
+		pen = &mock->drvdata.params.pen;
+		KUNIT_EXPECT_EQ_MSG(test, pen->inrange, cases[i].inrange,
+				    "%s", cases[i].iface);
+		KUNIT_EXPECT_EQ_MSG(test,
+				    pen->proximity_out_list[0].byte != 0,
+				    cases[i].proximity_out,
+				    "%s", cases[i].iface);
+		uclogic_params_cleanup(&mock->drvdata.params);
+	}
+}
+
+/* A Huion tablet failing to return its firmware version once */
+static const struct uclogic_mock_xfer uclogic_mock_huion_flaky_xfers[] = {
+	{ .type = UCLOGIC_MOCK_STRING, .idx = 201, .err = -EPROTO,
+	  .err_times = 1, .data = uclogic_mock_huion_fw,
+	  .size = sizeof(uclogic_mock_huion_fw) },
+	UCLOGIC_MOCK_RESPONSE(UCLOGIC_MOCK_STR_DESC, 200,
+			      uclogic_mock_pen_v2_touch_ring),
+};
+
+static const struct uclogic_mock_iface uclogic_mock_huion_flaky = {
+	.name = "huion_flaky",
+	.vendor = USB_VENDOR_ID_HUION,
+	.product = USB_DEVICE_ID_HUION_TABLET,
+	.num_ifaces = 3,
+	UCLOGIC_MOCK_XFERS(huion_flaky),
+};
+
+/*
+ * Check transfers failing transiently are retried as many times as
+ * configured, and no more.
+ */
+static void hid_test_uclogic_params_init_retry(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+
+	hdev = uclogic_mock_hdev(test, &uclogic_mock_huion_flaky);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+	mock->drvdata.xfer_retries = 1;
+
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(params, hdev), 0);
+	KUNIT_EXPECT_NOT_NULL(test, params->pen.desc_ptr);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, 3);
+	KUNIT_EXPECT_EQ(test, mock->drvdata.probe_retries, 1);
+	uclogic_params_cleanup(params);
+
+	/* A transfer failing every time is given up on */
+	iface = uclogic_mock_iface_find("huion_timeout");
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	mock->no_delay = true;
+	mock->drvdata.xfer_retries = 2;
+
+	KUNIT_EXPECT_EQ(test, uclogic_params_init(&mock->drvdata.params, hdev),
+			-ETIMEDOUT);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, 3);
+	KUNIT_EXPECT_EQ(test, mock->drvdata.probe_retries, 2);
+	KUNIT_EXPECT_FALSE(test, mock->drvdata.probe_over_budget);
+}
+
+/*
+ * Check no transfers are made once the probe is out of time, and the
+ * interface is given up on instead.
+ */
+static void hid_test_uclogic_params_init_budget(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+
+	iface = uclogic_mock_iface_find("ugee_v2_slow");
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+	/* Less than the magic data takes to send */
+	mock->drvdata.probe_deadline = ktime_get_ns() + 10 * NSEC_PER_MSEC;
+	mock->drvdata.xfer_retries = 2;
+
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(params, hdev), 0);
+	KUNIT_EXPECT_TRUE(test, params->invalid);
+	KUNIT_EXPECT_EQ(test, mock->intr_xfers, 1);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, 0);
+	KUNIT_EXPECT_TRUE(test, mock->drvdata.probe_over_budget);
+	KUNIT_EXPECT_FALSE(test, mock->drvdata.enable.valid);
+	uclogic_params_cleanup(params);
+}
+
+/* A Huion tablet never answering the firmware version read */
+static const struct uclogic_mock_xfer uclogic_mock_huion_hang_xfers[] = {
+	{ .type = UCLOGIC_MOCK_STRING, .idx = 201, .delay_ms = 60000,
+	  .data = uclogic_mock_huion_fw,
+	  .size = sizeof(uclogic_mock_huion_fw) },
+};
+
+static const struct uclogic_mock_iface uclogic_mock_huion_hang = {
+	.name = "huion_hang",
+	.vendor = USB_VENDOR_ID_HUION,
+	.product = USB_DEVICE_ID_HUION_TABLET,
+	.num_ifaces = 3,
+	UCLOGIC_MOCK_XFERS(huion_hang),
+};
+
+/*
+ * Check a string read which never completes is cut short to the time left
+ * for the probe, and isn't retried past it.
+ */
+static void hid_test_uclogic_params_init_budget_hang(struct kunit *test)
+{
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	u64 start;
+	u64 ns;
+
+	hdev = uclogic_mock_hdev(test, &uclogic_mock_huion_hang);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	mock->drvdata.ctrl_timeout_ms = 1000;
+	mock->drvdata.xfer_retries = 2;
+	start = ktime_get_ns();
+	mock->drvdata.probe_deadline = start + 50 * NSEC_PER_MSEC;
+
+	KUNIT_EXPECT_EQ(test, uclogic_params_init(&mock->drvdata.params, hdev),
+			-ETIMEDOUT);
+	ns = ktime_get_ns() - start;
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, 1);
+	KUNIT_EXPECT_LE(test, mock->delay_ms, 51);
+	KUNIT_EXPECT_TRUE(test, mock->drvdata.probe_over_budget);
+	/* Well within the control transfer timeout */
+	KUNIT_EXPECT_LT(test, ns, 500 * NSEC_PER_MSEC);
+}
+
+/*
+ * Check the parameters discovered on probe are reused when the same tablet
+ * is probed again, without the discovery read.
+ */
+static void hid_test_uclogic_params_cache(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+	unsigned int i;
+
+	iface = uclogic_mock_iface_find("ugee_v2_buttons");
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+
+	for (i = 0; i < 2; i++) {
+		hdev = uclogic_mock_hdev(test, iface);
+		KUNIT_ASSERT_NOT_NULL(test, hdev);
+		mock = uclogic_mock_get(hdev);
+		params = &mock->drvdata.params;
+
+		KUNIT_ASSERT_EQ(test, uclogic_params_init(params, hdev), 0);
+		KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, i == 0 ? 1 : 0);
+		KUNIT_EXPECT_EQ(test, mock->intr_xfers, 1);
+		KUNIT_EXPECT_NOT_NULL(test, params->pen.desc_ptr);
+		KUNIT_EXPECT_EQ(test, uclogic_mock_frames(params),
+				iface->frames);
+		uclogic_params_cleanup(params);
+	}
+
+	/* Models sharing the product ID are told apart */
+	iface = uclogic_mock_iface_find("ugee_v2_battery");
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(&mock->drvdata.params, hdev),
+			0);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, 1);
+	uclogic_params_cleanup(&mock->drvdata.params);
+}
+
+/*
+ * Check the parameters cache can be seeded by the user, and read back in
+ * the same format.
+ */
+static void hid_test_uclogic_params_cache_set(struct kunit *test)
+{
+	static const char entry[] =
+		"28bd:0935:2:0e0370b210770800ff1fd813:Deco L\n";
+	const struct uclogic_mock_iface *iface;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	char *buf;
+
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set("28bd"), -EINVAL);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set("28bd:0935:2:0e0:X"),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set("28bd:0935:2:zz:X"),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set("28bd:0935:2:0e03"),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set(entry), 0);
+
+	buf = kunit_kzalloc(test, PAGE_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_show(buf, PAGE_SIZE),
+			(int)strlen(entry));
+	KUNIT_EXPECT_STREQ(test, buf, entry);
+
+	iface = uclogic_mock_iface_find("ugee_v2_buttons");
+	KUNIT_ASSERT_NOT_NULL(test, iface);
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	KUNIT_ASSERT_EQ(test, uclogic_params_init(&mock->drvdata.params, hdev),
+			0);
+	KUNIT_EXPECT_EQ(test, mock->ctrl_xfers, 0);
+	uclogic_params_cleanup(&mock->drvdata.params);
+
+	/* An empty entry clears the cache */
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set(""), 0);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_show(buf, PAGE_SIZE), 0);
+}
+
+/*
+ * Check the parameters cache can be seeded with several entries at once,
+ * as on the module command line, all or none of them.
+ */
+static void hid_test_uclogic_params_cache_set_list(struct kunit *test)
+{
+	static const char entries[] =
+		"28bd:0935:2:0e0370b210770800ff1fd813:Deco L\n"
+		"28bd:0935:2:0e0396c7f97c0901ff1fd813:A610 PRO\n";
+	char *buf;
+
+	buf = kunit_kzalloc(test, PAGE_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+
+	/* Nothing is added, if any entry is invalid */
+	KUNIT_EXPECT_EQ(test,
+			uclogic_params_cache_set(
+				"28bd:0935:2:0e0370b210770800ff1fd813:Deco L,"
+				"28bd:0935:2:zz:X"),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_show(buf, PAGE_SIZE), 0);
+
+	/* Separated by commas, with an empty entry */
+	KUNIT_EXPECT_EQ(test,
+			uclogic_params_cache_set(
+				"28bd:0935:2:0e0370b210770800ff1fd813:Deco L,,"
+				"28bd:0935:2:0e0396c7f97c0901ff1fd813:A610 PRO"),
+			0);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_show(buf, PAGE_SIZE),
+			(int)strlen(entries));
+	KUNIT_EXPECT_STREQ(test, buf, entries);
+
+	/* Separated by newlines, as read back */
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set("\n"), 0);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_show(buf, PAGE_SIZE), 0);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_set(entries), 0);
+	KUNIT_EXPECT_EQ(test, uclogic_params_cache_show(buf, PAGE_SIZE),
+			(int)strlen(entries));
+	KUNIT_EXPECT_STREQ(test, buf, entries);
+}
+
+/* Number of times to initialize each benchmarked interface */
+#define UCLOGIC_PROBE_BENCH_PROBES	4096
+
+/* Task whose allocations are being counted, NULL if none */
+static struct task_struct *uclogic_probe_bench_task;
+/* Number of allocations made by the task */
+static unsigned int uclogic_probe_bench_allocs;
+
+static void uclogic_probe_bench_kmalloc(void *data, unsigned long call_site,
+					const void *ptr, size_t bytes_req,
+					size_t bytes_alloc, gfp_t gfp_flags
+#if KERNEL_VERSION(6, 1, 0) <= LINUX_VERSION_CODE
+					, int node
+#endif
+					)
+{
+	if (ptr != NULL && in_task() &&
+	    current == READ_ONCE(uclogic_probe_bench_task))
+		uclogic_probe_bench_allocs++;
+}
+
+/*
+ * Benchmark initializing a scripted tablet interface, with immediate
+ * responses. Report the time taken, and the allocations and transfers made
+ * per initialization, as a "uclogic_bench" line of space-separated
+ * key=value pairs. The allocations are counted with the kmalloc
+ * tracepoint, and reported as "?" if it's not available.
+ */
+static void hid_test_uclogic_params_init_bench(struct kunit *test)
+{
+	const struct uclogic_mock_iface *iface = test->param_value;
+	struct hid_device *hdev;
+	struct uclogic_mock *mock;
+	struct uclogic_params *params;
+	char allocs[16] = "?";
+	unsigned int n;
+	u64 start_ns;
+	u64 ns = 0;
+	int tp_rc;
+	int rc;
+
+	hdev = uclogic_mock_hdev(test, iface);
+	KUNIT_ASSERT_NOT_NULL(test, hdev);
+	mock = uclogic_mock_get(hdev);
+	params = &mock->drvdata.params;
+
+	mock->no_delay = true;
+	uclogic_probe_bench_allocs = 0;
+	WRITE_ONCE(uclogic_probe_bench_task, current);
+	tp_rc = register_trace_kmalloc(uclogic_probe_bench_kmalloc, NULL);
+
+	for (n = 0; n < UCLOGIC_PROBE_BENCH_PROBES; n++) {
+		start_ns = ktime_get_ns();
+		rc = uclogic_params_init(params, hdev);
+		ns += ktime_get_ns() - start_ns;
+		if (rc != iface->res)
+			break;
+		if (rc == 0)
+			uclogic_params_cleanup(params);
+		cond_resched();
+	}
+
+	WRITE_ONCE(uclogic_probe_bench_task, NULL);
+	if (tp_rc == 0) {
+		unregister_trace_kmalloc(uclogic_probe_bench_kmalloc, NULL);
+		tracepoint_synchronize_unregister();
+	}
+	KUNIT_ASSERT_EQ(test, rc, iface->res);
+
+	/* Cleanup allocates nothing, so every probe allocates the same */
+	if (tp_rc == 0)
+		snprintf(allocs, sizeof(allocs), "%u",
+			 uclogic_probe_bench_allocs / UCLOGIC_PROBE_BENCH_PROBES);
+	kunit_info(test,
+		   "uclogic_bench probe=%s probes=%u ns=%llu ns_per_probe=%llu.%03llu allocs_per_probe=%s ctrl_xfers_per_probe=%u intr_xfers_per_probe=%u\n",
+		   iface->name, UCLOGIC_PROBE_BENCH_PROBES, ns,
+		   div_u64(ns, UCLOGIC_PROBE_BENCH_PROBES),
+		   div_u64((ns % UCLOGIC_PROBE_BENCH_PROBES) * 1000,
+			   UCLOGIC_PROBE_BENCH_PROBES),
+		   allocs,
+		   mock->ctrl_xfers / UCLOGIC_PROBE_BENCH_PROBES,
+		   mock->intr_xfers / UCLOGIC_PROBE_BENCH_PROBES);
+}
+
+/* Start each test with an empty parameters cache */
+static int hid_test_uclogic_params_init_case(struct kunit *test)
+{
+	uclogic_params_cache_clear();
+	return 0;
+}
+
 static struct kunit_case hid_uclogic_params_test_cases[] = {
 	KUNIT_CASE_PARAM(hid_test_uclogic_parse_ugee_v2_desc,
 			 uclogic_parse_ugee_v2_desc_gen_params),
 	KUNIT_CASE(hid_test_uclogic_params_cleanup_event_hooks),
+	KUNIT_CASE(hid_test_uclogic_params_get_raw),
+	KUNIT_CASE_PARAM(hid_test_uclogic_params_init,
+			 uclogic_mock_gen_params),
+	KUNIT_CASE_PARAM(hid_test_uclogic_params_init_virtual,
+			 uclogic_mock_gen_params),
+	KUNIT_CASE_PARAM(hid_test_uclogic_params_init_order,
+			 uclogic_mock_order_gen_params),
+	KUNIT_CASE_PARAM(hid_test_uclogic_params_resume,
+			 uclogic_mock_gen_params),
+	KUNIT_CASE(hid_test_uclogic_params_resume_changed),
+	KUNIT_CASE(hid_test_uclogic_params_init_proximity_out),
+	KUNIT_CASE(hid_test_uclogic_params_init_retry),
+	KUNIT_CASE(hid_test_uclogic_params_init_budget),
+	KUNIT_CASE(hid_test_uclogic_params_init_budget_hang),
+	KUNIT_CASE(hid_test_uclogic_params_cache),
+	KUNIT_CASE(hid_test_uclogic_params_cache_set),
+	KUNIT_CASE(hid_test_uclogic_params_cache_set_list),
 	{}
 };
 
 static struct kunit_suite hid_uclogic_params_test_suite = {
 	.name = "hid_uclogic_params_test",
+	.init = hid_test_uclogic_params_init_case,
 	.test_cases = hid_uclogic_params_test_cases,
 };
 
+static struct kunit_case hid_uclogic_params_bench_test_cases[] = {
+	KUNIT_CASE_PARAM_ATTR(hid_test_uclogic_params_init_bench,
+			      uclogic_mock_gen_params,
+			      { .speed = KUNIT_SPEED_SLOW }),
+	{}
+};
+
+/*
+ * Benchmark the interface initialization. Slow, skip with kunit.py's
+ * --filter "speed>slow", or run alone with "hid_uclogic_params_bench".
+ */
+static struct kunit_suite hid_uclogic_params_bench_test_suite = {
+	.name = "hid_uclogic_params_bench",
+	.init = hid_test_uclogic_params_init_case,
+	.test_cases = hid_uclogic_params_bench_test_cases,
+};
+
 kunit_test_suite(hid_uclogic_params_test_suite);
+kunit_test_suite(hid_uclogic_params_bench_test_suite);
 
 MODULE_DESCRIPTION("KUnit tests for the UC-Logic driver");
 MODULE_LICENSE("GPL");
@@ -18,6 +18,8 @@
 #include "usbhid/usbhid.h"
 #include "hid-ids.h"
 #include <linux/ctype.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
 #include <linux/string.h>
 #include <linux/version.h>
 
@@ -82,6 +84,16 @@ static void uclogic_params_pen_hid_dbg(const struct hid_device *hdev,
 		(pen->fragmented_hires ? "true" : "false"));
 	hid_dbg(hdev, "\t.tilt_y_flipped = %s\n",
 		(pen->tilt_y_flipped ? "true" : "false"));
+	hid_dbg(hdev, "\t.proximity_out_list = {\n");
+	for (i = 0; i < ARRAY_SIZE(pen->proximity_out_list); i++) {
+		hid_dbg(hdev, "\t\t{%hhu, 0x%02hhx, 0x%02hhx}%s\n",
+			pen->proximity_out_list[i].byte,
+			pen->proximity_out_list[i].mask,
+			pen->proximity_out_list[i].value,
+			i < (ARRAY_SIZE(pen->proximity_out_list) - 1) ?
+				"," : "");
+	}
+	hid_dbg(hdev, "\t}\n");
 }
 
 /**
@@ -137,6 +149,501 @@ void uclogic_params_hid_dbg(const struct hid_device *hdev,
 	hid_dbg(hdev, "}\n");
 }
 
+/**
+ * uclogic_transport_is_usb() - check if a HID device is attached via USB,
+ * i.e. is using the USB low-level driver.
+ *
+ * @hdev:	The HID device to check.
+ *
+ * Returns:
+ *	True if the device is attached via USB, or if that can't be checked.
+ */
+bool uclogic_transport_is_usb(struct hid_device *hdev)
+{
+#if KERNEL_VERSION(6, 3, 0) <= LINUX_VERSION_CODE
+	return hid_is_usb(hdev);
+#elif KERNEL_VERSION(4, 14, 0) <= LINUX_VERSION_CODE
+	return hid_is_using_ll_driver(hdev, &usb_hid_driver);
+#else
+	return true;
+#endif
+}
+
+/**
+ * uclogic_transport_usb_get_iface() - get the interface number of a USB
+ * tablet interface, and the number of interfaces in its configuration.
+ *
+ * @hdev:		The HID device of the tablet interface.
+ * @pnum:		Location for the interface number.
+ * @pnum_ifaces:	Location for the number of interfaces.
+ *
+ * Returns:
+ *	Zero, if successful. -EINVAL if the device is not a USB device.
+ */
+static int uclogic_transport_usb_get_iface(struct hid_device *hdev,
+					   __u8 *pnum, __u8 *pnum_ifaces)
+{
+	struct usb_interface *iface;
+
+	if (!uclogic_transport_is_usb(hdev))
+		return -EINVAL;
+
+	iface = to_usb_interface(hdev->dev.parent);
+	*pnum = iface->cur_altsetting->desc.bInterfaceNumber;
+	*pnum_ifaces = hid_to_usb_dev(hdev)->config->desc.bNumInterfaces;
+	return 0;
+}
+
+/**
+ * uclogic_transport_timeout() - get the timeout of a transfer to a tablet
+ * interface, cut short to fit into the time left for the probe or resume in
+ * progress.
+ *
+ * @hdev:	The HID device of the tablet interface, with struct
+ *		uclogic_drvdata attached.
+ * @timeout_ms:	The timeout of the transfer, ms, zero for the default.
+ * @default_ms:	The default timeout of the transfer, ms.
+ *
+ * Returns:
+ *	The timeout, ms, at least one.
+ */
+static int uclogic_transport_timeout(struct hid_device *hdev,
+				     unsigned int timeout_ms,
+				     unsigned int default_ms)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+	u64 now;
+
+	if (timeout_ms == 0)
+		timeout_ms = default_ms;
+	if (drvdata->probe_deadline != 0) {
+		now = ktime_get_ns();
+		if (now >= drvdata->probe_deadline)
+			return 1;
+		timeout_ms = min_t(u64, timeout_ms,
+				   div_u64(drvdata->probe_deadline - now,
+					   NSEC_PER_MSEC) + 1);
+	}
+	return timeout_ms;
+}
+
+static int uclogic_transport_usb_get_str_desc(struct hid_device *hdev,
+					      __u8 idx, __u8 *buf, size_t len)
+{
+	struct usb_device *udev = hid_to_usb_dev(hdev);
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+
+	return usb_control_msg(udev, usb_rcvctrlpipe(udev, 0),
+				USB_REQ_GET_DESCRIPTOR, USB_DIR_IN,
+				(USB_DT_STRING << 8) + idx,
+				0x0409, buf, len,
+				uclogic_transport_timeout(
+					hdev, drvdata->ctrl_timeout_ms,
+					USB_CTRL_GET_TIMEOUT));
+}
+
+/*
+ * NOTE: USB core always uses the default timeout for these, so don't start
+ * one after the time left for the probe or resume in progress ran out.
+ * A read started in time can still overrun it by that timeout.
+ */
+static int uclogic_transport_usb_get_string(struct hid_device *hdev,
+					    __u8 idx, char *buf, size_t len)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+
+	if (drvdata->probe_deadline != 0 &&
+	    ktime_get_ns() >= drvdata->probe_deadline)
+		return -ETIMEDOUT;
+	return usb_string(hid_to_usb_dev(hdev), idx, buf, len);
+}
+
+static int uclogic_transport_usb_send_interrupt(struct hid_device *hdev,
+						int endpoint, __u8 *buf,
+						size_t len, int *psent)
+{
+	struct usb_device *udev = hid_to_usb_dev(hdev);
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+
+	return usb_interrupt_msg(udev, usb_sndintpipe(udev, endpoint),
+				 buf, len, psent,
+				 uclogic_transport_timeout(
+					hdev, drvdata->intr_timeout_ms, 1000));
+}
+
+static int uclogic_transport_usb_get_product(struct hid_device *hdev,
+					     char *buf, size_t len)
+{
+	const char *product = hid_to_usb_dev(hdev)->product;
+	ssize_t rc;
+
+	if (product == NULL)
+		return -ENODATA;
+	rc = strscpy(buf, product, len);
+	return rc == -E2BIG ? strlen(buf) : rc;
+}
+
+const struct uclogic_transport uclogic_transport_usb = {
+	.get_iface = uclogic_transport_usb_get_iface,
+	.get_str_desc = uclogic_transport_usb_get_str_desc,
+	.get_string = uclogic_transport_usb_get_string,
+	.send_interrupt = uclogic_transport_usb_send_interrupt,
+	.get_product = uclogic_transport_usb_get_product,
+};
+
+/**
+ * uclogic_transport_virtual_request() - make a virtual tablet handshake
+ * request.
+ *
+ * @hdev:	The HID device of the virtual tablet interface.
+ * @req:	The request to make.
+ * @idx:	The index to make the request for.
+ * @out:	The data to send with the request. Can be NULL if "out_len"
+ *		is zero.
+ * @out_len:	Size of the data to send, up to UCLOGIC_VIRTUAL_DATA_MAX.
+ * @in:		The buffer for the answer data. Can be NULL if "in_len" is
+ *		zero.
+ * @in_len:	Size of the answer data buffer.
+ *
+ * Returns:
+ *	Number of answer data bytes retrieved (<= in_len),
+ *	-EPROTO, if the answer is malformed, or
+ *	another negative errno code, e.g. the one the tablet answered with.
+ */
+static int uclogic_transport_virtual_request(struct hid_device *hdev,
+					     __u8 req, __u8 idx,
+					     const void *out, size_t out_len,
+					     void *in, size_t in_len)
+{
+	__u8 *buf;
+	int rc;
+
+	if (out_len > UCLOGIC_VIRTUAL_DATA_MAX)
+		return -EINVAL;
+
+	buf = kzalloc(UCLOGIC_VIRTUAL_REPORT_SIZE, GFP_KERNEL);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	buf[0] = UCLOGIC_VIRTUAL_REPORT_ID;
+	buf[1] = req;
+	buf[2] = idx;
+	buf[3] = out_len;
+	if (out_len != 0)
+		memcpy(buf + 4, out, out_len);
+	rc = hid_hw_raw_request(hdev, UCLOGIC_VIRTUAL_REPORT_ID, buf,
+				UCLOGIC_VIRTUAL_REPORT_SIZE,
+				HID_FEATURE_REPORT, HID_REQ_SET_REPORT);
+	if (rc < 0)
+		goto cleanup;
+
+	rc = hid_hw_raw_request(hdev, UCLOGIC_VIRTUAL_REPORT_ID, buf,
+				UCLOGIC_VIRTUAL_REPORT_SIZE,
+				HID_FEATURE_REPORT, HID_REQ_GET_REPORT);
+	if (rc < 0)
+		goto cleanup;
+	if (rc < 3 || buf[0] != UCLOGIC_VIRTUAL_REPORT_ID ||
+	    buf[2] > rc - 3 || buf[2] > UCLOGIC_VIRTUAL_DATA_MAX) {
+		rc = -EPROTO;
+		goto cleanup;
+	}
+	if (buf[1] != 0) {
+		rc = -buf[1];
+		goto cleanup;
+	}
+
+	rc = min_t(size_t, buf[2], in_len);
+	if (rc != 0)
+		memcpy(in, buf + 3, rc);
+cleanup:
+	kfree(buf);
+	return rc;
+}
+
+static int uclogic_transport_virtual_get_iface(struct hid_device *hdev,
+					       __u8 *pnum, __u8 *pnum_ifaces)
+{
+	__u8 iface[2];
+	int rc;
+
+	rc = uclogic_transport_virtual_request(hdev, UCLOGIC_VIRTUAL_REQ_IFACE,
+					       0, NULL, 0,
+					       iface, sizeof(iface));
+	if (rc < 0)
+		return rc;
+	if (rc != sizeof(iface))
+		return -EPROTO;
+	*pnum = iface[0];
+	*pnum_ifaces = iface[1];
+	return 0;
+}
+
+static int uclogic_transport_virtual_get_str_desc(struct hid_device *hdev,
+						  __u8 idx, __u8 *buf,
+						  size_t len)
+{
+	return uclogic_transport_virtual_request(hdev,
+						 UCLOGIC_VIRTUAL_REQ_STR_DESC,
+						 idx, NULL, 0, buf, len);
+}
+
+/**
+ * uclogic_transport_virtual_get_ascii() - get an ASCII string from a virtual
+ * tablet, NUL-terminated.
+ *
+ * @hdev:	The HID device of the virtual tablet interface.
+ * @req:	The request to get the string with.
+ * @idx:	The index to make the request for.
+ * @buf:	The buffer for the string, truncated to fit.
+ * @len:	Size of the buffer.
+ *
+ * Returns:
+ *	Length of the string, or a negative errno code.
+ */
+static int uclogic_transport_virtual_get_ascii(struct hid_device *hdev,
+					       __u8 req, __u8 idx,
+					       char *buf, size_t len)
+{
+	int rc;
+
+	if (len == 0)
+		return -EINVAL;
+	rc = uclogic_transport_virtual_request(hdev, req, idx, NULL, 0,
+					       buf, len - 1);
+	if (rc >= 0)
+		buf[rc] = '\0';
+	return rc;
+}
+
+static int uclogic_transport_virtual_get_string(struct hid_device *hdev,
+						__u8 idx, char *buf,
+						size_t len)
+{
+	return uclogic_transport_virtual_get_ascii(hdev,
+						   UCLOGIC_VIRTUAL_REQ_STRING,
+						   idx, buf, len);
+}
+
+static int uclogic_transport_virtual_send_interrupt(struct hid_device *hdev,
+						    int endpoint, __u8 *buf,
+						    size_t len, int *psent)
+{
+	int rc;
+
+	rc = uclogic_transport_virtual_request(hdev,
+					       UCLOGIC_VIRTUAL_REQ_INTERRUPT,
+					       endpoint, buf, len, NULL, 0);
+	if (rc < 0)
+		return rc;
+	*psent = len;
+	return 0;
+}
+
+static int uclogic_transport_virtual_get_product(struct hid_device *hdev,
+						 char *buf, size_t len)
+{
+	return uclogic_transport_virtual_get_ascii(hdev,
+						   UCLOGIC_VIRTUAL_REQ_PRODUCT,
+						   0, buf, len);
+}
+
+const struct uclogic_transport uclogic_transport_virtual = {
+	.get_iface = uclogic_transport_virtual_get_iface,
+	.get_str_desc = uclogic_transport_virtual_get_str_desc,
+	.get_string = uclogic_transport_virtual_get_string,
+	.send_interrupt = uclogic_transport_virtual_send_interrupt,
+	.get_product = uclogic_transport_virtual_get_product,
+};
+
+/**
+ * uclogic_params_transport() - get the transport to talk to a tablet
+ * interface with.
+ *
+ * @hdev:	The HID device of the tablet interface, with struct
+ *		uclogic_drvdata attached. Cannot be NULL.
+ *
+ * Returns:
+ *	The transport.
+ */
+static const struct uclogic_transport *uclogic_params_transport(
+						struct hid_device *hdev)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+
+	return drvdata->transport;
+}
+
+/**
+ * uclogic_probe_phase_end() - add the time passed since a probe phase
+ * started to its duration.
+ *
+ * @hdev:	The HID device of the tablet interface being probed, with
+ *		struct uclogic_drvdata attached. Cannot be NULL.
+ * @phase:	The phase to add the time to.
+ * @start:	The time the phase started at, ns, from ktime_get_ns().
+ */
+void uclogic_probe_phase_end(struct hid_device *hdev,
+			     enum uclogic_probe_phase phase, u64 start)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+
+	drvdata->probe_ns[phase] += ktime_get_ns() - start;
+}
+
+/**
+ * uclogic_params_enable_add() - record an enabling transfer made while
+ * discovering the parameters of a tablet interface, to replay on resume.
+ *
+ * @hdev:	The HID device of the tablet interface, with struct
+ *		uclogic_drvdata attached. Cannot be NULL.
+ * @type:	The kind of the transfer.
+ * @idx:	The string descriptor index, or endpoint.
+ * @len:	Number of bytes requested, or sent.
+ * @res:	Result of the transfer.
+ * @data:	The data retrieved, or sent.
+ * @size:	Size of the data.
+ */
+static void uclogic_params_enable_add(struct hid_device *hdev,
+				      enum uclogic_xfer_type type,
+				      int idx, size_t len, int res,
+				      const void *data, size_t size)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+	struct uclogic_enable *enable = &drvdata->enable;
+	struct uclogic_enable_xfer *xfer;
+
+	/* Have the parameters discovered again on resume, if it won't fit */
+	if (enable->num >= ARRAY_SIZE(enable->xfers) ||
+	    len > UCLOGIC_ENABLE_DATA_MAX) {
+		enable->overflow = true;
+		return;
+	}
+
+	xfer = &enable->xfers[enable->num++];
+	xfer->type = type;
+	xfer->idx = idx;
+	xfer->len = len;
+	xfer->res = res;
+	memcpy(xfer->data, data, size);
+}
+
+/* Delay before retrying a transfer the first time, ms, doubled each time */
+#define UCLOGIC_XFER_RETRY_DELAY_MS	10
+
+/**
+ * uclogic_params_xfer_transient() - check if a transfer failed in a way
+ * which might not repeat, e.g. because of a flaky hub, and is worth
+ * retrying.
+ *
+ * @rc:	The result of the transfer.
+ *
+ * Returns:
+ *	True if the failure is transient, false otherwise.
+ */
+static bool uclogic_params_xfer_transient(int rc)
+{
+	return rc == -ETIMEDOUT || rc == -EPROTO || rc == -EILSEQ ||
+	       rc == -EAGAIN;
+}
+
+/**
+ * uclogic_params_xfer_out_of_time() - check if a probe or resume would
+ * run out of the time left for its transfers after a delay, and log it
+ * the first time it does.
+ *
+ * @hdev:	The HID device of the tablet interface, with struct
+ *		uclogic_drvdata attached.
+ * @delay_ms:	The delay, ms.
+ *
+ * Returns:
+ *	True if out of time, false otherwise.
+ */
+static bool uclogic_params_xfer_out_of_time(struct hid_device *hdev,
+					    unsigned int delay_ms)
+{
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+
+	if (drvdata->probe_deadline == 0 ||
+	    ktime_get_ns() + (u64)delay_ms * NSEC_PER_MSEC <
+			drvdata->probe_deadline)
+		return false;
+	if (!drvdata->probe_over_budget)
+		hid_warn(hdev, "out of time for talking to the tablet\n");
+	drvdata->probe_over_budget = true;
+	return true;
+}
+
+/**
+ * uclogic_params_xfer() - make a transfer to a tablet interface over its
+ * transport, timed as a probe phase. Retry it with an exponential backoff,
+ * if it fails transiently, as many times as configured, within the time
+ * left for the probe or resume in progress.
+ *
+ * @hdev:	The HID device of the tablet interface, with struct
+ *		uclogic_drvdata attached. Cannot be NULL.
+ * @type:	The kind of the transfer.
+ * @idx:	The string descriptor index, or endpoint.
+ * @buf:	The buffer to retrieve the data into, or the data to send.
+ * @len:	Size of the buffer, or the data.
+ *
+ * Returns:
+ *	Number of bytes retrieved (<= len), zero if sent,
+ *	-EPIPE, if the descriptor was not found, or the endpoint stalled,
+ *	-ETIME, if out of time for the transfer, or
+ *	another negative errno code in case of other error.
+ */
+static int uclogic_params_xfer(struct hid_device *hdev,
+			       enum uclogic_xfer_type type, int idx,
+			       __u8 *buf, size_t len)
+{
+	static const enum uclogic_probe_phase phases[] = {
+		[UCLOGIC_XFER_STR_DESC] = UCLOGIC_PROBE_PHASE_STR_DESC,
+		[UCLOGIC_XFER_STRING] = UCLOGIC_PROBE_PHASE_STRING,
+		[UCLOGIC_XFER_INTERRUPT] = UCLOGIC_PROBE_PHASE_INTERRUPT,
+	};
+	struct uclogic_drvdata *drvdata = hid_get_drvdata(hdev);
+	const struct uclogic_transport *transport = drvdata->transport;
+	unsigned int attempt;
+	unsigned int delay_ms;
+	int sent;
+	u64 start;
+	int rc;
+
+	for (attempt = 0;; attempt++) {
+		if (uclogic_params_xfer_out_of_time(hdev, 0))
+			return -ETIME;
+
+		start = ktime_get_ns();
+		switch (type) {
+		case UCLOGIC_XFER_STR_DESC:
+			rc = transport->get_str_desc(hdev, idx, buf, len);
+			break;
+		case UCLOGIC_XFER_STRING:
+			rc = transport->get_string(hdev, idx, (char *)buf, len);
+			break;
+		case UCLOGIC_XFER_INTERRUPT:
+		default:
+			rc = transport->send_interrupt(hdev, idx, buf, len,
+						       &sent);
+			if (rc == 0 && sent != len)
+				rc = -EIO;
+			break;
+		}
+		uclogic_probe_phase_end(hdev, phases[type], start);
+
+		if (!uclogic_params_xfer_transient(rc) ||
+		    attempt >= drvdata->xfer_retries)
+			return rc;
+		delay_ms = UCLOGIC_XFER_RETRY_DELAY_MS << attempt;
+		if (uclogic_params_xfer_out_of_time(hdev, delay_ms))
+			return rc;
+		hid_dbg(hdev, "transfer failed: %d, retrying in %u ms\n",
+			rc, delay_ms);
+		msleep(delay_ms);
+		drvdata->probe_retries++;
+	}
+}
+
 /**
  * uclogic_params_get_str_desc - retrieve a string descriptor from a HID
  * device interface, putting it into a kmalloc-allocated buffer as is, without
@@ -159,7 +666,6 @@ static int uclogic_params_get_str_desc(__u8 **pbuf, struct hid_device *hdev,
 					__u8 idx, size_t len)
 {
 	int rc;
-	struct usb_device *udev;
 	__u8 *buf = NULL;
 
 	/* Check arguments */
@@ -168,19 +674,15 @@ static int uclogic_params_get_str_desc(__u8 **pbuf, struct hid_device *hdev,
 		goto cleanup;
 	}
 
-	udev = hid_to_usb_dev(hdev);
-
 	buf = kmalloc(len, GFP_KERNEL);
 	if (buf == NULL) {
 		rc = -ENOMEM;
 		goto cleanup;
 	}
 
-	rc = usb_control_msg(udev, usb_rcvctrlpipe(udev, 0),
-				USB_REQ_GET_DESCRIPTOR, USB_DIR_IN,
-				(USB_DT_STRING << 8) + idx,
-				0x0409, buf, len,
-				USB_CTRL_GET_TIMEOUT);
+	rc = uclogic_params_xfer(hdev, UCLOGIC_XFER_STR_DESC, idx, buf, len);
+	uclogic_params_enable_add(hdev, UCLOGIC_XFER_STR_DESC, idx, len, rc,
+				  buf, max(rc, 0));
 	if (rc == -EPIPE) {
 		hid_dbg(hdev, "string descriptor #%hhu not found\n", idx);
 		goto cleanup;
@@ -201,6 +703,282 @@ cleanup:
 	return rc;
 }
 
+/*
+ * Parameters string descriptor of a tablet interface, cached after probing
+ * it, or seeded by the user
+ */
+struct uclogic_params_cache_entry {
+	__u16 vendor;
+	__u16 product;
+	__u8 ifnum;
+	/* Firmware identification, e.g. the product string */
+	char firmware[UCLOGIC_PARAMS_CACHE_FIRMWARE_MAX];
+	/* Size of the descriptor, zero if the entry is free */
+	__u8 len;
+	__u8 data[UCLOGIC_PARAMS_CACHE_DATA_MAX];
+};
+
+/* The cached parameters, replaced in the order they were added */
+static struct uclogic_params_cache_entry
+	uclogic_params_cache[UCLOGIC_PARAMS_CACHE_ENTRIES];
+/* Number of cache entries ever added, wrapping */
+static unsigned int uclogic_params_cache_added;
+/* Lock protecting the cache */
+static DEFINE_MUTEX(uclogic_params_cache_lock);
+
+/**
+ * uclogic_params_cache_find() - find a parameters cache entry.
+ * Must be called with uclogic_params_cache_lock held.
+ *
+ * @vendor:	Vendor ID of the tablet.
+ * @product:	Product ID of the tablet.
+ * @ifnum:	Number of the tablet interface.
+ * @firmware:	Firmware identification of the tablet. Cannot be NULL.
+ *
+ * Returns:
+ *	The entry, or NULL if not found.
+ */
+static struct uclogic_params_cache_entry *uclogic_params_cache_find(
+					__u16 vendor, __u16 product,
+					__u8 ifnum, const char *firmware)
+{
+	struct uclogic_params_cache_entry *entry;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(uclogic_params_cache); i++) {
+		entry = &uclogic_params_cache[i];
+		if (entry->len != 0 && entry->vendor == vendor &&
+		    entry->product == product && entry->ifnum == ifnum &&
+		    strcmp(entry->firmware, firmware) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+/**
+ * uclogic_params_cache_add() - add the parameters string descriptor of a
+ * tablet interface to the cache, replacing the one cached for the same
+ * interface and firmware, or the oldest one if the cache is full.
+ *
+ * @vendor:	Vendor ID of the tablet.
+ * @product:	Product ID of the tablet.
+ * @ifnum:	Number of the tablet interface.
+ * @firmware:	Firmware identification of the tablet. Cannot be NULL.
+ * @data:	The descriptor. Cannot be NULL.
+ * @len:	Size of the descriptor, at most UCLOGIC_PARAMS_CACHE_DATA_MAX.
+ */
+static void uclogic_params_cache_add(__u16 vendor, __u16 product,
+				     __u8 ifnum, const char *firmware,
+				     const __u8 *data, size_t len)
+{
+	struct uclogic_params_cache_entry *entry;
+
+	mutex_lock(&uclogic_params_cache_lock);
+	entry = uclogic_params_cache_find(vendor, product, ifnum, firmware);
+	if (entry == NULL) {
+		entry = &uclogic_params_cache[uclogic_params_cache_added++ %
+					      ARRAY_SIZE(uclogic_params_cache)];
+		entry->vendor = vendor;
+		entry->product = product;
+		entry->ifnum = ifnum;
+		strscpy(entry->firmware, firmware, sizeof(entry->firmware));
+	}
+	memcpy(entry->data, data, len);
+	entry->len = len;
+	mutex_unlock(&uclogic_params_cache_lock);
+}
+
+/**
+ * uclogic_params_cache_get_str_desc() - get the cached parameters string
+ * descriptor of a tablet interface, putting it into a kmalloc-allocated
+ * buffer.
+ *
+ * @pbuf:	Location for the kmalloc-allocated buffer pointer containing
+ *		the descriptor. Not modified in case of error. Cannot be NULL.
+ * @hdev:	The HID device of the tablet interface. Cannot be NULL.
+ * @ifnum:	Number of the tablet interface.
+ * @firmware:	Firmware identification of the tablet. Cannot be NULL.
+ * @len:	Size of the descriptor to get.
+ *
+ * Returns:
+ *	The size of the descriptor, -ENOENT if no descriptor of the size
+ *	was cached, or -ENOMEM if out of memory.
+ */
+static int uclogic_params_cache_get_str_desc(__u8 **pbuf,
+					     struct hid_device *hdev,
+					     __u8 ifnum, const char *firmware,
+					     size_t len)
+{
+	const struct uclogic_params_cache_entry *entry;
+	int rc = -ENOENT;
+
+	mutex_lock(&uclogic_params_cache_lock);
+	entry = uclogic_params_cache_find(hdev->vendor, hdev->product, ifnum,
+					  firmware);
+	if (entry != NULL && entry->len == len) {
+		*pbuf = kmemdup(entry->data, len, GFP_KERNEL);
+		rc = *pbuf == NULL ? -ENOMEM : len;
+	}
+	mutex_unlock(&uclogic_params_cache_lock);
+	return rc;
+}
+
+/**
+ * uclogic_params_cache_clear() - remove all parameters cache entries.
+ */
+void uclogic_params_cache_clear(void)
+{
+	mutex_lock(&uclogic_params_cache_lock);
+	memset(uclogic_params_cache, 0, sizeof(uclogic_params_cache));
+	uclogic_params_cache_added = 0;
+	mutex_unlock(&uclogic_params_cache_lock);
+}
+
+/**
+ * uclogic_params_cache_parse() - parse a parameters cache entry formatted
+ * as "VENDOR:PRODUCT:INTERFACE:DATA:FIRMWARE", where the vendor and product
+ * IDs and the descriptor data are in hex, and the firmware identification
+ * extends to the end of the entry, and optionally add it to the cache.
+ *
+ * @val:	The entry, not necessarily terminated. Cannot be NULL.
+ * @size:	Length of the entry.
+ * @add:	True if the entry should be added to the cache, false if it
+ *		should only be checked.
+ *
+ * Returns:
+ *	Zero, if successful. -EINVAL, if the entry is invalid.
+ */
+static int uclogic_params_cache_parse(const char *val, size_t size, bool add)
+{
+	char line[2 * UCLOGIC_PARAMS_CACHE_DATA_MAX +
+		  UCLOGIC_PARAMS_CACHE_FIRMWARE_MAX + 16];
+	__u16 vendor;
+	__u16 product;
+	__u8 ifnum;
+	__u8 data[UCLOGIC_PARAMS_CACHE_DATA_MAX];
+	char firmware[UCLOGIC_PARAMS_CACHE_FIRMWARE_MAX];
+	const char *hex;
+	const char *sep;
+	size_t len;
+	int n = 0;
+
+	/* Cut too long firmware identifications short, as when cached */
+	len = min(size, sizeof(line) - 1);
+	memcpy(line, val, len);
+	line[len] = '\0';
+
+	if (sscanf(line, "%hx:%hx:%hhu:%n",
+		   &vendor, &product, &ifnum, &n) != 3 || n == 0)
+		return -EINVAL;
+	hex = line + n;
+	sep = strchr(hex, ':');
+	if (sep == NULL)
+		return -EINVAL;
+	len = (sep - hex) / 2;
+	if ((sep - hex) % 2 != 0 || len == 0 || len > sizeof(data) ||
+	    hex2bin(data, hex, len) != 0)
+		return -EINVAL;
+	strscpy(firmware, sep + 1, sizeof(firmware));
+
+	if (add)
+		uclogic_params_cache_add(vendor, product, ifnum, firmware,
+					 data, len);
+	return 0;
+}
+
+/**
+ * uclogic_params_cache_parse_list() - parse parameters cache entries
+ * separated by commas or newlines, and optionally add them to the cache.
+ *
+ * @val:	The entries. Cannot be NULL.
+ * @add:	True if the entries should be added to the cache, false if
+ *		they should only be checked.
+ *
+ * Returns:
+ *	Number of entries, or -EINVAL, if an entry is invalid.
+ */
+static int uclogic_params_cache_parse_list(const char *val, bool add)
+{
+	const char *entry;
+	size_t len;
+	int num = 0;
+	int rc;
+
+	for (entry = val; *entry != '\0'; entry += len) {
+		len = strcspn(entry, ",\n");
+		if (len != 0) {
+			rc = uclogic_params_cache_parse(entry, len, add);
+			if (rc != 0)
+				return rc;
+			num++;
+		}
+		/* Skip the separator */
+		if (entry[len] != '\0')
+			len++;
+	}
+	return num;
+}
+
+/**
+ * uclogic_params_cache_set() - seed the parameters cache with entries
+ * separated by commas or newlines, each formatted as
+ * "VENDOR:PRODUCT:INTERFACE:DATA:FIRMWARE", where the vendor and product
+ * IDs and the descriptor data are in hex, and the firmware identification
+ * extends to the end of the entry, e.g.
+ * "28bd:0935:2:0e0370b210770800ff1fd813:Deco L". Nothing is added, if any
+ * entry is invalid. Clear the cache if there are no entries.
+ *
+ * @val:	The entries. Cannot be NULL.
+ *
+ * Returns:
+ *	Zero, if successful. -EINVAL, if an entry is invalid.
+ */
+int uclogic_params_cache_set(const char *val)
+{
+	int rc;
+
+	/* Check all the entries first, then add them */
+	rc = uclogic_params_cache_parse_list(val, false);
+	if (rc < 0)
+		return rc;
+	if (rc == 0)
+		uclogic_params_cache_clear();
+	else
+		uclogic_params_cache_parse_list(val, true);
+	return 0;
+}
+
+/**
+ * uclogic_params_cache_show() - format the parameters cache entries, one
+ * per line, as accepted by uclogic_params_cache_set().
+ *
+ * @buf:	The buffer to format the entries into. Cannot be NULL.
+ * @size:	Size of the buffer.
+ *
+ * Returns:
+ *	The length of the formatted entries.
+ */
+int uclogic_params_cache_show(char *buf, size_t size)
+{
+	const struct uclogic_params_cache_entry *entry;
+	char hex[2 * UCLOGIC_PARAMS_CACHE_DATA_MAX + 1];
+	int len = 0;
+	size_t i;
+
+	mutex_lock(&uclogic_params_cache_lock);
+	for (i = 0; i < ARRAY_SIZE(uclogic_params_cache); i++) {
+		entry = &uclogic_params_cache[i];
+		if (entry->len == 0)
+			continue;
+		*bin2hex(hex, entry->data, entry->len) = '\0';
+		len += scnprintf(buf + len, size - len, "%04x:%04x:%u:%s:%s\n",
+				 entry->vendor, entry->product, entry->ifnum,
+				 hex, entry->firmware);
+	}
+	mutex_unlock(&uclogic_params_cache_lock);
+	return len;
+}
+
 /**
  * uclogic_params_pen_cleanup - free resources used by struct
  * uclogic_params_pen (tablet interface's pen input parameters).
@@ -477,6 +1255,13 @@ static int uclogic_params_pen_init_v2(struct uclogic_params_pen *pen,
 	pen->desc_size = uclogic_rdesc_v2_pen_template_size;
 	pen->id = UCLOGIC_RDESC_V2_PEN_ID;
 	pen->inrange = UCLOGIC_PARAMS_PEN_INRANGE_NONE;
+	/*
+	 * The only report with the (otherwise never reported) in-range bit
+	 * set is the one sent when the pen goes out of proximity
+	 */
+	pen->proximity_out_list[0].byte = 1;
+	pen->proximity_out_list[0].mask = 0xff;
+	pen->proximity_out_list[0].value = 0xc0;
 	pen->fragmented_hires = true;
 	pen->tilt_y_flipped = true;
 	found = true;
@@ -568,7 +1353,6 @@ static int uclogic_params_frame_init_v1(struct uclogic_params_frame *frame,
 {
 	int rc;
 	bool found = false;
-	struct usb_device *usb_dev;
 	char *str_buf = NULL;
 	const size_t str_len = 16;
 
@@ -578,8 +1362,6 @@ static int uclogic_params_frame_init_v1(struct uclogic_params_frame *frame,
 		goto cleanup;
 	}
 
-	usb_dev = hid_to_usb_dev(hdev);
-
 	/*
 	 * Enable generic button mode
 	 */
@@ -589,7 +1371,10 @@ static int uclogic_params_frame_init_v1(struct uclogic_params_frame *frame,
 		goto cleanup;
 	}
 
-	rc = usb_string(usb_dev, 123, str_buf, str_len);
+	rc = uclogic_params_xfer(hdev, UCLOGIC_XFER_STRING, 123,
+				 (__u8 *)str_buf, str_len);
+	uclogic_params_enable_add(hdev, UCLOGIC_XFER_STRING, 123, str_len,
+				  rc, str_buf, max(rc, 0));
 	if (rc == -EPIPE) {
 		hid_dbg(hdev,
 			"generic button -enabling string descriptor not found\n");
@@ -635,6 +1420,7 @@ static void uclogic_params_cleanup_event_hooks(struct uclogic_params *params)
 	list_for_each_entry_safe(curr, n, &params->event_hooks->list, list) {
 		cancel_work_sync(&curr->work);
 		list_del(&curr->list);
+		kfree(curr->mask);
 		kfree(curr->event);
 		kfree(curr);
 	}
@@ -643,6 +1429,99 @@ static void uclogic_params_cleanup_event_hooks(struct uclogic_params *params)
 	params->event_hooks = NULL;
 }
 
+/**
+ * uclogic_params_add_event_hook() - register a raw event hook for a tablet's
+ * interface, adding it to the interface's hook matcher.
+ *
+ * @params:	Parameters to add the hook to. Cannot be NULL.
+ * @hdev:	The HID device of the tablet interface, to be passed to the
+ *		hook's work.
+ * @event:	The event to hook. Cannot be NULL.
+ * @mask:	Mask of the event bits to match, of the same size as the
+ *		event. NULL to match all bits.
+ * @size:	The size of the event, bytes. Cannot be zero.
+ * @func:	The function to schedule as a work when the event is received.
+ *
+ * Returns:
+ *	Zero, if successful. A negative errno code on error.
+ */
+int uclogic_params_add_event_hook(struct uclogic_params *params,
+				  struct hid_device *hdev,
+				  const __u8 *event, const __u8 *mask,
+				  size_t size, work_func_t func)
+{
+	int rc;
+	struct uclogic_raw_event_hooks *hooks;
+	struct uclogic_raw_event_hook *hook = NULL;
+	struct uclogic_raw_event_hook **pchain;
+	unsigned int value;
+
+	if (params == NULL || event == NULL || size == 0)
+		return -EINVAL;
+
+	if (params->event_hooks == NULL) {
+		hooks = kzalloc(sizeof(*hooks), GFP_KERNEL);
+		if (hooks == NULL)
+			return -ENOMEM;
+		INIT_LIST_HEAD(&hooks->list);
+		params->event_hooks = hooks;
+	}
+	hooks = params->event_hooks;
+
+	hook = kzalloc(sizeof(*hook), GFP_KERNEL);
+	if (hook == NULL) {
+		rc = -ENOMEM;
+		goto failure;
+	}
+	hook->event = kmemdup(event, size, GFP_KERNEL);
+	if (hook->event == NULL) {
+		rc = -ENOMEM;
+		goto failure;
+	}
+	if (mask != NULL) {
+		hook->mask = kmemdup(mask, size, GFP_KERNEL);
+		if (hook->mask == NULL) {
+			rc = -ENOMEM;
+			goto failure;
+		}
+	}
+	INIT_WORK(&hook->work, func);
+	hook->hdev = hdev;
+	hook->size = size;
+	hook->index = hooks->num;
+
+	/* Let the events of this size and first byte through the filters */
+	hooks->sizes |= uclogic_raw_event_hooks_size_bit(size);
+	for (value = 0; value <= U8_MAX; value++) {
+		if (((value ^ event[0]) & (mask ? mask[0] : U8_MAX)) == 0)
+			__set_bit(value, hooks->first_bytes);
+	}
+
+	/* Hash the hook, if its first two bytes are fixed */
+	if (size >= 2 &&
+	    (mask == NULL || (mask[0] == U8_MAX && mask[1] == U8_MAX)))
+		pchain = &hooks->buckets[
+				uclogic_raw_event_hooks_bucket(event, size)];
+	else
+		pchain = &hooks->wildcards;
+	/* Append to the chain, keeping the registration order */
+	while (*pchain != NULL)
+		pchain = &(*pchain)->next;
+	*pchain = hook;
+
+	list_add_tail(&hook->list, &hooks->list);
+	hooks->num++;
+	return 0;
+
+failure:
+	if (hook != NULL) {
+		kfree(hook->mask);
+		kfree(hook->event);
+		kfree(hook);
+	}
+	return rc;
+}
+
 /**
  * uclogic_params_cleanup - free resources used by struct uclogic_params
  * (tablet interface's parameters).
@@ -736,6 +1615,347 @@ cleanup:
 	return rc;
 }
 
+/**
+ * uclogic_params_get_raw_map() - Get a raw report dispatch map for a tablet's
+ *                                interface.
+ *
+ * @params:	The parameters of a tablet interface to get the map for.
+ *		Cannot be NULL.
+ * @map:	Location for the resulting map. Cannot be NULL.
+ *
+ * The map reproduces the matching order of the parameter lists: the pen
+ * report takes precedence over frame reports with the same ID, and the
+ * first matching frame and subreport in their lists win.
+ */
+static void uclogic_params_get_raw_map(const struct uclogic_params *params,
+					struct uclogic_raw_map *map)
+{
+	size_t i;
+	const struct uclogic_params_pen_subreport *subreport;
+
+	memset(map, 0, sizeof(*map));
+	map->passthrough = true;
+
+	/* Walk the lists backwards, so the first entries override the rest */
+	for (i = ARRAY_SIZE(params->frame_list); i > 0; i--) {
+		/* Skip absent IDs, and the ones no report can have */
+		if (params->frame_list[i - 1].id == 0 ||
+		    params->frame_list[i - 1].id > U8_MAX)
+			continue;
+		map->handler[params->frame_list[i - 1].id] =
+			UCLOGIC_RAW_HANDLER_FRAME + (i - 1);
+		map->passthrough = false;
+	}
+
+	if (params->pen.id == 0 || params->pen.id > U8_MAX)
+		return;
+
+	map->handler[params->pen.id] = UCLOGIC_RAW_HANDLER_PEN;
+	map->passthrough = false;
+	for (i = ARRAY_SIZE(params->pen.subreport_list); i > 0; i--) {
+		subreport = &params->pen.subreport_list[i - 1];
+		if (subreport->value != 0)
+			map->subreport_id[subreport->value] = subreport->id;
+	}
+}
+
+/**
+ * uclogic_raw_prog_add() - append an operation to a raw report rewrite
+ * program.
+ *
+ * @prog:	The program to append to. Cannot be NULL.
+ * @code:	The operation code.
+ * @min_size:	Minimum report size to perform the operation at, bytes.
+ * @dst:	Offset of the byte to write.
+ * @src:	Offset of the original byte to read, if the operation reads
+ *		any.
+ * @arg:	The operation argument.
+ *
+ * Returns:
+ *	Zero, if successful. -ENOSPC, if the program is full, -ERANGE, if the
+ *	offsets or the argument don't fit the operation.
+ */
+static int uclogic_raw_prog_add(struct uclogic_raw_prog *prog,
+				enum uclogic_raw_op_code code,
+				unsigned int min_size,
+				unsigned int dst, unsigned int src,
+				unsigned int arg)
+{
+	struct uclogic_raw_op *op;
+	size_t len;
+	bool reads = (code == UCLOGIC_RAW_OP_MOVE || code == UCLOGIC_RAW_OP_MAP ||
+		      code == UCLOGIC_RAW_OP_PROXIMITY_OUT);
+	bool writes = (code != UCLOGIC_RAW_OP_INRANGE);
+
+	for (len = 0; len < ARRAY_SIZE(prog->ops) &&
+		      prog->ops[len].code != UCLOGIC_RAW_OP_END; len++)
+		;
+	if (len >= ARRAY_SIZE(prog->ops))
+		return -ENOSPC;
+	if (min_size > U8_MAX || arg > U8_MAX || (writes && dst >= min_size) ||
+	    (reads && (src >= min_size || src >= UCLOGIC_RAW_PROG_SRC_MAX)))
+		return -ERANGE;
+
+	op = &prog->ops[len];
+	op->code = code;
+	op->min_size = min_size;
+	op->dst = writes ? dst : 0;
+	op->src = reads ? src : 0;
+	op->arg = arg;
+	if (reads)
+		prog->src_size = max_t(unsigned int, prog->src_size, src + 1);
+	return 0;
+}
+
+/**
+ * uclogic_raw_add_table() - add a byte mapping table to raw report
+ * handling data, reusing an identical table, if already added.
+ *
+ * @raw:	The raw report handling data to add the table to.
+ *		Cannot be NULL.
+ * @num:	Location of the number of tables already added. Cannot be
+ *		NULL.
+ * @table:	The table to add. Cannot be NULL.
+ *
+ * Returns:
+ *	The index of the table, or -ENOSPC, if there's no space left.
+ */
+static int uclogic_raw_add_table(struct uclogic_raw *raw, unsigned int *num,
+				 const __u8 table[256])
+{
+	unsigned int i;
+
+	for (i = 0; i < *num; i++) {
+		if (memcmp(raw->tables[i], table, sizeof(raw->tables[i])) == 0)
+			return i;
+	}
+	if (*num >= ARRAY_SIZE(raw->tables))
+		return -ENOSPC;
+	memcpy(raw->tables[*num], table, sizeof(raw->tables[*num]));
+	return (*num)++;
+}
+
+/**
+ * uclogic_params_pen_get_prog() - Get a raw report rewrite program for a
+ *                                 pen input.
+ *
+ * @pen:	The pen parameters to get the program for. Cannot be NULL.
+ * @raw:	The raw report handling data to add the program's tables to.
+ *		Cannot be NULL.
+ * @num_tables:	Location of the number of tables already added to "raw".
+ *		Cannot be NULL.
+ * @prog:	Location for the program, filled with zeroes. Cannot be NULL.
+ *
+ * Returns:
+ *	Zero, if successful. A negative errno code on error.
+ */
+static int uclogic_params_pen_get_prog(const struct uclogic_params_pen *pen,
+					struct uclogic_raw *raw,
+					unsigned int *num_tables,
+					struct uclogic_raw_prog *prog)
+{
+	int rc;
+	int table_idx;
+	size_t i;
+	unsigned int value;
+	const struct uclogic_params_pen_proximity_out *proximity_out;
+	__u8 table[256];
+
+#define ADD_OP(_code, _min_size, _dst, _src, _arg) \
+	do {                                                                \
+		rc = uclogic_raw_prog_add(prog, UCLOGIC_RAW_OP_##_code,     \
+					  _min_size, _dst, _src, _arg);     \
+		if (rc != 0)                                                \
+			return rc;                                          \
+	} while (0)
+
+	/* If in-range reports are inverted, invert the in-range bit */
+	if (pen->inrange == UCLOGIC_PARAMS_PEN_INRANGE_INVERTED)
+		ADD_OP(XOR, 2, 1, 0, 0x40);
+	/*
+	 * If reports contain fragmented high-resolution coordinates, move the
+	 * high-order X coord byte after the low-order one, shift the Y coord
+	 * to follow, add its high-order byte, and place pressure after it.
+	 */
+	if (pen->fragmented_hires) {
+		ADD_OP(MOVE, 10, 4, 8, 0);
+		ADD_OP(MOVE, 10, 5, 4, 0);
+		ADD_OP(MOVE, 10, 6, 5, 0);
+		ADD_OP(MOVE, 10, 7, 9, 0);
+		ADD_OP(MOVE, 10, 8, 6, 0);
+		ADD_OP(MOVE, 10, 9, 7, 0);
+	}
+	/* If we need to emulate in-range detection, set the in-range bit */
+	if (pen->inrange == UCLOGIC_PARAMS_PEN_INRANGE_NONE) {
+		ADD_OP(OR, 2, 1, 0, 0x40);
+		ADD_OP(INRANGE, 0, 0, 0, 0);
+		/* Clear it again for the reports sent on proximity out */
+		for (i = 0; i < ARRAY_SIZE(pen->proximity_out_list); i++) {
+			proximity_out = &pen->proximity_out_list[i];
+			if (proximity_out->byte == 0)
+				continue;
+			for (value = 0; value <= U8_MAX; value++)
+				table[value] = (value & proximity_out->mask) ==
+						proximity_out->value ?
+						0x40 : 0;
+			table_idx = uclogic_raw_add_table(raw, num_tables,
+							  table);
+			if (table_idx < 0)
+				return table_idx;
+			ADD_OP(PROXIMITY_OUT,
+			       max_t(unsigned int, 2, proximity_out->byte + 1),
+			       1, proximity_out->byte, table_idx);
+		}
+	}
+	/* If we report tilt and Y direction is flipped, negate it */
+	if (pen->tilt_y_flipped)
+		ADD_OP(NEG, 12, 11, 0, 0);
+
+#undef ADD_OP
+
+	return 0;
+}
+
+/**
+ * uclogic_params_frame_get_prog() - Get a raw report rewrite program for a
+ *                                   frame control input.
+ *
+ * @frame:	The frame parameters to get the program for. Cannot be NULL.
+ * @raw:	The raw report handling data to add the program's tables to.
+ *		Cannot be NULL.
+ * @num_tables:	Location of the number of tables already added to "raw".
+ *		Cannot be NULL.
+ * @prog:	Location for the program, filled with zeroes. Cannot be NULL.
+ *
+ * Returns:
+ *	Zero, if successful. A negative errno code on error.
+ */
+static int uclogic_params_frame_get_prog(
+				const struct uclogic_params_frame *frame,
+				struct uclogic_raw *raw,
+				unsigned int *num_tables,
+				struct uclogic_raw_prog *prog)
+{
+	int rc;
+	int table_idx;
+	unsigned int value;
+	__u8 table[256];
+
+#define ADD_OP(_code, _min_size, _dst, _src, _arg) \
+	do {                                                                \
+		rc = uclogic_raw_prog_add(prog, UCLOGIC_RAW_OP_##_code,     \
+					  _min_size, _dst, _src, _arg);     \
+		if (rc != 0)                                                \
+			return rc;                                          \
+	} while (0)
+
+#define ADD_TABLE() \
+	do {                                                                \
+		table_idx = uclogic_raw_add_table(raw, num_tables, table);  \
+		if (table_idx < 0)                                          \
+			return table_idx;                                   \
+	} while (0)
+
+	/* If need to, set pad device ID for Wacom drivers */
+	if (frame->dev_id_byte > 0) {
+		ADD_OP(SET, frame->dev_id_byte + 1, frame->dev_id_byte, 0, 0xf);
+		/* If we also have a touch ring, clear it when finger leaves */
+		if (frame->touch_byte > 0) {
+			for (value = 0; value <= U8_MAX; value++)
+				table[value] = value == 0 ? 0 : 0xf;
+			ADD_TABLE();
+			ADD_OP(MAP,
+			       max(frame->dev_id_byte, frame->touch_byte) + 1,
+			       frame->dev_id_byte, frame->touch_byte,
+			       table_idx);
+		}
+	}
+
+	/* If need to, read rotary encoder state change */
+	if (frame->re_lsb > 0)
+		ADD_OP(ENCODER, frame->re_lsb / 8 + 1, frame->re_lsb / 8, 0,
+		       frame->re_lsb % 8);
+
+	/* If need to, transform the touch ring reports */
+	if (frame->touch_byte > 0) {
+		for (value = 0; value <= U8_MAX; value++) {
+			__s8 touch = value;
+
+			if (touch != 0) {
+				if (frame->touch_flip_at != 0) {
+					touch = frame->touch_flip_at - touch;
+					if (touch <= 0)
+						touch = frame->touch_max + touch;
+				}
+				touch--;
+			}
+			table[value] = touch;
+		}
+		ADD_TABLE();
+		ADD_OP(MAP, frame->touch_byte + 1, frame->touch_byte,
+		       frame->touch_byte, table_idx);
+	}
+
+	/* If need to, transform the bitmap dial reports */
+	if (frame->bitmap_dial_byte > 0) {
+		for (value = 0; value <= U8_MAX; value++)
+			table[value] = value == 2 ? (__u8)-1 : value;
+		ADD_TABLE();
+		ADD_OP(MAP, frame->bitmap_dial_byte + 1,
+		       frame->bitmap_dial_byte, frame->bitmap_dial_byte,
+		       table_idx);
+	}
+
+#undef ADD_TABLE
+#undef ADD_OP
+
+	return 0;
+}
+
+/**
+ * uclogic_params_get_raw() - Get raw report handling data for a tablet's
+ *                            interface.
+ *
+ * @params:	The parameters of a tablet interface to get the data for.
+ *		Cannot be NULL.
+ * @raw:	Location for the resulting data, with the run-time state
+ *		reset. Cannot be NULL.
+ *
+ * Returns:
+ *	Zero, if successful. A negative errno code on error, e.g. if the
+ *	parameters cannot be expressed with rewrite programs.
+ */
+int uclogic_params_get_raw(const struct uclogic_params *params,
+			   struct uclogic_raw *raw)
+{
+	int rc;
+	size_t i;
+	unsigned int num_tables = 0;
+
+	memset(raw, 0, sizeof(*raw));
+	raw->event_hooks = params->event_hooks != NULL;
+
+	if (params->pen.id != 0) {
+		rc = uclogic_params_pen_get_prog(&params->pen, raw,
+						 &num_tables, &raw->pen);
+		if (rc != 0)
+			return rc;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(params->frame_list); i++) {
+		if (params->frame_list[i].id == 0)
+			continue;
+		rc = uclogic_params_frame_get_prog(&params->frame_list[i], raw,
+						   &num_tables,
+						   &raw->frame_list[i]);
+		if (rc != 0)
+			return rc;
+	}
+
+	uclogic_params_get_raw_map(params, &raw->map);
+	return 0;
+}
+
 /**
  * uclogic_params_init_invalid() - initialize tablet interface parameters,
  * specifying the interface is invalid.
@@ -833,9 +2053,9 @@ static int uclogic_params_huion_init(struct uclogic_params *params,
 				     struct hid_device *hdev)
 {
 	int rc;
-	struct usb_device *udev;
-	struct usb_interface *iface;
+	const struct uclogic_transport *transport;
 	__u8 bInterfaceNumber;
+	__u8 bNumInterfaces;
 	bool found;
 	/* The resulting parameters (noop) */
 	struct uclogic_params p = {0, };
@@ -857,9 +2077,10 @@ static int uclogic_params_huion_init(struct uclogic_params *params,
 		goto cleanup;
 	}
 
-	udev = hid_to_usb_dev(hdev);
-	iface = to_usb_interface(hdev->dev.parent);
-	bInterfaceNumber = iface->cur_altsetting->desc.bInterfaceNumber;
+	transport = uclogic_params_transport(hdev);
+	rc = transport->get_iface(hdev, &bInterfaceNumber, &bNumInterfaces);
+	if (rc != 0)
+		goto cleanup;
 
 	/* If it's a custom keyboard interface */
 	if (bInterfaceNumber == 1 || bInterfaceNumber == 2) {
@@ -872,13 +2093,24 @@ static int uclogic_params_huion_init(struct uclogic_params *params,
 		goto output;
 	}
 
+	/*
+	 * NOTE: The requests below are made strictly one after another,
+	 * and cannot be submitted together, as they aren't independent:
+	 * reading string descriptor #200 or #100 switches the tablet into
+	 * the v2 or the v1 mode, so only the one found must be read, and
+	 * last; #200 must not be read from the transition firmware, which
+	 * is only known from #201; and string #123 enables the buttons of
+	 * the v1 mode, after #100 switched to it.
+	 */
+
 	/* Try to get firmware version */
 	ver_ptr = kzalloc(ver_len, GFP_KERNEL);
 	if (ver_ptr == NULL) {
 		rc = -ENOMEM;
 		goto cleanup;
 	}
-	rc = usb_string(udev, 201, ver_ptr, ver_len);
+	rc = uclogic_params_xfer(hdev, UCLOGIC_XFER_STRING, 201,
+				 (__u8 *)ver_ptr, ver_len);
 	if (rc == -EPIPE) {
 		*ver_ptr = '\0';
 	} else if (rc < 0) {
@@ -1075,9 +2307,6 @@ cleanup:
 static int uclogic_probe_interface(struct hid_device *hdev, const u8 *magic_arr,
 				   size_t magic_size, int endpoint)
 {
-	struct usb_device *udev;
-	unsigned int pipe = 0;
-	int sent;
 	u8 *buf = NULL;
 	int rc = 0;
 
@@ -1092,11 +2321,9 @@ static int uclogic_probe_interface(struct hid_device *hdev, const u8 *magic_arr,
 		goto cleanup;
 	}
 
-	udev = hid_to_usb_dev(hdev);
-	pipe = usb_sndintpipe(udev, endpoint);
-
-	rc = usb_interrupt_msg(udev, pipe, buf, magic_size, &sent, 1000);
-	if (rc || sent != magic_size) {
+	rc = uclogic_params_xfer(hdev, UCLOGIC_XFER_INTERRUPT, endpoint,
+				 buf, magic_size);
+	if (rc) {
 		hid_err(hdev, "Interface probing failed: %d\n", rc);
 		rc = -1;
 		goto cleanup;
@@ -1285,9 +2512,11 @@ static bool uclogic_params_ugee_v2_has_battery(struct hid_device *hdev)
 	 */
 	if (hdev->vendor == USB_VENDOR_ID_UGEE &&
 	    hdev->product == USB_DEVICE_ID_UGEE_XPPEN_TABLET_DECO_L) {
-		struct usb_device *udev = hid_to_usb_dev(hdev);
+		char product[16];
 
-		if (strstarts(udev->product, "Deco LW"))
+		if (uclogic_params_transport(hdev)->get_product(
+					hdev, product, sizeof(product)) >= 0 &&
+		    strstarts(product, "Deco LW"))
 			return true;
 	}
 
@@ -1362,7 +2591,6 @@ static void uclogic_params_ugee_v2_reconnect_work(struct work_struct *work)
 static int uclogic_params_ugee_v2_init_event_hooks(struct hid_device *hdev,
 						   struct uclogic_params *p)
 {
-	struct uclogic_raw_event_hook *event_hook;
 	__u8 reconnect_event[] = {
 		/* Event received on wireless tablet reconnection */
 		0x02, 0xF8, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
@@ -1375,26 +2603,9 @@ static int uclogic_params_ugee_v2_init_event_hooks(struct hid_device *hdev,
 	if (!uclogic_params_ugee_v2_has_battery(hdev))
 		return 0;
 
-	p->event_hooks = kzalloc(sizeof(*p->event_hooks), GFP_KERNEL);
-	if (!p->event_hooks)
-		return -ENOMEM;
-
-	INIT_LIST_HEAD(&p->event_hooks->list);
-
-	event_hook = kzalloc(sizeof(*event_hook), GFP_KERNEL);
-	if (!event_hook)
-		return -ENOMEM;
-
-	INIT_WORK(&event_hook->work, uclogic_params_ugee_v2_reconnect_work);
-	event_hook->hdev = hdev;
-	event_hook->size = ARRAY_SIZE(reconnect_event);
-	event_hook->event = kmemdup(reconnect_event, event_hook->size, GFP_KERNEL);
-	if (!event_hook->event)
-		return -ENOMEM;
-
-	list_add_tail(&event_hook->list, &p->event_hooks->list);
-
-	return 0;
+	return uclogic_params_add_event_hook(p, hdev, reconnect_event, NULL,
+					     ARRAY_SIZE(reconnect_event),
+					     uclogic_params_ugee_v2_reconnect_work);
 }
 
 /**
@@ -1421,10 +2632,12 @@ static int uclogic_params_ugee_v2_init(struct uclogic_params *params,
 {
 	int rc = 0;
 	struct uclogic_drvdata *drvdata;
-	struct usb_interface *iface;
 	__u8 bInterfaceNumber;
+	__u8 bNumInterfaces;
 	const int str_desc_len = 12;
 	__u8 *str_desc = NULL;
+	char firmware[UCLOGIC_PARAMS_CACHE_FIRMWARE_MAX];
+	bool cached;
 	__u8 *rdesc_pen = NULL;
 	s32 desc_params[UCLOGIC_RDESC_PH_ID_NUM];
 	enum uclogic_params_frame_type frame_type;
@@ -1437,8 +2650,10 @@ static int uclogic_params_ugee_v2_init(struct uclogic_params *params,
 	}
 
 	drvdata = hid_get_drvdata(hdev);
-	iface = to_usb_interface(hdev->dev.parent);
-	bInterfaceNumber = iface->cur_altsetting->desc.bInterfaceNumber;
+	rc = drvdata->transport->get_iface(hdev, &bInterfaceNumber,
+					   &bNumInterfaces);
+	if (rc)
+		goto cleanup;
 
 	if (bInterfaceNumber == 0) {
 		rc = uclogic_params_ugee_v2_init_frame_mouse(&p);
@@ -1456,22 +2671,46 @@ static int uclogic_params_ugee_v2_init(struct uclogic_params *params,
 	/*
 	 * Initialize the interface by sending magic data.
 	 * The specific data was discovered by sniffing the Windows driver
-	 * traffic.
+	 * traffic. It's sent before reading the parameters, as there, and
+	 * not together with it, as the interface is invalid if it fails.
 	 */
 	rc = uclogic_probe_interface(hdev, uclogic_ugee_v2_probe_arr,
 				     uclogic_ugee_v2_probe_size,
 				     uclogic_ugee_v2_probe_endpoint);
+	uclogic_params_enable_add(hdev, UCLOGIC_XFER_INTERRUPT,
+				  uclogic_ugee_v2_probe_endpoint,
+				  uclogic_ugee_v2_probe_size, rc,
+				  uclogic_ugee_v2_probe_arr,
+				  uclogic_ugee_v2_probe_size);
 	if (rc) {
 		uclogic_params_init_invalid(&p);
 		goto output;
 	}
 
 	/*
-	 * Read the string descriptor containing pen and frame parameters.
+	 * The tablets don't report their firmware version, so tell the
+	 * models sharing a product ID apart by the product string.
+	 */
+	rc = drvdata->transport->get_product(hdev, firmware, sizeof(firmware));
+	if (rc < 0)
+		firmware[0] = '\0';
+
+	/*
+	 * Read the string descriptor containing pen and frame parameters,
+	 * unless cached on an earlier probe, as the magic data alone is
+	 * enough to enable the tablet.
 	 * The specific string descriptor and data were discovered by sniffing
 	 * the Windows driver traffic.
 	 */
-	rc = uclogic_params_get_str_desc(&str_desc, hdev, 100, str_desc_len);
+	cached = true;
+	rc = uclogic_params_cache_get_str_desc(&str_desc, hdev,
+					       bInterfaceNumber, firmware,
+					       str_desc_len);
+	if (rc == -ENOENT) {
+		cached = false;
+		rc = uclogic_params_get_str_desc(&str_desc, hdev, 100,
+						 str_desc_len);
+	}
 	if (rc != str_desc_len) {
 		hid_err(hdev, "failed retrieving pen and frame parameters: %d\n", rc);
 		uclogic_params_init_invalid(&p);
@@ -1484,6 +2723,10 @@ static int uclogic_params_ugee_v2_init(struct uclogic_params *params,
 					       &frame_type);
 	if (rc)
 		goto cleanup;
+	if (!cached)
+		uclogic_params_cache_add(hdev->vendor, hdev->product,
+					 bInterfaceNumber, firmware,
+					 str_desc, str_desc_len);
 
 	kfree(str_desc);
 	str_desc = NULL;
@@ -1559,8 +2802,9 @@ cleanup:
  *		uclogic_params_cleanup()). Not modified in case of error.
  *		Cannot be NULL.
  * @hdev:	The HID device of the tablet interface to initialize and get
- *		parameters from. Cannot be NULL. Must be using the USB low-level
- *		driver, i.e. be an actual USB tablet.
+ *		parameters from. Cannot be NULL. Must have struct
+ *		uclogic_drvdata attached, and be on its transport, i.e. be
+ *		using the USB low-level driver for uclogic_transport_usb.
  *
  * Returns:
  *	Zero, if successful. A negative errno code on error.
@@ -1569,30 +2813,28 @@ int uclogic_params_init(struct uclogic_params *params,
 			struct hid_device *hdev)
 {
 	int rc;
-	struct usb_device *udev;
+	struct uclogic_drvdata *drvdata;
 	__u8  bNumInterfaces;
-	struct usb_interface *iface;
 	__u8 bInterfaceNumber;
 	bool found;
 	/* The resulting parameters (noop) */
 	struct uclogic_params p = {0, };
 
 	/* Check arguments */
-	if (params == NULL || hdev == NULL
-#if KERNEL_VERSION(6, 3, 0) <= LINUX_VERSION_CODE
-	    || !hid_is_usb(hdev)
-#elif KERNEL_VERSION(4, 14, 0) <= LINUX_VERSION_CODE
-	    || !hid_is_using_ll_driver(hdev, &usb_hid_driver)
-#endif
-	   ) {
+	if (params == NULL || hdev == NULL) {
 		rc = -EINVAL;
 		goto cleanup;
 	}
 
-	udev = hid_to_usb_dev(hdev);
-	bNumInterfaces = udev->config->desc.bNumInterfaces;
-	iface = to_usb_interface(hdev->dev.parent);
-	bInterfaceNumber = iface->cur_altsetting->desc.bInterfaceNumber;
+	/* Record the enabling transfers anew */
+	drvdata = hid_get_drvdata(hdev);
+	memset(&drvdata->enable, 0, sizeof(drvdata->enable));
+
+	rc = uclogic_params_transport(hdev)->get_iface(hdev,
+						       &bInterfaceNumber,
+						       &bNumInterfaces);
+	if (rc != 0)
+		goto cleanup;
 
 	/*
 	 * Set replacement report descriptor if the original matches the
@@ -1896,12 +3138,74 @@ int uclogic_params_init(struct uclogic_params *params,
 	/* Output parameters */
 	memcpy(params, &p, sizeof(*params));
 	memset(&p, 0, sizeof(p));
+	/* Don't replay transfers cut short by the probe running out of time */
+	drvdata->enable.valid = !drvdata->enable.overflow &&
+				!drvdata->probe_over_budget;
 	rc = 0;
 cleanup:
 	uclogic_params_cleanup(&p);
 	return rc;
 }
 
+/**
+ * uclogic_params_resume() - re-enable a tablet interface, e.g. after
+ * resume, by replaying the enabling transfers made while discovering its
+ * parameters, without discovering them again.
+ *
+ * @hdev:	The HID device of the tablet interface to re-enable. Cannot
+ *		be NULL. Must have struct uclogic_drvdata attached, with the
+ *		parameters discovered by uclogic_params_init().
+ *
+ * Returns:
+ *	Zero, if successful. -ESTALE, if the transfers were not recorded,
+ *	or the tablet answered them differently, and the parameters need
+ *	to be discovered again. Another negative errno code on error.
+ */
+int uclogic_params_resume(struct hid_device *hdev)
+{
+	int rc = 0;
+	struct uclogic_drvdata *drvdata;
+	const struct uclogic_enable_xfer *xfer;
+	__u8 *buf = NULL;
+	unsigned int i;
+
+	if (hdev == NULL)
+		return -EINVAL;
+
+	drvdata = hid_get_drvdata(hdev);
+	if (!drvdata->enable.valid)
+		return -ESTALE;
+
+	buf = kmalloc(UCLOGIC_ENABLE_DATA_MAX, GFP_KERNEL);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < drvdata->enable.num; i++) {
+		xfer = &drvdata->enable.xfers[i];
+		if (xfer->type == UCLOGIC_XFER_INTERRUPT)
+			rc = uclogic_probe_interface(hdev, xfer->data,
+						     xfer->len, xfer->idx);
+		else
+			rc = uclogic_params_xfer(hdev, xfer->type, xfer->idx,
+						 buf, xfer->len);
+
+		/* The tablet might have been replaced, or reconfigured */
+		if (rc != xfer->res ||
+		    (rc > 0 && memcmp(buf, xfer->data, rc) != 0)) {
+			hid_dbg(hdev,
+				"enabling transfer #%u answered differently: %d, expected %d\n",
+				i, rc, xfer->res);
+			rc = -ESTALE;
+			goto cleanup;
+		}
+	}
+
+	rc = 0;
+cleanup:
+	kfree(buf);
+	return rc;
+}
+
 #ifdef CONFIG_HID_KUNIT_TEST
 #include "hid-uclogic-params-test.c"
 #endif
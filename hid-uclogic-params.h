@@ -19,6 +19,12 @@
 #include <linux/usb.h>
 #include <linux/hid.h>
 #include <linux/list.h>
+#include <linux/cache.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
 
 #define UCLOGIC_MOUSE_FRAME_QUIRK	BIT(0)
 #define UCLOGIC_BATTERY_QUIRK		BIT(1)
@@ -61,6 +67,24 @@ struct uclogic_params_pen_subreport {
 	__u8 id;
 };
 
+/*
+ * Pen report's proximity-out signature.
+ */
+struct uclogic_params_pen_proximity_out {
+	/*
+	 * Offset of the pen report byte to match. If zero, the signature
+	 * should be considered invalid and not matched.
+	 */
+	__u8 byte;
+	/* Mask of the byte bits to match */
+	__u8 mask;
+	/*
+	 * The value of the masked byte indicating the pen went out of
+	 * proximity. Only valid if "byte" is not zero.
+	 */
+	__u8 value;
+};
+
 /*
  * Tablet interface's pen input parameters.
  *
@@ -103,6 +127,13 @@ struct uclogic_params_pen {
 	 * Only valid if "id" is not zero.
 	 */
 	bool tilt_y_flipped;
+	/*
+	 * The list of signatures of the reports sent when the pen goes out of
+	 * proximity. Only valid if "inrange" is
+	 * UCLOGIC_PARAMS_PEN_INRANGE_NONE, so only declared for Huion v2
+	 * pens, as e.g. UGEE v2 pens report in-range state themselves.
+	 */
+	struct uclogic_params_pen_proximity_out proximity_out_list[2];
 };
 
 /*
@@ -183,11 +214,81 @@ struct uclogic_params_frame {
 struct uclogic_raw_event_hook {
 	struct hid_device *hdev;
 	__u8 *event;
+	/*
+	 * Mask of the event bits to match, of the same size as the event.
+	 * NULL if all bits should be matched.
+	 */
+	__u8 *mask;
 	size_t size;
 	struct work_struct work;
 	struct list_head list;
+	/* Registration order number, the hooks registered first match first */
+	unsigned int index;
+	/* Next hook in the same matcher chain, NULL if none */
+	struct uclogic_raw_event_hook *next;
+};
+
+/* Number of raw event hook matcher buckets, a power of two */
+#define UCLOGIC_RAW_EVENT_HOOK_BUCKETS	16
+
+/*
+ * Raw event hooks of a tablet interface, along with a matcher built as they
+ * are registered, rejecting most events on their size and first byte, and
+ * otherwise finding the candidate hooks by hashing the event size with the
+ * first two bytes, instead of comparing every hook.
+ */
+struct uclogic_raw_event_hooks {
+	/* The list of hooks, in registration order */
+	struct list_head list;
+	/* Number of hooks in the list */
+	unsigned int num;
+	/*
+	 * Bitmap of the hooked event sizes, with bit N - 1 set for size N,
+	 * and the most significant bit set for sizes 64 and above.
+	 */
+	u64 sizes;
+	/* Bitmap of the first bytes the hooked events can have */
+	DECLARE_BITMAP(first_bytes, 256);
+	/*
+	 * Chains of hooks with the first two bytes not masked, hashed on the
+	 * event size and those bytes, in registration order.
+	 */
+	struct uclogic_raw_event_hook *buckets[UCLOGIC_RAW_EVENT_HOOK_BUCKETS];
+	/* Chain of the rest of the hooks, in registration order */
+	struct uclogic_raw_event_hook *wildcards;
 };
 
+/**
+ * uclogic_raw_event_hooks_size_bit() - get the bit representing an event
+ * size in the "sizes" bitmap of struct uclogic_raw_event_hooks.
+ *
+ * @size:	The event size, must be greater than zero.
+ *
+ * Returns:
+ *	The bit for the size.
+ */
+static inline u64 uclogic_raw_event_hooks_size_bit(size_t size)
+{
+	return BIT_ULL(min_t(size_t, size, 64) - 1);
+}
+
+/**
+ * uclogic_raw_event_hooks_bucket() - get the matcher bucket index of a raw
+ * event.
+ *
+ * @event:	The event, at least two bytes long.
+ * @size:	The event size.
+ *
+ * Returns:
+ *	The index of the bucket in struct uclogic_raw_event_hooks.
+ */
+static inline unsigned int uclogic_raw_event_hooks_bucket(const __u8 *event,
+							  size_t size)
+{
+	return hash_32(((u32)size << 16) | (event[0] << 8) | event[1],
+			ilog2(UCLOGIC_RAW_EVENT_HOOK_BUCKETS));
+}
+
 /*
  * Tablet interface report parameters.
  *
@@ -229,15 +330,423 @@ struct uclogic_params {
 	 */
 	struct uclogic_params_frame frame_list[4];
 	/*
-	 * List of event hooks.
+	 * Event hooks, NULL if none.
+	 */
+	struct uclogic_raw_event_hooks *event_hooks;
+};
+
+/* Handlers of raw reports, as selected by report ID */
+enum uclogic_raw_handler {
+	/* No handling, pass the report unchanged */
+	UCLOGIC_RAW_HANDLER_NONE = 0,
+	/* Pen report handling */
+	UCLOGIC_RAW_HANDLER_PEN,
+	/* Frame report handling, plus the index in the frame list */
+	UCLOGIC_RAW_HANDLER_FRAME,
+};
+
+/*
+ * Raw report dispatch map of a tablet interface, derived from its parameters
+ * at probe time. Lets the raw event handler route a report with an indexed
+ * load or two, instead of scanning the subreport and the frame lists.
+ *
+ * Noop (passes all reports unchanged) when filled with zeroes.
+ */
+struct uclogic_raw_map {
+	/*
+	 * True if no report of the interface should be tweaked, false
+	 * otherwise.
+	 */
+	bool passthrough;
+	/*
+	 * Report handlers, indexed by report ID. One of enum
+	 * uclogic_raw_handler values.
+	 */
+	__u8 handler[256];
+	/*
+	 * Subreport IDs to assign to pen reports, indexed by the value of the
+	 * second byte of the pen report. Zero if the value doesn't indicate a
+	 * subreport.
+	 */
+	__u8 subreport_id[256];
+};
+
+/* Raw report rewrite operation codes */
+enum uclogic_raw_op_code {
+	/* End of program */
+	UCLOGIC_RAW_OP_END = 0,
+	/* Copy the original "src" byte to "dst" */
+	UCLOGIC_RAW_OP_MOVE,
+	/* XOR the "dst" byte with "arg" */
+	UCLOGIC_RAW_OP_XOR,
+	/* OR the "dst" byte with "arg" */
+	UCLOGIC_RAW_OP_OR,
+	/* Negate the "dst" byte */
+	UCLOGIC_RAW_OP_NEG,
+	/* Set the "dst" byte to "arg" */
+	UCLOGIC_RAW_OP_SET,
+	/* Map the original "src" byte through table "arg" into "dst" */
+	UCLOGIC_RAW_OP_MAP,
+	/*
+	 * Replace the 2-bit Gray-coded rotary encoder state at bit "arg" of
+	 * the "dst" byte with the 2-bit signed state change
+	 */
+	UCLOGIC_RAW_OP_ENCODER,
+	/* Restart the pen in-range timeout */
+	UCLOGIC_RAW_OP_INRANGE,
+	/*
+	 * If table "arg" maps the original "src" byte to non-zero, clear the
+	 * bits it maps to in the "dst" byte, and stop the pen in-range timeout,
+	 * as the pen went out of proximity
+	 */
+	UCLOGIC_RAW_OP_PROXIMITY_OUT,
+};
+
+/*
+ * Raw report rewrite operation.
+ */
+struct uclogic_raw_op {
+	/* Operation code, one of enum uclogic_raw_op_code */
+	__u8 code;
+	/* Minimum report size to perform the operation at, bytes */
+	__u8 min_size;
+	/* Offset of the byte to write */
+	__u8 dst;
+	/* Offset of the byte to read, in the original report */
+	__u8 src;
+	/* Operation argument */
+	__u8 arg;
+};
+
+/* Maximum number of operations in a raw report rewrite program */
+#define UCLOGIC_RAW_PROG_LEN	12
+
+/* Maximum offset of a byte read by a rewrite program, plus one */
+#define UCLOGIC_RAW_PROG_SRC_MAX	32
+
+/*
+ * Raw report rewrite program: a sequence of operations modifying a report
+ * in place. Operations are performed in order, and read their "src" bytes
+ * from the original report, before any modifications.
+ *
+ * Noop when filled with zeroes.
+ */
+struct uclogic_raw_prog {
+	/* Number of the original report bytes read by the operations */
+	__u8 src_size;
+	/* Operations, terminated with UCLOGIC_RAW_OP_END if not full */
+	struct uclogic_raw_op ops[UCLOGIC_RAW_PROG_LEN];
+};
+
+/* Maximum number of byte mapping tables of a tablet interface */
+#define UCLOGIC_RAW_TABLES	6
+
+/*
+ * Flag of struct uclogic_raw "inrange_state" set while a pen report is
+ * being delivered, from the raw event until the report callback
+ */
+#define UCLOGIC_INRANGE_REPORT	0x1
+/*
+ * Flag of struct uclogic_raw "inrange_state" set while the in-range timer
+ * is delivering a pen-out
+ */
+#define UCLOGIC_INRANGE_OUT	0x2
+/* Increment of struct uclogic_raw "inrange_state" for each pen report */
+#define UCLOGIC_INRANGE_GEN	0x4
+
+/* Number of buckets in the histogram of intervals between reports */
+#define UCLOGIC_STATS_INTERVALS	24
+
+/*
+ * Raw report handling statistics of a tablet interface, kept per CPU, so
+ * they're updated without locking, or sharing cache lines between CPUs.
+ */
+struct uclogic_stats {
+	/*
+	 * Input reports received, indexed by report ID, wrapping. 32-bit, to
+	 * keep the per-CPU copies small.
+	 */
+	u32 reports[256];
+	/* Pen reports changed to subreports, indexed by subreport ID */
+	u32 subreports[256];
+	/* Input reports not handled by a hook, or the pen or frame handlers */
+	unsigned long unmatched;
+	/* Pen or frame reports too short to be handled completely */
+	unsigned long short_reports;
+	/* Input reports handled by raw event hooks */
+	unsigned long hooks;
+	/* Pen out-of-range events emulated on in-range timeout */
+	unsigned long pen_outs;
+	/* Pen in-range timer expirations, including the ones restarting it */
+	unsigned long inrange_timeouts;
+	/* Rotary encoder steps clockwise */
+	unsigned long encoder_cw;
+	/* Rotary encoder steps counterclockwise */
+	unsigned long encoder_ccw;
+	/*
+	 * Intervals between input reports: less than a microsecond in the
+	 * first bucket, and at least 2^(N-1) microseconds in bucket N,
+	 * less than twice that in all buckets but the last one.
 	 */
-	struct uclogic_raw_event_hook *event_hooks;
+	unsigned long intervals[UCLOGIC_STATS_INTERVALS];
+};
+
+/* Number of entries in a raw report capture ring, a power of two */
+#define UCLOGIC_CAPTURE_ENTRIES		1024
+/* Maximum number of bytes of a report captured */
+#define UCLOGIC_CAPTURE_DATA_MAX	32
+
+/* A captured raw report */
+struct uclogic_capture_entry {
+	/* Time the report was received, ns */
+	u64 time;
+	/* Report size, bytes, only the first UCLOGIC_CAPTURE_DATA_MAX kept */
+	int size;
+	/* The report as received */
+	__u8 orig[UCLOGIC_CAPTURE_DATA_MAX];
+	/* The report as rewritten by the driver */
+	__u8 data[UCLOGIC_CAPTURE_DATA_MAX];
+};
+
+/*
+ * A ring of captured raw reports, with a single producer - the raw report
+ * handling - and a single consumer - the reader, which never wait for each
+ * other. Reports arriving when the ring is full are dropped and counted.
+ */
+struct uclogic_capture {
+	/* Number of entries ever written, only updated by the producer */
+	unsigned int head;
+	/* Number of entries ever read, only updated by the consumer */
+	unsigned int tail ____cacheline_aligned;
+	/* Number of reports dropped as the ring was full */
+	unsigned long dropped ____cacheline_aligned;
+	/* The entries, indexed by head or tail modulo their number */
+	struct uclogic_capture_entry entries[UCLOGIC_CAPTURE_ENTRIES];
+};
+
+/*
+ * Data the raw report handling of a tablet interface reads or updates for
+ * every report, derived from its parameters at probe time and kept
+ * together, so handling a report touches as few cache lines as possible.
+ * The scalar fields come first, followed by the programs, and the dispatch
+ * map and the tables, of which only the entries indexed by the report are
+ * read. Rarely changing debugging and timing state is kept out of it.
+ *
+ * Noop (passes all reports unchanged) when filled with zeroes.
+ */
+struct uclogic_raw {
+	/* True if the interface has raw event hooks, false otherwise */
+	bool event_hooks;
+	/*
+	 * Last rotary encoder state, zero initially, as the state changes
+	 * from it are not detected
+	 */
+	__u8 re_state;
+	/* Time of the last pen report restarting in-range timeout, ns */
+	u64 inrange_last;
+	/*
+	 * Pen in-range state handed off between the report path and the
+	 * in-range timer: the UCLOGIC_INRANGE_REPORT and
+	 * UCLOGIC_INRANGE_OUT flags, and the number of pen reports
+	 * restarting in-range timeout in the rest of the bits, wrapping
+	 */
+	atomic_t inrange_state;
+	/*
+	 * Value of "inrange_state", without the flags, when the in-range
+	 * timer was last started by the report path, or restarted itself
+	 */
+	int inrange_timer_state;
+	/* Pen in-range timeout, ms */
+	unsigned int inrange_timeout_ms;
+	/* Recent intervals between pen reports within a stroke, ns */
+	u32 inrange_intervals[8];
+	/* Index of the next element of "inrange_intervals" to write */
+	__u8 inrange_interval_idx;
+	/* Pen report rewrite program */
+	struct uclogic_raw_prog pen;
+	/* Frame report rewrite programs, indexed as in frame_list */
+	struct uclogic_raw_prog frame_list[4];
+	/* Report dispatch map */
+	struct uclogic_raw_map map;
+	/* Byte mapping tables for UCLOGIC_RAW_OP_MAP operations */
+	__u8 tables[UCLOGIC_RAW_TABLES][256];
+};
+
+/*
+ * Transport used to talk to a tablet interface while discovering its
+ * parameters. Replaced with scripted responses for testing.
+ */
+struct uclogic_transport {
+	/*
+	 * Get the number of the interface, and the number of interfaces in
+	 * its configuration. Returns zero, or a negative errno code,
+	 * -EINVAL if the device is not on this transport.
+	 */
+	int (*get_iface)(struct hid_device *hdev, __u8 *pnum,
+			 __u8 *pnum_ifaces);
+	/*
+	 * Retrieve a string descriptor as is, into a buffer of "len" bytes.
+	 * Returns the number of bytes retrieved, -EPIPE if the descriptor
+	 * was not found, or another negative errno code.
+	 */
+	int (*get_str_desc)(struct hid_device *hdev, __u8 idx,
+			    __u8 *buf, size_t len);
+	/*
+	 * Retrieve a string descriptor as a NUL-terminated ASCII string,
+	 * into a buffer of "len" bytes. Returns the length of the string,
+	 * -EPIPE if the descriptor was not found, or another negative errno
+	 * code.
+	 */
+	int (*get_string)(struct hid_device *hdev, __u8 idx,
+			  char *buf, size_t len);
+	/*
+	 * Send "len" bytes to an interrupt OUT endpoint, storing the number
+	 * of bytes sent in "psent". Returns zero, or a negative errno code.
+	 */
+	int (*send_interrupt)(struct hid_device *hdev, int endpoint,
+			      __u8 *buf, size_t len, int *psent);
+	/*
+	 * Get the product string of the device, truncated to fit into a
+	 * buffer of "len" bytes, NUL-terminated. Returns the length of the
+	 * string, -ENODATA if there is none, or another negative errno code.
+	 */
+	int (*get_product)(struct hid_device *hdev, char *buf, size_t len);
+};
+
+/* Transport for tablets attached via USB */
+extern const struct uclogic_transport uclogic_transport_usb;
+
+/* Check if a HID device is attached via USB */
+extern bool uclogic_transport_is_usb(struct hid_device *hdev);
+
+/*
+ * Virtual tablets, e.g. created with uhid, supply what USB tablets have in
+ * their descriptors via a handshake over a feature report. The driver sets
+ * the report to a request: {ID, request, index, length, data...}, and then
+ * gets it to read the answer: {ID, status, length, data...}, where status
+ * is zero, or a positive errno code.
+ */
+#define UCLOGIC_VIRTUAL_REPORT_ID	0xfd
+#define UCLOGIC_VIRTUAL_REPORT_SIZE	64
+/* Maximum size of request and answer data */
+#define UCLOGIC_VIRTUAL_DATA_MAX	(UCLOGIC_VIRTUAL_REPORT_SIZE - 4)
+
+/* Virtual tablet handshake requests */
+enum uclogic_virtual_req {
+	/*
+	 * Get the interface number and the number of interfaces, as two
+	 * bytes
+	 */
+	UCLOGIC_VIRTUAL_REQ_IFACE = 1,
+	/* Get the string descriptor with the index, as is */
+	UCLOGIC_VIRTUAL_REQ_STR_DESC,
+	/* Get the string descriptor with the index, as an ASCII string */
+	UCLOGIC_VIRTUAL_REQ_STRING,
+	/* Send the data to the interrupt endpoint with the index */
+	UCLOGIC_VIRTUAL_REQ_INTERRUPT,
+	/* Get the product string, as an ASCII string */
+	UCLOGIC_VIRTUAL_REQ_PRODUCT,
+};
+
+/* Transport for virtual tablets, using the handshake */
+extern const struct uclogic_transport uclogic_transport_virtual;
+
+/* Phases of probing or resuming a tablet interface, timed separately */
+enum uclogic_probe_phase {
+	/* Retrieving strings, e.g. the firmware version */
+	UCLOGIC_PROBE_PHASE_STRING,
+	/* Retrieving string descriptors as is, e.g. the parameters */
+	UCLOGIC_PROBE_PHASE_STR_DESC,
+	/* Sending interrupt transfers, e.g. switching to the vendor mode */
+	UCLOGIC_PROBE_PHASE_INTERRUPT,
+	/* Discovering the parameters, including all of the above */
+	UCLOGIC_PROBE_PHASE_PARAMS,
+	/* Generating the replacement report descriptor */
+	UCLOGIC_PROBE_PHASE_DESC,
+	/* Parsing the report descriptor */
+	UCLOGIC_PROBE_PHASE_PARSE,
+	/* Starting the hardware and connecting the input devices */
+	UCLOGIC_PROBE_PHASE_HW_START,
+	/* The whole probe or resume */
+	UCLOGIC_PROBE_PHASE_TOTAL,
+	/* Number of phases */
+	UCLOGIC_PROBE_PHASES
+};
+
+/* Maximum number of enabling transfers to replay on resume */
+#define UCLOGIC_ENABLE_XFERS	4
+/* Maximum size of an enabling transfer's data */
+#define UCLOGIC_ENABLE_DATA_MAX	32
+
+/* Kinds of transfers to a tablet interface, made over its transport */
+enum uclogic_xfer_type {
+	/* Retrieving a string descriptor as is */
+	UCLOGIC_XFER_STR_DESC,
+	/* Retrieving a string descriptor as an ASCII string */
+	UCLOGIC_XFER_STRING,
+	/* Sending data to an interrupt endpoint */
+	UCLOGIC_XFER_INTERRUPT,
+};
+
+/*
+ * A transfer made while discovering the parameters, which switches the
+ * tablet to the mode the parameters are for
+ */
+struct uclogic_enable_xfer {
+	enum uclogic_xfer_type type;
+	/* String descriptor index, or endpoint */
+	int idx;
+	/* Number of bytes requested, or sent */
+	size_t len;
+	/*
+	 * Result of the transfer: the number of bytes retrieved, zero if
+	 * sent, or a negative errno code
+	 */
+	int res;
+	/* Data retrieved, the first "res" bytes, or sent, "len" bytes */
+	__u8 data[UCLOGIC_ENABLE_DATA_MAX];
+};
+
+/*
+ * Enabling transfers of a tablet interface, recorded while discovering its
+ * parameters, to replay and verify on resume instead of discovering them
+ * again
+ */
+struct uclogic_enable {
+	/* The transfers, in the order they were made */
+	struct uclogic_enable_xfer xfers[UCLOGIC_ENABLE_XFERS];
+	/* Number of transfers recorded */
+	unsigned int num;
+	/* True if a transfer could not be recorded, false otherwise */
+	bool overflow;
+	/*
+	 * True if all the transfers were recorded, and the parameters
+	 * discovered with them, false otherwise
+	 */
+	bool valid;
 };
 
 /* Driver data */
 struct uclogic_drvdata {
+	/* Raw report handling data */
+	struct uclogic_raw raw;
+	/* Report handling statistics to update, NULL if not collected */
+	struct uclogic_stats __percpu *stats_active;
+	/* Ring to capture the reports into, NULL if not capturing */
+	struct uclogic_capture *capture_active;
+	/*
+	 * Time the last probe or resume started, ns, zero once an input
+	 * report arrived after it
+	 */
+	u64 probe_start;
+	/* Time of the last input report, ns, zero if none yet */
+	u64 stats_last;
 	/* Interface parameters */
 	struct uclogic_params params;
+	/* HID device the driver data belongs to */
+	struct hid_device *hdev;
+	/* Transport to talk to the interface with, when getting parameters */
+	const struct uclogic_transport *transport;
 	/* Pointer to the replacement report descriptor. NULL if none. */
 	__u8 *desc_ptr;
 	/*
@@ -249,21 +758,106 @@ struct uclogic_drvdata {
 	struct input_dev *pen_input;
 	/* In-range timer */
 	struct timer_list inrange_timer;
-	/* Last rotary encoder state, or U8_MAX for none */
-	u8 re_state;
+	/* Pen in-range timeout set by the user, ms, zero if none */
+	unsigned int inrange_timeout_override_ms;
+	/* Median interval between pen reports, us, zero if not known */
+	unsigned int inrange_interval_us;
+	/* Report handling statistics, NULL if never enabled */
+	struct uclogic_stats __percpu *stats;
+	/* Lock for enabling the report handling statistics */
+	struct mutex stats_lock;
+	/* Report handling statistics debugfs file, NULL if none */
+	struct dentry *stats_file;
+	/* Report handling statistics switch debugfs file, NULL if none */
+	struct dentry *stats_enable_file;
+	/* Report capture ring, NULL if capturing was never enabled */
+	struct uclogic_capture *capture;
+	/* Lock for enabling report capture and reading the ring */
+	struct mutex capture_lock;
+	/* Value of the capture ring's "dropped" reported last */
+	unsigned long capture_dropped;
+	/* Report capture ring debugfs file, NULL if none */
+	struct dentry *capture_file;
+	/* Report capture switch debugfs file, NULL if none */
+	struct dentry *capture_enable_file;
+	/*
+	 * Durations of the last probe or resume phases, ns. Interrupt
+	 * transfers of the reconnection work are added to them as well.
+	 */
+	u64 probe_ns[UCLOGIC_PROBE_PHASES];
+	/* True if the phases were timed for a resume, false for a probe */
+	bool probe_resume;
+	/*
+	 * Time from the start of the last probe or resume to the first input
+	 * report after it, ns, zero if none yet
+	 */
+	u64 first_report_ns;
+	/* Probe timing debugfs file, NULL if none */
+	struct dentry *probe_file;
+	/* Enabling transfers made discovering the parameters */
+	struct uclogic_enable enable;
+	/*
+	 * Time the transfers of the probe or resume in progress must be
+	 * made by, ns, zero if none in progress, or there's no limit
+	 */
+	u64 probe_deadline;
+	/* Control transfer timeout, ms, zero for the default */
+	unsigned int ctrl_timeout_ms;
+	/* Interrupt transfer timeout, ms, zero for the default */
+	unsigned int intr_timeout_ms;
+	/* Number of times to retry a transfer failing transiently */
+	unsigned int xfer_retries;
+	/* Number of transfers retried during the last probe or resume */
+	unsigned int probe_retries;
+	/* True if the last probe or resume ran out of time for transfers */
+	bool probe_over_budget;
 	/* Device quirks */
 	unsigned long quirks;
 };
 
+/* Add the time since "start" to a probe phase duration of an interface */
+extern void uclogic_probe_phase_end(struct hid_device *hdev,
+					enum uclogic_probe_phase phase,
+					u64 start);
+
 /* Initialize a tablet interface and discover its parameters */
 extern int uclogic_params_init(struct uclogic_params *params,
 				struct hid_device *hdev);
 
+/* Maximum number of tablet interfaces to cache the parameters of */
+#define UCLOGIC_PARAMS_CACHE_ENTRIES		16
+/* Maximum size of a cached parameters string descriptor */
+#define UCLOGIC_PARAMS_CACHE_DATA_MAX		32
+/* Maximum length of a cached firmware identification, including NUL */
+#define UCLOGIC_PARAMS_CACHE_FIRMWARE_MAX	64
+
+/* Seed the parameters cache with an entry, or clear it */
+extern int uclogic_params_cache_set(const char *val);
+
+/* Format the parameters cache entries */
+extern int uclogic_params_cache_show(char *buf, size_t size);
+
+/* Remove all parameters cache entries */
+extern void uclogic_params_cache_clear(void);
+
+/* Re-enable a tablet interface by replaying its enabling transfers */
+extern int uclogic_params_resume(struct hid_device *hdev);
+
 /* Get a replacement report descriptor for a tablet's interface. */
 extern int uclogic_params_get_desc(const struct uclogic_params *params,
 					__u8 **pdesc,
 					unsigned int *psize);
 
+/* Get raw report handling data for a tablet's interface */
+extern int uclogic_params_get_raw(const struct uclogic_params *params,
+					struct uclogic_raw *raw);
+
+/* Register a raw event hook for a tablet's interface */
+extern int uclogic_params_add_event_hook(struct uclogic_params *params,
+					struct hid_device *hdev,
+					const __u8 *event, const __u8 *mask,
+					size_t size, work_func_t func);
+
 /* Free resources used by tablet interface's parameters */
 extern void uclogic_params_cleanup(struct uclogic_params *params);
 
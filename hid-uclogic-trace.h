@@ -0,0 +1,286 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - raw report handling and probing tracepoints
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM hid_uclogic
+
+#if !defined(_HID_UCLOGIC_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _HID_UCLOGIC_TRACE_H
+
+#include <linux/hid.h>
+#include <linux/tracepoint.h>
+#include "hid-uclogic-params.h"
+
+#ifndef _HID_UCLOGIC_TRACE_TYPES
+#define _HID_UCLOGIC_TRACE_TYPES
+
+/* Maximum number of rewritten report bytes to record */
+#define UCLOGIC_TRACE_DATA_MAX	12
+
+/* Outcomes of the pen in-range timeout */
+enum uclogic_trace_inrange {
+	/* There were pen reports since the timer started, restarting it */
+	UCLOGIC_TRACE_INRANGE_RESTART,
+	/* There were no pen reports, the pen went out of range */
+	UCLOGIC_TRACE_INRANGE_OUT,
+};
+
+/*
+ * Record the name of the HID device, "BUS:VENDOR:PRODUCT.ID", in
+ * parts, as they are cheaper to copy than the string.
+ */
+#define UCLOGIC_TRACE_DEV_ENTRY \
+	__field(__u16, bus) \
+	__field(__u32, vendor) \
+	__field(__u32, product) \
+	__field(unsigned int, id)
+
+#define UCLOGIC_TRACE_DEV_ASSIGN(_hdev) \
+	do { \
+		__entry->bus = (_hdev)->bus; \
+		__entry->vendor = (_hdev)->vendor; \
+		__entry->product = (_hdev)->product; \
+		__entry->id = (_hdev)->id; \
+	} while (0)
+
+#define UCLOGIC_TRACE_DEV_FMT	"%04X:%04X:%04X.%04X "
+#define UCLOGIC_TRACE_DEV_ARGS \
+	__entry->bus, __entry->vendor, __entry->product, __entry->id
+
+#endif /* _HID_UCLOGIC_TRACE_TYPES */
+
+TRACE_DEFINE_ENUM(UCLOGIC_TRACE_INRANGE_RESTART);
+TRACE_DEFINE_ENUM(UCLOGIC_TRACE_INRANGE_OUT);
+
+TRACE_EVENT(uclogic_raw_event,
+
+	TP_PROTO(const struct hid_device *hdev, unsigned int report_id,
+		 unsigned int subreport_id, int size, u64 duration),
+
+	TP_ARGS(hdev, report_id, subreport_id, size, duration),
+
+	TP_STRUCT__entry(
+		UCLOGIC_TRACE_DEV_ENTRY
+		__field(__u8, report_id)
+		__field(__u8, subreport_id)
+		__field(int, size)
+		__field(u64, duration)
+	),
+
+	TP_fast_assign(
+		UCLOGIC_TRACE_DEV_ASSIGN(hdev);
+		__entry->report_id = report_id;
+		__entry->subreport_id = subreport_id;
+		__entry->size = size;
+		__entry->duration = duration;
+	),
+
+	TP_printk(UCLOGIC_TRACE_DEV_FMT
+		  "report=%02x subreport=%02x size=%d duration=%lluns",
+		  UCLOGIC_TRACE_DEV_ARGS,
+		  __entry->report_id, __entry->subreport_id, __entry->size,
+		  __entry->duration)
+);
+
+DECLARE_EVENT_CLASS(uclogic_raw_prog,
+
+	TP_PROTO(const struct hid_device *hdev, int frame,
+		 const __u8 *data, int size, u32 changed, u64 duration),
+
+	TP_ARGS(hdev, frame, data, size, changed, duration),
+
+	TP_STRUCT__entry(
+		UCLOGIC_TRACE_DEV_ENTRY
+		__field(int, frame)
+		__field(int, size)
+		__field(u32, changed)
+		__field(u64, duration)
+		__field(__u8, len)
+		__array(__u8, data, UCLOGIC_TRACE_DATA_MAX)
+	),
+
+	TP_fast_assign(
+		UCLOGIC_TRACE_DEV_ASSIGN(hdev);
+		__entry->frame = frame;
+		__entry->size = size;
+		__entry->changed = changed;
+		__entry->duration = duration;
+		__entry->len = clamp(size, 0, UCLOGIC_TRACE_DATA_MAX);
+		memcpy(__entry->data, data, __entry->len);
+	),
+
+	TP_printk(UCLOGIC_TRACE_DEV_FMT
+		  "frame=%d size=%d changed=%#x duration=%lluns data=%s",
+		  UCLOGIC_TRACE_DEV_ARGS,
+		  __entry->frame, __entry->size, __entry->changed,
+		  __entry->duration,
+		  __print_hex(__entry->data, __entry->len))
+);
+
+/* Frame is -1 for the pen */
+DEFINE_EVENT(uclogic_raw_prog, uclogic_raw_event_pen,
+
+	TP_PROTO(const struct hid_device *hdev, int frame,
+		 const __u8 *data, int size, u32 changed, u64 duration),
+
+	TP_ARGS(hdev, frame, data, size, changed, duration)
+);
+
+DEFINE_EVENT(uclogic_raw_prog, uclogic_raw_event_frame,
+
+	TP_PROTO(const struct hid_device *hdev, int frame,
+		 const __u8 *data, int size, u32 changed, u64 duration),
+
+	TP_ARGS(hdev, frame, data, size, changed, duration)
+);
+
+TRACE_EVENT(uclogic_exec_event_hook,
+
+	TP_PROTO(struct hid_device *hdev, const u8 *event, int size,
+		 const struct uclogic_raw_event_hook *hook, u64 duration),
+
+	TP_ARGS(hdev, event, size, hook, duration),
+
+	TP_STRUCT__entry(
+		UCLOGIC_TRACE_DEV_ENTRY
+		__field(__u8, report_id)
+		__field(int, size)
+		__field(bool, matched)
+		__field(unsigned int, index)
+		__field(u64, duration)
+	),
+
+	TP_fast_assign(
+		UCLOGIC_TRACE_DEV_ASSIGN(hdev);
+		__entry->report_id = size > 0 ? event[0] : 0;
+		__entry->size = size;
+		__entry->matched = hook != NULL;
+		__entry->index = hook ? hook->index : 0;
+		__entry->duration = duration;
+	),
+
+	TP_printk(UCLOGIC_TRACE_DEV_FMT
+		  "report=%02x size=%d matched=%d hook=%u duration=%lluns",
+		  UCLOGIC_TRACE_DEV_ARGS,
+		  __entry->report_id, __entry->size, __entry->matched,
+		  __entry->index, __entry->duration)
+);
+
+TRACE_EVENT(uclogic_inrange_timeout,
+
+	TP_PROTO(const struct hid_device *hdev, enum uclogic_trace_inrange action,
+		 unsigned int timeout_ms, u64 elapsed),
+
+	TP_ARGS(hdev, action, timeout_ms, elapsed),
+
+	TP_STRUCT__entry(
+		UCLOGIC_TRACE_DEV_ENTRY
+		__field(unsigned int, action)
+		__field(unsigned int, timeout_ms)
+		__field(u64, elapsed)
+	),
+
+	TP_fast_assign(
+		UCLOGIC_TRACE_DEV_ASSIGN(hdev);
+		__entry->action = action;
+		__entry->timeout_ms = timeout_ms;
+		__entry->elapsed = elapsed;
+	),
+
+	TP_printk(UCLOGIC_TRACE_DEV_FMT
+		  "action=%s timeout=%ums elapsed=%lluns",
+		  UCLOGIC_TRACE_DEV_ARGS,
+		  __print_symbolic(__entry->action,
+			{ UCLOGIC_TRACE_INRANGE_RESTART, "restart" },
+			{ UCLOGIC_TRACE_INRANGE_OUT, "out" }),
+		  __entry->timeout_ms, __entry->elapsed)
+);
+
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_STRING);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_STR_DESC);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_INTERRUPT);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_PARAMS);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_DESC);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_PARSE);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_HW_START);
+TRACE_DEFINE_ENUM(UCLOGIC_PROBE_PHASE_TOTAL);
+
+TRACE_EVENT(uclogic_probe_phase,
+
+	TP_PROTO(const struct hid_device *hdev, bool resume,
+		 enum uclogic_probe_phase phase, u64 duration),
+
+	TP_ARGS(hdev, resume, phase, duration),
+
+	TP_STRUCT__entry(
+		UCLOGIC_TRACE_DEV_ENTRY
+		__field(bool, resume)
+		__field(unsigned int, phase)
+		__field(u64, duration)
+	),
+
+	TP_fast_assign(
+		UCLOGIC_TRACE_DEV_ASSIGN(hdev);
+		__entry->resume = resume;
+		__entry->phase = phase;
+		__entry->duration = duration;
+	),
+
+	TP_printk(UCLOGIC_TRACE_DEV_FMT
+		  "event=%s phase=%s duration=%lluns",
+		  UCLOGIC_TRACE_DEV_ARGS,
+		  __entry->resume ? "resume" : "probe",
+		  __print_symbolic(__entry->phase,
+			{ UCLOGIC_PROBE_PHASE_STRING, "string" },
+			{ UCLOGIC_PROBE_PHASE_STR_DESC, "str_desc" },
+			{ UCLOGIC_PROBE_PHASE_INTERRUPT, "interrupt" },
+			{ UCLOGIC_PROBE_PHASE_PARAMS, "params" },
+			{ UCLOGIC_PROBE_PHASE_DESC, "desc" },
+			{ UCLOGIC_PROBE_PHASE_PARSE, "parse" },
+			{ UCLOGIC_PROBE_PHASE_HW_START, "hw_start" },
+			{ UCLOGIC_PROBE_PHASE_TOTAL, "total" }),
+		  __entry->duration)
+);
+
+TRACE_EVENT(uclogic_probe_first_report,
+
+	TP_PROTO(const struct hid_device *hdev, bool resume, u64 elapsed),
+
+	TP_ARGS(hdev, resume, elapsed),
+
+	TP_STRUCT__entry(
+		UCLOGIC_TRACE_DEV_ENTRY
+		__field(bool, resume)
+		__field(u64, elapsed)
+	),
+
+	TP_fast_assign(
+		UCLOGIC_TRACE_DEV_ASSIGN(hdev);
+		__entry->resume = resume;
+		__entry->elapsed = elapsed;
+	),
+
+	TP_printk(UCLOGIC_TRACE_DEV_FMT "event=%s elapsed=%lluns",
+		  UCLOGIC_TRACE_DEV_ARGS,
+		  __entry->resume ? "resume" : "probe",
+		  __entry->elapsed)
+);
+
+#endif /* _HID_UCLOGIC_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE hid-uclogic-trace
+#include <trace/define_trace.h>
@@ -0,0 +1,1055 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - userspace stand-ins for the kernel APIs
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+/*
+ * Just enough of the kernel APIs used by the driver sources to build them
+ * into a userspace library, for profiling and sanitizing the report
+ * handling and the descriptor generation. Everything touching actual
+ * devices (USB transfers, HID I/O, input devices) does nothing, or fails.
+ * There is one CPU, timers never fire by themselves, and work is never run.
+ *
+ * All the headers under include/ pull in this file.
+ */
+
+#ifndef _UCLOGIC_KERNEL_SHIM_H
+#define _UCLOGIC_KERNEL_SHIM_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+/*
+ * Versions and configuration
+ */
+#define KERNEL_VERSION(a, b, c)	(((a) << 16) + ((b) << 8) + (c))
+#define LINUX_VERSION_CODE	KERNEL_VERSION(6, 12, 0)
+#define IS_ENABLED(option)	0
+
+/*
+ * Types
+ */
+typedef uint8_t u8, __u8;
+typedef int8_t s8, __s8;
+typedef uint16_t u16, __u16, __le16;
+typedef int16_t s16, __s16;
+typedef uint32_t u32, __u32, __le32;
+typedef int32_t s32, __s32;
+typedef uint64_t u64, __u64;
+typedef int64_t s64, __s64;
+typedef unsigned int gfp_t;
+typedef unsigned short umode_t;
+typedef unsigned long long cycles_t;
+
+/*
+ * Compiler and helper macros
+ */
+#define __user
+#define __percpu
+#define __force
+#define __maybe_unused		__attribute__((unused))
+#define __packed		__attribute__((packed))
+#define SMP_CACHE_BYTES		64
+#define ____cacheline_aligned	__attribute__((aligned(SMP_CACHE_BYTES)))
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+#define fallthrough		__attribute__((fallthrough))
+#define READ_ONCE(x)		(*(const volatile typeof(x) *)&(x))
+#define WRITE_ONCE(x, v)	(*(volatile typeof(x) *)&(x) = (v))
+#define smp_store_release(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define smp_load_acquire(p)	__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define BUILD_BUG_ON(c)		_Static_assert(!(c), #c)
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define BIT(n)			(1UL << (n))
+#define BIT_ULL(n)		(1ULL << (n))
+#define BITS_PER_LONG		(sizeof(long) * CHAR_BIT)
+#define BITS_TO_LONGS(n)	(((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define DECLARE_BITMAP(name, bits) \
+	unsigned long name[BITS_TO_LONGS(bits)]
+#define U8_MAX			0xff
+#define U16_MAX			0xffff
+#define U32_MAX			0xffffffffU
+#define S32_MAX			0x7fffffff
+#define NSEC_PER_USEC		1000L
+#define NSEC_PER_MSEC		1000000L
+#define NSEC_PER_SEC		1000000000L
+#define USEC_PER_MSEC		1000L
+#define HZ			250
+#define PAGE_SIZE		4096
+#define ENOTSUPP		524
+#define min(a, b)		((a) < (b) ? (a) : (b))
+#define max(a, b)		((a) > (b) ? (a) : (b))
+#define min_t(t, a, b)		min((t)(a), (t)(b))
+#define max_t(t, a, b)		max((t)(a), (t)(b))
+#define clamp(v, lo, hi)	min(max(v, lo), hi)
+#define clamp_t(t, v, lo, hi)	min_t(t, max_t(t, v, lo), hi)
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+#define ilog2(n)		(63 - __builtin_clzll((unsigned long long)(n)))
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+#define __stringify_1(x)	#x
+#define __stringify(x)		__stringify_1(x)
+#define IS_ERR(p)		((unsigned long)(p) >= (unsigned long)-4095)
+#define IS_ERR_OR_NULL(p)	((p) == NULL || IS_ERR(p))
+#define PTR_ERR(p)		((long)(p))
+#define ERR_PTR(e)		((void *)(long)(e))
+#define do_div(n, base) \
+	({ u32 __rem = (n) % (base); (n) /= (base); __rem; })
+
+static inline u64 div_u64(u64 dividend, u32 divisor)
+{
+	return dividend / divisor;
+}
+
+#define WARN_ON(c) \
+	({ \
+		int __c = !!(c); \
+		if (__c) \
+			fprintf(stderr, "WARN_ON at %s:%d\n", \
+				__FILE__, __LINE__); \
+		__c; \
+	})
+
+/*
+ * Memory
+ */
+#define GFP_KERNEL	0
+#define GFP_ATOMIC	0
+
+static inline void *kmalloc(size_t size, gfp_t flags)
+{
+	return malloc(size ? size : 1);
+}
+
+static inline void *kzalloc(size_t size, gfp_t flags)
+{
+	return calloc(1, size ? size : 1);
+}
+
+static inline void *krealloc(const void *p, size_t size, gfp_t flags)
+{
+	return realloc((void *)p, size ? size : 1);
+}
+
+static inline void *kmemdup(const void *src, size_t size, gfp_t flags)
+{
+	void *p = kmalloc(size, flags);
+
+	if (p != NULL)
+		memcpy(p, src, size);
+	return p;
+}
+
+static inline void kfree(const void *p)
+{
+	free((void *)p);
+}
+
+#define kvzalloc	kzalloc
+#define kvfree		kfree
+
+/*
+ * Strings
+ */
+/* Out of line, as GCC takes the bound for the source size when inlining it */
+ssize_t strscpy(char *dst, const char *src, size_t size);
+
+static inline bool strstarts(const char *str, const char *prefix)
+{
+	return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+static inline int kstrtouint(const char *s, unsigned int base,
+			     unsigned int *res)
+{
+	unsigned long long v;
+	char *end;
+
+	errno = 0;
+	v = strtoull(s, &end, base);
+	if (end == s || *s == '-')
+		return -EINVAL;
+	if (*end == '\n')
+		end++;
+	if (*end != '\0')
+		return -EINVAL;
+	if (errno != 0 || v > UINT_MAX)
+		return -ERANGE;
+	*res = v;
+	return 0;
+}
+
+static inline int scnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	if (size == 0)
+		return 0;
+	va_start(args, fmt);
+	n = vsnprintf(buf, size, fmt, args);
+	va_end(args);
+	return n >= (int)size ? (int)size - 1 : n;
+}
+
+static inline char *bin2hex(char *dst, const void *src, size_t count)
+{
+	static const char digits[] = "0123456789abcdef";
+	const u8 *p = src;
+
+	while (count--) {
+		*dst++ = digits[*p >> 4];
+		*dst++ = digits[*p++ & 0xf];
+	}
+	return dst;
+}
+
+static inline int hex2bin(u8 *dst, const char *src, size_t count)
+{
+	unsigned int v;
+
+	while (count--) {
+		if (!isxdigit(src[0]) || !isxdigit(src[1]) ||
+		    sscanf(src, "%2x", &v) != 1)
+			return -EINVAL;
+		*dst++ = v;
+		src += 2;
+	}
+	return 0;
+}
+
+static inline void sort(void *base, size_t num, size_t size,
+			int (*cmp)(const void *, const void *),
+			void (*swap)(void *, void *, int))
+{
+	qsort(base, num, size, cmp);
+}
+
+/*
+ * Byte order, the userspace build assumes little-endian hosts
+ */
+#define cpu_to_le16(v)		((__le16)(v))
+#define cpu_to_le32(v)		((__le32)(v))
+#define le16_to_cpu(v)		((u16)(v))
+#define put_unaligned(v, p) \
+	memcpy((p), &(typeof(*(p))){ (v) }, sizeof(*(p)))
+
+static inline u16 get_unaligned_le16(const void *p)
+{
+	const u8 *b = p;
+
+	return b[0] | (b[1] << 8);
+}
+
+/*
+ * Lists
+ */
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline void list_add_tail(struct list_head *entry,
+				 struct list_head *head)
+{
+	entry->prev = head->prev;
+	entry->next = head;
+	head->prev->next = entry;
+	head->prev = entry;
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+	entry->next = NULL;
+	entry->prev = NULL;
+}
+
+#define list_entry(ptr, type, member)	container_of(ptr, type, member)
+#define list_for_each_entry(pos, head, member) \
+	for (pos = list_entry((head)->next, typeof(*pos), member); \
+	     &pos->member != (head); \
+	     pos = list_entry(pos->member.next, typeof(*pos), member))
+#define list_for_each_entry_safe(pos, n, head, member) \
+	for (pos = list_entry((head)->next, typeof(*pos), member), \
+	     n = list_entry(pos->member.next, typeof(*pos), member); \
+	     &pos->member != (head); \
+	     pos = n, n = list_entry(n->member.next, typeof(*n), member))
+
+/*
+ * Bits
+ */
+static inline void __set_bit(long nr, volatile unsigned long *addr)
+{
+	addr[nr / BITS_PER_LONG] |= 1UL << (nr % BITS_PER_LONG);
+}
+
+static inline void __clear_bit(long nr, volatile unsigned long *addr)
+{
+	addr[nr / BITS_PER_LONG] &= ~(1UL << (nr % BITS_PER_LONG));
+}
+
+static inline int test_bit(long nr, const volatile unsigned long *addr)
+{
+	return (addr[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1;
+}
+
+static inline u32 hash_32(u32 val, unsigned int bits)
+{
+	return (val * 0x61C88647U) >> (32 - bits);
+}
+
+/*
+ * Locking, everything runs in a single thread
+ */
+struct mutex {
+	int unused;
+};
+
+struct semaphore {
+	int count;
+};
+
+#define DEFINE_MUTEX(lock)	struct mutex lock
+#define mutex_init(lock)	((void)(lock))
+#define mutex_destroy(lock)	((void)(lock))
+#define mutex_lock(lock)	((void)(lock))
+#define mutex_unlock(lock)	((void)(lock))
+
+static inline void sema_init(struct semaphore *sem, int val)
+{
+	sem->count = val;
+}
+
+static inline int down_trylock(struct semaphore *sem)
+{
+	if (sem->count <= 0)
+		return 1;
+	sem->count--;
+	return 0;
+}
+
+static inline void up(struct semaphore *sem)
+{
+	sem->count++;
+}
+
+typedef struct {
+	int counter;
+} atomic_t;
+
+#define ATOMIC_INIT(i)		{ (i) }
+#define atomic_read(v)		__atomic_load_n(&(v)->counter, __ATOMIC_RELAXED)
+#define atomic_set(v, i)	__atomic_store_n(&(v)->counter, (i), \
+						 __ATOMIC_RELAXED)
+#define atomic_inc(v)		((void)__atomic_add_fetch(&(v)->counter, 1, \
+							  __ATOMIC_SEQ_CST))
+#define atomic_sub(i, v)	((void)__atomic_sub_fetch(&(v)->counter, (i), \
+							  __ATOMIC_SEQ_CST))
+
+static inline int atomic_cmpxchg(atomic_t *v, int old, int new)
+{
+	__atomic_compare_exchange_n(&v->counter, &old, new, false,
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return old;
+}
+
+#define local_irq_save(flags)	((void)((flags) = 0))
+#define local_irq_restore(flags)	((void)(flags))
+#define cpu_relax()		do { } while (0)
+
+/*
+ * Time
+ */
+extern unsigned long jiffies;
+
+static inline u64 ktime_get_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static inline cycles_t get_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static inline unsigned long msecs_to_jiffies(unsigned int ms)
+{
+	return DIV_ROUND_UP((unsigned long)ms * HZ, 1000);
+}
+
+static inline unsigned long nsecs_to_jiffies(u64 ns)
+{
+	return ns * HZ / NSEC_PER_SEC;
+}
+
+static inline void msleep(unsigned int ms)
+{
+	struct timespec ts = {
+		.tv_sec = ms / 1000,
+		.tv_nsec = (long)(ms % 1000) * NSEC_PER_MSEC,
+	};
+
+	nanosleep(&ts, NULL);
+}
+
+/*
+ * Timers, only fired explicitly with um_timer_fire()
+ */
+struct timer_list {
+	unsigned long expires;
+	void (*function)(struct timer_list *);
+	bool pending;
+};
+
+static inline void timer_setup(struct timer_list *timer,
+			       void (*function)(struct timer_list *),
+			       unsigned int flags)
+{
+	timer->function = function;
+	timer->pending = false;
+}
+
+static inline int mod_timer(struct timer_list *timer, unsigned long expires)
+{
+	int pending = timer->pending;
+
+	timer->expires = expires;
+	timer->pending = true;
+	return pending;
+}
+
+static inline int timer_pending(const struct timer_list *timer)
+{
+	return timer->pending;
+}
+
+static inline int del_timer(struct timer_list *timer)
+{
+	int pending = timer->pending;
+
+	timer->pending = false;
+	return pending;
+}
+
+#define del_timer_sync		del_timer
+#define timer_delete		del_timer
+#define timer_delete_sync	del_timer
+#define from_timer(var, timer, field) \
+	container_of(timer, typeof(*var), field)
+
+/* Run a pending timer's function, as if it expired */
+static inline void um_timer_fire(struct timer_list *timer)
+{
+	if (del_timer(timer))
+		timer->function(timer);
+}
+
+/*
+ * Work, never run
+ */
+struct work_struct {
+	void (*func)(struct work_struct *work);
+	bool pending;
+};
+
+typedef void (*work_func_t)(struct work_struct *work);
+
+#define INIT_WORK(work, f) \
+	do { \
+		(work)->func = (f); \
+		(work)->pending = false; \
+	} while (0)
+
+static inline bool schedule_work(struct work_struct *work)
+{
+	bool queued = !work->pending;
+
+	work->pending = true;
+	return queued;
+}
+
+static inline bool cancel_work_sync(struct work_struct *work)
+{
+	bool pending = work->pending;
+
+	work->pending = false;
+	return pending;
+}
+
+/*
+ * Per-CPU data, for the single CPU
+ */
+#define alloc_percpu(type)		((type *)kzalloc(sizeof(type), 0))
+#define free_percpu(ptr)		kfree(ptr)
+#define per_cpu_ptr(ptr, cpu)		(ptr)
+#define this_cpu_inc(var)		((var)++)
+#define for_each_possible_cpu(cpu)	for ((cpu) = 0; (cpu) < 1; (cpu)++)
+
+/*
+ * Devices, sysfs and debugfs
+ */
+struct kobject {
+	int unused;
+};
+
+struct device {
+	struct device *parent;
+	void *driver_data;
+	struct kobject kobj;
+};
+
+enum probe_type {
+	PROBE_DEFAULT_STRATEGY,
+	PROBE_PREFER_ASYNCHRONOUS,
+	PROBE_FORCE_SYNCHRONOUS,
+};
+
+struct device_driver {
+	enum probe_type probe_type;
+};
+
+struct attribute {
+	const char *name;
+	umode_t mode;
+};
+
+struct device_attribute {
+	struct attribute attr;
+	ssize_t (*show)(struct device *dev, struct device_attribute *attr,
+			char *buf);
+	ssize_t (*store)(struct device *dev, struct device_attribute *attr,
+			 const char *buf, size_t count);
+};
+
+struct attribute_group {
+	const char *name;
+	umode_t (*is_visible)(struct kobject *kobj, struct attribute *attr,
+			      int n);
+	struct attribute **attrs;
+};
+
+#define __ATTR(_name, _mode, _show, _store) { \
+	.attr = { .name = __stringify(_name), .mode = (_mode) }, \
+	.show = (_show), \
+	.store = (_store), \
+}
+#define DEVICE_ATTR_RO(_name) \
+	struct device_attribute dev_attr_##_name = \
+		__ATTR(_name, 0444, _name##_show, NULL)
+#define DEVICE_ATTR_RW(_name) \
+	struct device_attribute dev_attr_##_name = \
+		__ATTR(_name, 0644, _name##_show, _name##_store)
+#define kobj_to_dev(kobj)	container_of(kobj, struct device, kobj)
+
+static inline void *dev_get_drvdata(const struct device *dev)
+{
+	return dev->driver_data;
+}
+
+static inline void *devm_kzalloc(struct device *dev, size_t size,
+				 gfp_t flags)
+{
+	return kzalloc(size, flags);
+}
+
+#define devm_kasprintf(dev, gfp, ...) \
+	({ \
+		char *__str; \
+		if (asprintf(&__str, __VA_ARGS__) < 0) \
+			__str = NULL; \
+		__str; \
+	})
+
+static inline int sysfs_create_group(struct kobject *kobj,
+				     const struct attribute_group *grp)
+{
+	return 0;
+}
+
+static inline void sysfs_remove_group(struct kobject *kobj,
+				      const struct attribute_group *grp)
+{
+}
+
+struct dentry {
+	int unused;
+};
+
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct seq_file {
+	void *private;
+};
+
+struct file_operations {
+	void *owner;
+	int (*open)(struct inode *inode, struct file *file);
+	ssize_t (*read)(struct file *file, char __user *buf, size_t count,
+			loff_t *ppos);
+	loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+	int (*release)(struct inode *inode, struct file *file);
+};
+
+#define THIS_MODULE	NULL
+
+static inline int seq_printf(struct seq_file *m, const char *fmt, ...)
+{
+	return 0;
+}
+
+static inline int single_open(struct file *file,
+			      int (*show)(struct seq_file *, void *),
+			      void *data)
+{
+	return 0;
+}
+
+static inline int single_release(struct inode *inode, struct file *file)
+{
+	return 0;
+}
+
+static inline int simple_open(struct inode *inode, struct file *file)
+{
+	file->private_data = inode->i_private;
+	return 0;
+}
+
+static inline int stream_open(struct inode *inode, struct file *file)
+{
+	return 0;
+}
+
+static inline ssize_t seq_read(struct file *file, char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	return 0;
+}
+
+static inline loff_t seq_lseek(struct file *file, loff_t offset, int whence)
+{
+	return 0;
+}
+
+static inline loff_t noop_llseek(struct file *file, loff_t offset,
+				 int whence)
+{
+	return 0;
+}
+
+#define DEFINE_SHOW_ATTRIBUTE(__name) \
+static int __name ## _open(struct inode *inode, struct file *file) \
+{ \
+	return single_open(file, __name ## _show, inode->i_private); \
+} \
+static const struct file_operations __name ## _fops = { \
+	.owner = THIS_MODULE, \
+	.open = __name ## _open, \
+	.read = seq_read, \
+	.llseek = seq_lseek, \
+	.release = single_release, \
+}
+
+#define DEFINE_SIMPLE_ATTRIBUTE(__fops, __get, __set, __fmt) \
+static const struct file_operations __fops = { \
+	.owner = THIS_MODULE, \
+	.open = simple_open, \
+	.llseek = noop_llseek, \
+}; \
+static int (*const __fops ## _get)(void *, u64 *) __maybe_unused = __get; \
+static int (*const __fops ## _set)(void *, u64) __maybe_unused = __set
+
+static inline struct dentry *debugfs_create_file(
+				const char *name, umode_t mode,
+				struct dentry *parent, void *data,
+				const struct file_operations *fops)
+{
+	return NULL;
+}
+
+static inline void debugfs_remove(struct dentry *dentry)
+{
+}
+
+static inline unsigned long copy_to_user(void __user *to, const void *from,
+					 unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+/*
+ * Modules
+ */
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define MODULE_VERSION(x)
+#define MODULE_DEVICE_TABLE(type, name)
+#define MODULE_PARM_DESC(name, desc)
+#define module_param_named(name, var, type, perm)
+#define module_param_cb(name, ops, arg, perm)
+
+struct kernel_param;
+
+struct kernel_param_ops {
+	int (*set)(const char *val, const struct kernel_param *kp);
+	int (*get)(char *buffer, const struct kernel_param *kp);
+};
+
+/*
+ * Tracepoints, always disabled
+ */
+#define TP_PROTO(...)		__VA_ARGS__
+#define TP_ARGS(...)		__VA_ARGS__
+#define TRACE_DEFINE_ENUM(x)
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+	static inline bool trace_##name##_enabled(void) \
+	{ \
+		return false; \
+	} \
+	static inline void trace_##name(proto) \
+	{ \
+	}
+#define DECLARE_EVENT_CLASS(name, proto, args, tstruct, assign, print)
+#define DEFINE_EVENT(template, name, proto, args) \
+	TRACE_EVENT(name, PARAMS(proto), PARAMS(args), , , )
+#define PARAMS(...)		__VA_ARGS__
+
+/*
+ * Input devices
+ */
+#define EV_SYN		0x00
+#define EV_KEY		0x01
+#define EV_ABS		0x03
+#define EV_MSC		0x04
+#define SYN_REPORT	0
+#define MSC_SCAN	0x04
+#define ABS_PRESSURE	0x18
+#define BTN_TOOL_PEN	0x140
+#define BTN_TOUCH	0x14a
+#define EV_CNT		0x20
+#define KEY_CNT		0x300
+
+struct input_dev {
+	const char *name;
+	unsigned long evbit[BITS_TO_LONGS(EV_CNT)];
+	unsigned long key[BITS_TO_LONGS(KEY_CNT)];
+};
+
+/* Only keep the state of the keys */
+static inline void input_event(struct input_dev *dev, unsigned int type,
+			       unsigned int code, int value)
+{
+	if (type != EV_KEY)
+		return;
+	if (value)
+		__set_bit(code, dev->key);
+	else
+		__clear_bit(code, dev->key);
+}
+
+static inline void input_report_key(struct input_dev *dev, unsigned int code,
+				    int value)
+{
+	input_event(dev, EV_KEY, code, !!value);
+}
+
+static inline void input_report_abs(struct input_dev *dev, unsigned int code,
+				    int value)
+{
+	input_event(dev, EV_ABS, code, value);
+}
+
+static inline void input_sync(struct input_dev *dev)
+{
+	input_event(dev, EV_SYN, SYN_REPORT, 0);
+}
+
+/*
+ * USB, without devices
+ */
+#define USB_CTRL_GET_TIMEOUT	5000
+#define USB_CTRL_SET_TIMEOUT	5000
+#define USB_REQ_GET_DESCRIPTOR	0x06
+#define USB_DIR_IN		0x80
+#define USB_DT_STRING		0x03
+
+struct usb_interface_descriptor {
+	u8 bInterfaceNumber;
+};
+
+struct usb_host_interface {
+	struct usb_interface_descriptor desc;
+};
+
+struct usb_interface {
+	struct usb_host_interface *cur_altsetting;
+	struct device dev;
+};
+
+struct usb_config_descriptor {
+	u8 bNumInterfaces;
+};
+
+struct usb_host_config {
+	struct usb_config_descriptor desc;
+};
+
+struct usb_device {
+	struct usb_host_config *config;
+	char *product;
+	struct device dev;
+};
+
+struct usb_device_id {
+	int unused;
+};
+
+#define to_usb_interface(d)	container_of(d, struct usb_interface, dev)
+
+static inline unsigned int usb_rcvctrlpipe(struct usb_device *dev,
+					   unsigned int endpoint)
+{
+	return USB_DIR_IN | endpoint;
+}
+
+static inline unsigned int usb_sndintpipe(struct usb_device *dev,
+					  unsigned int endpoint)
+{
+	return endpoint;
+}
+
+static inline int usb_control_msg(struct usb_device *dev, unsigned int pipe,
+				  u8 request, u8 requesttype, u16 value,
+				  u16 index, void *data, u16 size, int timeout)
+{
+	return -ENODEV;
+}
+
+static inline int usb_interrupt_msg(struct usb_device *dev,
+				    unsigned int pipe, void *data, int len,
+				    int *actual_length, int timeout)
+{
+	return -ENODEV;
+}
+
+static inline int usb_string(struct usb_device *dev, int index, char *buf,
+			     size_t size)
+{
+	return -ENODEV;
+}
+
+/*
+ * HID, without devices
+ */
+#define HID_INPUT_REPORT	0
+#define HID_OUTPUT_REPORT	1
+#define HID_FEATURE_REPORT	2
+#define HID_REPORT_TYPES	3
+#define HID_REQ_GET_REPORT	0x01
+#define HID_REQ_SET_REPORT	0x09
+#define HID_QUIRK_MULTI_INPUT		BIT(6)
+#define HID_QUIRK_HIDINPUT_FORCE	BIT(7)
+#define HID_QUIRK_NO_EMPTY_INPUT	BIT(8)
+#define HID_CONNECT_DEFAULT	0x3f
+#define HID_DG_DIGITIZER	0x000d0001
+#define HID_DG_PEN		0x000d0002
+#define HID_GD_KEYBOARD		0x00010006
+#define HID_GD_MOUSE		0x00010002
+#define HID_GD_KEYPAD		0x00010007
+#define HID_GD_SYSTEM_CONTROL	0x00010080
+#define HID_CP_CONSUMER_CONTROL	0x000c0001
+#define HID_UP_MSVENDOR		0xff000000
+#define BUS_USB			0x03
+
+struct hid_field {
+	unsigned int application;
+};
+
+struct hid_report {
+	unsigned int id;
+	int type;
+	struct hid_field *field[256];
+	unsigned int maxfield;
+};
+
+struct hid_input {
+	struct hid_report *report;
+	struct input_dev *input;
+	const char *name;
+};
+
+struct hid_usage {
+	unsigned int hid;
+};
+
+struct hid_device;
+
+struct hid_ll_driver {
+	int (*raw_request)(struct hid_device *hdev, unsigned char reportnum,
+			   u8 *buf, size_t len, unsigned char rtype,
+			   int reqtype);
+};
+
+struct hid_device {
+	struct device dev;
+	u16 bus;
+	u32 vendor;
+	u32 product;
+	u32 version;
+	unsigned int id;
+	char name[128];
+	char uniq[64];
+	u8 *dev_rdesc;
+	unsigned int dev_rsize;
+	unsigned long quirks;
+	struct semaphore driver_input_lock;
+	struct hid_ll_driver *ll_driver;
+	struct dentry *debug_dir;
+};
+
+struct hid_device_id {
+	u16 bus;
+	u16 group;
+	u32 vendor;
+	u32 product;
+	unsigned long driver_data;
+};
+
+struct hid_driver {
+	const char *name;
+	const struct hid_device_id *id_table;
+	int (*probe)(struct hid_device *hdev,
+		     const struct hid_device_id *id);
+	void (*remove)(struct hid_device *hdev);
+	const u8 *(*report_fixup)(struct hid_device *hdev, u8 *buf,
+				  unsigned int *size);
+	int (*raw_event)(struct hid_device *hdev, struct hid_report *report,
+			 u8 *data, int size);
+	void (*report)(struct hid_device *hdev, struct hid_report *report);
+	int (*input_mapping)(struct hid_device *hdev,
+			     struct hid_input *hidinput,
+			     struct hid_field *field, struct hid_usage *usage,
+			     unsigned long **bit, int *max);
+	int (*input_configured)(struct hid_device *hdev,
+				struct hid_input *hidinput);
+	int (*resume)(struct hid_device *hdev);
+	int (*reset_resume)(struct hid_device *hdev);
+	struct device_driver driver;
+};
+
+#define HID_USB_DEVICE(ven, prod) \
+	.bus = BUS_USB, .vendor = (ven), .product = (prod)
+#define module_hid_driver(__hid_driver) \
+	const struct hid_driver *um_hid_driver = &(__hid_driver)
+
+extern struct hid_ll_driver usb_hid_driver;
+
+static inline void *hid_get_drvdata(struct hid_device *hdev)
+{
+	return hdev->dev.driver_data;
+}
+
+static inline void hid_set_drvdata(struct hid_device *hdev, void *data)
+{
+	hdev->dev.driver_data = data;
+}
+
+static inline bool hid_is_usb(const struct hid_device *hdev)
+{
+	return false;
+}
+
+static inline bool hid_is_using_ll_driver(struct hid_device *hdev,
+					  struct hid_ll_driver *driver)
+{
+	return hdev->ll_driver == driver;
+}
+
+static inline struct usb_device *hid_to_usb_dev(struct hid_device *hdev)
+{
+	return NULL;
+}
+
+static inline int hid_hw_raw_request(struct hid_device *hdev,
+				     unsigned char reportnum, u8 *buf,
+				     size_t len, unsigned char rtype,
+				     int reqtype)
+{
+	if (hdev->ll_driver == NULL || hdev->ll_driver->raw_request == NULL)
+		return -ENODEV;
+	return hdev->ll_driver->raw_request(hdev, reportnum, buf, len, rtype,
+					    reqtype);
+}
+
+static inline int hid_parse(struct hid_device *hdev)
+{
+	return -ENODEV;
+}
+
+static inline int hid_hw_start(struct hid_device *hdev,
+			       unsigned int connect_mask)
+{
+	return -ENODEV;
+}
+
+static inline void hid_hw_stop(struct hid_device *hdev)
+{
+}
+
+#define hid_printk(hdev, fmt, ...) \
+	fprintf(stderr, "hid-uclogic: " fmt, ##__VA_ARGS__)
+#define hid_err(hdev, fmt, ...)		hid_printk(hdev, fmt, ##__VA_ARGS__)
+#define hid_warn(hdev, fmt, ...)	hid_printk(hdev, fmt, ##__VA_ARGS__)
+#define hid_noprintk(hdev, fmt, ...) \
+	do { \
+		if (0) \
+			hid_printk(hdev, fmt, ##__VA_ARGS__); \
+	} while (0)
+#define hid_info(hdev, fmt, ...)	hid_noprintk(hdev, fmt, ##__VA_ARGS__)
+#define hid_dbg(hdev, fmt, ...)		hid_noprintk(hdev, fmt, ##__VA_ARGS__)
+
+#endif /* _UCLOGIC_KERNEL_SHIM_H */
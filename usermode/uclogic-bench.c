@@ -0,0 +1,382 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - userspace benchmark
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+/*
+ * Check the report handling against the replay corpus, and then time it,
+ * along with the report descriptor generation. Prints one line of
+ * space-separated key=value pairs per measurement, the report handling ones
+ * matching the hid_uclogic_bench KUnit suite's.
+ *
+ * Usage: uclogic-bench [-s] [REPORTS [FILTER]]
+ *
+ * REPORTS is the number of reports to time for each shape, and the
+ * descriptor operations are repeated a sixteenth of that. FILTER limits the
+ * measurements to those with names containing it. The report handling is
+ * timed without the statistics, as configured by default, unless -s is
+ * given.
+ */
+
+#include <unistd.h>
+#include "kernel_shim.h"
+#include "uclogic.h"
+#include "hid-uclogic-core-test-corpus.h"
+
+/* Default number of reports to time for each shape */
+#define UCLOGIC_BENCH_REPORTS	(1 << 22)
+
+/* Measurements name filter, NULL if none */
+static const char *uclogic_bench_filter;
+
+/* True if the report handling statistics should be collected */
+static bool uclogic_bench_stats;
+
+static void uclogic_bench_hook_work(struct work_struct *work)
+{
+}
+
+static bool uclogic_bench_selected(const char *name)
+{
+	return uclogic_bench_filter == NULL ||
+		strstr(name, uclogic_bench_filter) != NULL;
+}
+
+/*
+ * Print a measurement, with "attrs" being either empty, or space-separated
+ * key=value pairs describing the configuration, followed by a space.
+ */
+static void uclogic_bench_print(const char *key, const char *name,
+				const char *attrs, const char *unit,
+				u64 num, u64 ns, u64 cycles)
+{
+	printf("uclogic_bench %s=%s %s%ss=%llu ns=%llu "
+	       "ns_per_%s=%llu.%03llu cycles_per_%s=%llu\n",
+	       key, name, attrs, unit, (unsigned long long)num,
+	       (unsigned long long)ns, unit,
+	       (unsigned long long)(ns / num),
+	       (unsigned long long)(ns % num * 1000 / num),
+	       unit, (unsigned long long)(cycles / num));
+}
+
+/*
+ * Allocate driver data with parameters and raw report handling data,
+ * attached to a HID device, and the statistics, if collected.
+ */
+static struct uclogic_drvdata *uclogic_bench_drvdata_alloc(
+				const struct uclogic_bench_shape *shape,
+				void (*init)(struct uclogic_params *params))
+{
+	struct uclogic_drvdata *drvdata;
+	int rc = 0;
+
+	drvdata = kzalloc(sizeof(*drvdata), GFP_KERNEL);
+	if (drvdata == NULL)
+		return NULL;
+	drvdata->hdev = kzalloc(sizeof(*drvdata->hdev), GFP_KERNEL);
+	if (drvdata->hdev == NULL)
+		goto failure;
+	sema_init(&drvdata->hdev->driver_input_lock, 1);
+	hid_set_drvdata(drvdata->hdev, drvdata);
+
+	if (shape != NULL)
+		rc = uclogic_bench_shape_init(shape, &drvdata->params,
+					      uclogic_bench_hook_work);
+	else
+		init(&drvdata->params);
+	if (rc == 0)
+		rc = uclogic_params_get_raw(&drvdata->params, &drvdata->raw);
+	if (rc != 0)
+		goto failure;
+	if (uclogic_bench_stats) {
+		drvdata->stats_active = alloc_percpu(struct uclogic_stats);
+		if (drvdata->stats_active == NULL)
+			goto failure;
+	}
+	return drvdata;
+
+failure:
+	uclogic_params_cleanup(&drvdata->params);
+	kfree(drvdata->hdev);
+	kfree(drvdata);
+	return NULL;
+}
+
+static void uclogic_bench_drvdata_free(struct uclogic_drvdata *drvdata)
+{
+	free_percpu(drvdata->stats_active);
+	uclogic_params_cleanup(&drvdata->params);
+	kfree(drvdata->hdev);
+	kfree(drvdata);
+}
+
+/*
+ * Replay a model's sequence, checking the rewritten reports. The pen
+ * in-range state is checked by the KUnit replay test only, as it needs
+ * input devices.
+ *
+ * Returns the number of mismatching reports, or -ENOMEM.
+ */
+static int uclogic_bench_replay(const struct uclogic_replay_model *model)
+{
+	const struct uclogic_replay_step *step;
+	struct uclogic_drvdata *drvdata;
+	struct hid_report report = { .type = HID_INPUT_REPORT };
+	__u8 data[UCLOGIC_REPLAY_REPORT_MAX];
+	int mismatches = 0;
+	size_t n;
+
+	drvdata = uclogic_bench_drvdata_alloc(NULL, model->init);
+	if (drvdata == NULL)
+		return -ENOMEM;
+
+	for (n = 0; n < model->num_steps; n++) {
+		step = &model->steps[n];
+		if (step->size == 0) {
+			uclogic_um_inrange_timer_fire(drvdata);
+			continue;
+		}
+		memcpy(data, step->report, step->size);
+		report.id = data[0];
+		uclogic_um_raw_event(drvdata->hdev, &report, data, step->size);
+		if (memcmp(data, step->expected, step->size) != 0) {
+			fprintf(stderr, "%s: step %zu mismatch\n",
+				model->name, n);
+			mismatches++;
+		}
+	}
+
+	uclogic_bench_drvdata_free(drvdata);
+	return mismatches;
+}
+
+/* Time the report handling for a shape */
+static int uclogic_bench_raw_event(const struct uclogic_bench_shape *shape,
+				   u64 num)
+{
+	struct uclogic_drvdata *drvdata;
+	struct hid_report report = { .type = HID_INPUT_REPORT };
+	__u8 data[UCLOGIC_REPLAY_REPORT_MAX];
+	u64 start_ns, ns;
+	cycles_t start_cycles, cycles;
+	u64 n;
+
+	drvdata = uclogic_bench_drvdata_alloc(shape, NULL);
+	if (drvdata == NULL)
+		return -ENOMEM;
+	report.id = shape->report[0];
+
+	start_ns = ktime_get_ns();
+	start_cycles = get_cycles();
+	for (n = 0; n < num; n++) {
+		memcpy(data, shape->report, shape->size);
+		uclogic_um_raw_event(drvdata->hdev, &report, data,
+				     shape->size);
+	}
+	cycles = get_cycles() - start_cycles;
+	ns = ktime_get_ns() - start_ns;
+
+	uclogic_bench_print("shape", shape->name,
+			    drvdata->stats_active ? "stats=1 " : "stats=0 ",
+			    "report", num, ns, cycles);
+	uclogic_bench_drvdata_free(drvdata);
+	return 0;
+}
+
+/* Time filling in a Huion v2 pen report descriptor template */
+static int uclogic_bench_template_apply(u64 num)
+{
+	static const s32 desc_params[UCLOGIC_RDESC_PH_ID_NUM] = {
+		[UCLOGIC_RDESC_PEN_PH_ID_X_LM] = 50800,
+		[UCLOGIC_RDESC_PEN_PH_ID_X_PM] = 254000,
+		[UCLOGIC_RDESC_PEN_PH_ID_Y_LM] = 31750,
+		[UCLOGIC_RDESC_PEN_PH_ID_Y_PM] = 158750,
+		[UCLOGIC_RDESC_PEN_PH_ID_PRESSURE_LM] = 8191,
+	};
+	u64 start_ns, ns;
+	cycles_t start_cycles, cycles;
+	__u8 *desc;
+	u64 n;
+
+	start_ns = ktime_get_ns();
+	start_cycles = get_cycles();
+	for (n = 0; n < num; n++) {
+		desc = uclogic_rdesc_template_apply(
+				uclogic_rdesc_v2_pen_template_arr,
+				uclogic_rdesc_v2_pen_template_size,
+				desc_params, ARRAY_SIZE(desc_params));
+		if (desc == NULL)
+			return -ENOMEM;
+		kfree(desc);
+	}
+	cycles = get_cycles() - start_cycles;
+	ns = ktime_get_ns() - start_ns;
+
+	uclogic_bench_print("op", "template_apply", "", "call", num, ns,
+			    cycles);
+	return 0;
+}
+
+/* Time assembling the report descriptor of a Huion v2 touch ring tablet */
+static int uclogic_bench_get_desc(u64 num)
+{
+	static const struct {
+		const __u8 *ptr;
+		const size_t *size;
+	} frame_descs[] = {
+		{ uclogic_rdesc_v2_frame_buttons_arr,
+		  &uclogic_rdesc_v2_frame_buttons_size },
+		{ uclogic_rdesc_v2_frame_touch_ring_arr,
+		  &uclogic_rdesc_v2_frame_touch_ring_size },
+		{ uclogic_rdesc_v2_frame_dial_arr,
+		  &uclogic_rdesc_v2_frame_dial_size },
+		{ uclogic_rdesc_v2_frame_gbuttons_arr,
+		  &uclogic_rdesc_v2_frame_gbuttons_size },
+	};
+	struct uclogic_params params = {};
+	u64 start_ns, ns;
+	cycles_t start_cycles, cycles;
+	unsigned int size;
+	__u8 *desc;
+	int rc = -ENOMEM;
+	size_t i;
+	u64 n;
+
+	uclogic_replay_init_huion_v2_touch_ring(&params);
+	params.pen.desc_ptr = kmemdup(uclogic_rdesc_v2_pen_template_arr,
+				      uclogic_rdesc_v2_pen_template_size,
+				      GFP_KERNEL);
+	if (params.pen.desc_ptr == NULL)
+		goto cleanup;
+	params.pen.desc_size = uclogic_rdesc_v2_pen_template_size;
+	for (i = 0; i < ARRAY_SIZE(frame_descs); i++) {
+		params.frame_list[i].desc_ptr = kmemdup(frame_descs[i].ptr,
+							*frame_descs[i].size,
+							GFP_KERNEL);
+		if (params.frame_list[i].desc_ptr == NULL)
+			goto cleanup;
+		params.frame_list[i].desc_size = *frame_descs[i].size;
+	}
+
+	start_ns = ktime_get_ns();
+	start_cycles = get_cycles();
+	for (n = 0; n < num; n++) {
+		rc = uclogic_params_get_desc(&params, &desc, &size);
+		if (rc != 0)
+			goto cleanup;
+		kfree(desc);
+	}
+	cycles = get_cycles() - start_cycles;
+	ns = ktime_get_ns() - start_ns;
+
+	uclogic_bench_print("op", "get_desc", "", "call", num, ns, cycles);
+	rc = 0;
+cleanup:
+	uclogic_params_cleanup(&params);
+	return rc;
+}
+
+/* Time parsing a UGEE v2 string descriptor */
+static int uclogic_bench_parse_ugee_v2_desc(u64 num)
+{
+	static const __u8 str_desc[] = {
+		0x0e, 0x03, 0x70, 0xb2, 0x10, 0x77, 0x08, 0x00,
+		0xff, 0x1f, 0xd8, 0x13, 0x00, 0x00,
+	};
+	s32 desc_params[UCLOGIC_RDESC_PH_ID_NUM];
+	enum uclogic_params_frame_type frame_type;
+	u64 start_ns, ns;
+	cycles_t start_cycles, cycles;
+	int rc;
+	u64 n;
+
+	start_ns = ktime_get_ns();
+	start_cycles = get_cycles();
+	for (n = 0; n < num; n++) {
+		rc = uclogic_um_parse_ugee_v2_desc(
+				str_desc, sizeof(str_desc), desc_params,
+				ARRAY_SIZE(desc_params), &frame_type);
+		if (rc != 0)
+			return rc;
+	}
+	cycles = get_cycles() - start_cycles;
+	ns = ktime_get_ns() - start_ns;
+
+	uclogic_bench_print("op", "parse_ugee_v2_desc", "", "call", num,
+			    ns, cycles);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	u64 num = UCLOGIC_BENCH_REPORTS;
+	int mismatches = 0;
+	size_t i;
+	int rc;
+
+	while ((rc = getopt(argc, argv, "s")) != -1) {
+		if (rc != 's')
+			goto usage;
+		uclogic_bench_stats = true;
+	}
+	if (optind < argc) {
+		num = strtoull(argv[optind], NULL, 0);
+		if (num < 16)
+			goto usage;
+	}
+	if (optind + 1 < argc)
+		uclogic_bench_filter = argv[optind + 1];
+
+	for (i = 0; i < ARRAY_SIZE(uclogic_replay_models); i++) {
+		rc = uclogic_bench_replay(&uclogic_replay_models[i]);
+		if (rc < 0)
+			goto failure;
+		mismatches += rc;
+	}
+	if (mismatches != 0) {
+		fprintf(stderr, "%d reports don't match the corpus\n",
+			mismatches);
+		return 1;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(uclogic_bench_shapes); i++) {
+		if (!uclogic_bench_selected(uclogic_bench_shapes[i].name))
+			continue;
+		rc = uclogic_bench_raw_event(&uclogic_bench_shapes[i], num);
+		if (rc != 0)
+			goto failure;
+	}
+	if (uclogic_bench_selected("template_apply")) {
+		rc = uclogic_bench_template_apply(num / 16);
+		if (rc != 0)
+			goto failure;
+	}
+	if (uclogic_bench_selected("get_desc")) {
+		rc = uclogic_bench_get_desc(num / 16);
+		if (rc != 0)
+			goto failure;
+	}
+	if (uclogic_bench_selected("parse_ugee_v2_desc")) {
+		rc = uclogic_bench_parse_ugee_v2_desc(num / 16);
+		if (rc != 0)
+			goto failure;
+	}
+	return 0;
+
+failure:
+	fprintf(stderr, "Benchmark failed: %s\n", strerror(-rc));
+	return 1;
+
+usage:
+	fprintf(stderr, "Usage: %s [-s] [REPORTS [FILTER]], REPORTS >= 16\n",
+		argv[0]);
+	return 2;
+}
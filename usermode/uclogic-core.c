@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - userspace build of the core
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+#include "../hid-uclogic-core.c"
+#include "uclogic.h"
+
+int uclogic_um_raw_event(struct hid_device *hdev, struct hid_report *report,
+			 u8 *data, int size)
+{
+	int rc = uclogic_raw_event(hdev, report, data, size);
+
+	/* HID core reports the fields, and then calls the driver back */
+	if (rc >= 0)
+		uclogic_report(hdev, report);
+	return rc;
+}
+
+void uclogic_um_inrange_timer_fire(struct uclogic_drvdata *drvdata)
+{
+	if (drvdata->inrange_timer.function == NULL)
+		timer_setup(&drvdata->inrange_timer, uclogic_inrange_timeout,
+			    0);
+	um_timer_fire(&drvdata->inrange_timer);
+}
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - userspace build of the interface parameters
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+#include "../hid-uclogic-params.c"
+#include "uclogic.h"
+
+int uclogic_um_parse_ugee_v2_desc(const __u8 *str_desc, size_t str_desc_size,
+				  s32 *desc_params, size_t desc_params_size,
+				  enum uclogic_params_frame_type *frame_type)
+{
+	return uclogic_params_parse_ugee_v2_desc(str_desc, str_desc_size,
+						 desc_params,
+						 desc_params_size,
+						 frame_type);
+}
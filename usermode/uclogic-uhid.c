@@ -0,0 +1,886 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - virtual tablet
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+/*
+ * Create virtual tablets with uhid, answer the driver's handshake with the
+ * parameters of a real one, and draw strokes with their pens, to run the
+ * whole driver without hardware. Needs hid-uclogic loaded with "virtual=1",
+ * write access to /dev/uhid, and read access to /dev/input.
+ *
+ * Usage: uclogic-uhid [-m MODEL] [-c TABLETS] [-s] [-n REPORTS] [-r RATE]
+ *                     [-e EVERY]
+ *
+ * MODEL is "huion" for a Huion v2 tablet with a touch ring (default),
+ * "ugee" for an XP-PEN Deco L, or "ugee-lw" for a wireless XP-PEN Deco LW.
+ * TABLETS is the number of tablets drawing at the same time, one by
+ * default. With "-s", the strokes are drawn with 1, 2, 4 and so on, up to
+ * TABLETS tablets, to see how the costs grow with their number. REPORTS is
+ * the number of pen reports each tablet sends, 10000 by default. RATE is
+ * the number of reports each tablet sends per second, 200 by default, like
+ * most of these tablets, or zero to send them as fast as possible. With
+ * EVERY, a Deco LW sends its reconnection event, handled by the driver in
+ * a work, in place of every EVERY-th pen report.
+ *
+ * Each run prints a line like:
+ *
+ *   uclogic_uhid model=huion tablets=8 reports=80000 ns=50001234
+ *                reports_per_s=1599 handshake_requests=24
+ *                write_ns_per_report=5210 cpu_ns_per_report=61234 lost=0
+ *                p50_us=5 p99_us=9 p999_us=23 max_us=57
+ *                timer_runs_per_s=200 hook_works_per_s=0
+ *
+ * The write time is spent in the uhid writes, which take the reports all
+ * the way to the input events. The CPU time is the time all CPUs were
+ * busy, divided by the reports, and includes this program, the in-range
+ * timers, the works, and anything else running. The latencies are from
+ * the writes to the evdev events, taken from the event timestamps, with
+ * microsecond resolution. The in-range timer runs and the event hook works
+ * are summed from the tablets' uclogic_stats debugfs files, enabled through
+ * uclogic_stats_enable, and are "-" if those can't be read.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uhid.h>
+
+/* Virtual tablet handshake, as in hid-uclogic-params.h */
+#define UCLOGIC_VIRTUAL_REPORT_ID	0xfd
+#define UCLOGIC_VIRTUAL_REPORT_SIZE	64
+#define UCLOGIC_VIRTUAL_DATA_MAX	(UCLOGIC_VIRTUAL_REPORT_SIZE - 4)
+#define UCLOGIC_VIRTUAL_REQ_IFACE	1
+#define UCLOGIC_VIRTUAL_REQ_STR_DESC	2
+#define UCLOGIC_VIRTUAL_REQ_STRING	3
+#define UCLOGIC_VIRTUAL_REQ_INTERRUPT	4
+#define UCLOGIC_VIRTUAL_REQ_PRODUCT	5
+
+/* Maximum number of tablets, each taking two file descriptors */
+#define UHID_TABLETS_MAX	256
+/* Maximum number of pen reports of a tablet waiting for their events */
+#define UHID_PENDING		64
+/* Time to wait for the driver to bind to one more tablet, ms */
+#define UHID_BIND_TIMEOUT_MS	5000
+
+#define ARRAY_SIZE(_a)	(sizeof(_a) / sizeof((_a)[0]))
+
+/* An answer to a handshake request */
+struct uhid_answer {
+	uint8_t req;
+	uint8_t idx;
+	const void *data;
+	size_t size;
+};
+
+#define UHID_ANSWER(_req, _idx, _arr) \
+	{ .req = _req, .idx = _idx, .data = _arr, .size = sizeof(_arr) }
+
+/* A model of a tablet interface */
+struct uhid_model {
+	const char *name;
+	uint16_t vendor;
+	uint16_t product;
+	const uint8_t *rdesc;
+	size_t rdesc_size;
+	const struct uhid_answer *answers;
+	size_t num_answers;
+	/* Fill in a pen report for a point of a stroke */
+	void (*pen)(uint8_t *report, unsigned int x, unsigned int y,
+		    unsigned int pressure);
+	size_t pen_size;
+	/* Report hooked by the driver, NULL if none */
+	const uint8_t *hook;
+	size_t hook_size;
+};
+
+/*
+ * Original report descriptor of a pen interface: a vendor-defined pen
+ * report, replaced by the driver, and the handshake feature report.
+ */
+#define UHID_RDESC(_pen_id, _pen_size) {				\
+	0x06, 0x00, 0xff,	/* Usage Page (FF00h),		*/	\
+	0x09, 0x01,		/* Usage (01h),			*/	\
+	0xa1, 0x01,		/* Collection (Application),	*/	\
+	0x85, _pen_id,		/*     Report ID (pen),		*/	\
+	0x75, 0x08,		/*     Report Size (8),		*/	\
+	0x95, (_pen_size) - 1,	/*     Report Count (pen),	*/	\
+	0x15, 0x00,		/*     Logical Minimum (0),	*/	\
+	0x26, 0xff, 0x00,	/*     Logical Maximum (255),	*/	\
+	0x09, 0x01,		/*     Usage (01h),		*/	\
+	0x81, 0x02,		/*     Input (Variable),	*/	\
+	0x85, UCLOGIC_VIRTUAL_REPORT_ID,				\
+				/*     Report ID (handshake),	*/	\
+	0x95, UCLOGIC_VIRTUAL_REPORT_SIZE - 1,				\
+				/*     Report Count (handshake),*/	\
+	0x09, 0x02,		/*     Usage (02h),		*/	\
+	0xb1, 0x02,		/*     Feature (Variable),	*/	\
+	0xc0			/* End Collection		*/	\
+}
+
+static const uint8_t huion_rdesc[] = UHID_RDESC(0x08, 12);
+static const uint8_t huion_iface[] = { 0, 3 };
+static const char huion_fw[] = "HUION_T21j_221221";
+/* Pen v2 parameters of the Huion HS610, with a touch ring */
+static const uint8_t huion_params[] = {
+	0x13, 0x03, 0x70, 0xc6, 0x00, 0x06, 0x7c, 0x00,
+	0xff, 0x1f, 0xd8, 0x13, 0x03, 0x0d, 0x10, 0x01,
+	0x04, 0x3c, 0x3e,
+};
+
+static const struct uhid_answer huion_answers[] = {
+	UHID_ANSWER(UCLOGIC_VIRTUAL_REQ_IFACE, 0, huion_iface),
+	{ .req = UCLOGIC_VIRTUAL_REQ_STRING, .idx = 201,
+	  .data = huion_fw, .size = sizeof(huion_fw) - 1 },
+	UHID_ANSWER(UCLOGIC_VIRTUAL_REQ_STR_DESC, 200, huion_params),
+};
+
+static void huion_pen(uint8_t *report, unsigned int x, unsigned int y,
+		      unsigned int pressure)
+{
+	report[0] = 0x08;
+	report[1] = 0x80 | (pressure != 0);
+	report[2] = x;
+	report[3] = x >> 8;
+	report[4] = y;
+	report[5] = y >> 8;
+	report[6] = pressure;
+	report[7] = pressure >> 8;
+	report[8] = x >> 16;
+	report[9] = y >> 16;
+	report[10] = 0;
+	report[11] = 0;
+}
+
+static const uint8_t ugee_rdesc[] = UHID_RDESC(0x02, 12);
+static const uint8_t ugee_iface[] = { 2, 3 };
+static const char ugee_product[] = "Deco L";
+static const char ugee_lw_product[] = "Deco LW";
+/* UGEE v2 parameters of the XP-PEN Deco L, with frame buttons */
+static const uint8_t ugee_params[] = {
+	0x0e, 0x03, 0x70, 0xb2, 0x10, 0x77, 0x08, 0x00,
+	0xff, 0x1f, 0xd8, 0x13,
+};
+/* Report sent by a wireless tablet reconnecting to its dongle */
+static const uint8_t ugee_lw_reconnect[] = {
+	0x02, 0xf8, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+};
+
+static const struct uhid_answer ugee_answers[] = {
+	UHID_ANSWER(UCLOGIC_VIRTUAL_REQ_IFACE, 0, ugee_iface),
+	{ .req = UCLOGIC_VIRTUAL_REQ_INTERRUPT, .idx = 0x03 },
+	UHID_ANSWER(UCLOGIC_VIRTUAL_REQ_STR_DESC, 100, ugee_params),
+	{ .req = UCLOGIC_VIRTUAL_REQ_PRODUCT, .idx = 0,
+	  .data = ugee_product, .size = sizeof(ugee_product) - 1 },
+};
+
+static const struct uhid_answer ugee_lw_answers[] = {
+	UHID_ANSWER(UCLOGIC_VIRTUAL_REQ_IFACE, 0, ugee_iface),
+	{ .req = UCLOGIC_VIRTUAL_REQ_INTERRUPT, .idx = 0x03 },
+	UHID_ANSWER(UCLOGIC_VIRTUAL_REQ_STR_DESC, 100, ugee_params),
+	{ .req = UCLOGIC_VIRTUAL_REQ_PRODUCT, .idx = 0,
+	  .data = ugee_lw_product, .size = sizeof(ugee_lw_product) - 1 },
+};
+
+static void ugee_pen(uint8_t *report, unsigned int x, unsigned int y,
+		     unsigned int pressure)
+{
+	memset(report, 0, 12);
+	report[0] = 0x02;
+	report[1] = 0xa0 | (pressure != 0);
+	report[2] = x;
+	report[3] = x >> 8;
+	report[4] = y;
+	report[5] = y >> 8;
+	report[6] = pressure;
+	report[7] = pressure >> 8;
+}
+
+static const struct uhid_model uhid_models[] = {
+	{
+		.name = "huion",
+		.vendor = 0x256c,
+		.product = 0x006e,
+		.rdesc = huion_rdesc,
+		.rdesc_size = sizeof(huion_rdesc),
+		.answers = huion_answers,
+		.num_answers = ARRAY_SIZE(huion_answers),
+		.pen = huion_pen,
+		.pen_size = 12,
+	},
+	{
+		.name = "ugee",
+		.vendor = 0x28bd,
+		.product = 0x0935,
+		.rdesc = ugee_rdesc,
+		.rdesc_size = sizeof(ugee_rdesc),
+		.answers = ugee_answers,
+		.num_answers = ARRAY_SIZE(ugee_answers),
+		.pen = ugee_pen,
+		.pen_size = 12,
+	},
+	{
+		.name = "ugee-lw",
+		.vendor = 0x28bd,
+		.product = 0x0935,
+		.rdesc = ugee_rdesc,
+		.rdesc_size = sizeof(ugee_rdesc),
+		.answers = ugee_lw_answers,
+		.num_answers = ARRAY_SIZE(ugee_lw_answers),
+		.pen = ugee_pen,
+		.pen_size = 12,
+		.hook = ugee_lw_reconnect,
+		.hook_size = sizeof(ugee_lw_reconnect),
+	},
+};
+
+/* A pen report waiting for its events */
+struct uhid_sent {
+	unsigned int x;
+	uint64_t ns;
+};
+
+/* A virtual tablet */
+struct uhid_tablet {
+	int fd;
+	const struct uhid_model *model;
+	char phys[64];
+	/* The pen's evdev node, -1 if not found yet */
+	int evdev_fd;
+	/* The tablet's uclogic_stats file, empty if not found */
+	char stats_path[PATH_MAX];
+	/* Last handshake request */
+	uint8_t req[UCLOGIC_VIRTUAL_REPORT_SIZE];
+	unsigned int requests;
+	bool started;
+	/* Pen reports waiting for their events, from "head" to "tail" */
+	struct uhid_sent pending[UHID_PENDING];
+	unsigned long head;
+	unsigned long tail;
+	/* X coordinate in the event packet being read, or -1 */
+	int x;
+	/* True if the rest of the event packet was dropped */
+	bool dropped;
+};
+
+/* Virtual tablets drawing at the same time */
+struct uhid_run {
+	const struct uhid_model *model;
+	struct uhid_tablet *tablets;
+	unsigned int num;
+	/* The uhid and the evdev file descriptor of each tablet, in turn */
+	struct pollfd *pfds;
+	/* Latencies of the matched pen reports, ns */
+	uint64_t *lat_ns;
+	unsigned long matched;
+	unsigned long lost;
+	/* Time spent writing the reports, ns */
+	uint64_t write_ns;
+};
+
+static uint64_t uhid_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int uhid_write(int fd, const struct uhid_event *ev)
+{
+	ssize_t rc = write(fd, ev, sizeof(*ev));
+
+	if (rc < 0)
+		return -errno;
+	return rc == sizeof(*ev) ? 0 : -EFAULT;
+}
+
+static int uhid_create(struct uhid_tablet *t)
+{
+	struct uhid_event ev = { .type = UHID_CREATE2 };
+
+	snprintf((char *)ev.u.create2.name, sizeof(ev.u.create2.name),
+		 "uclogic-uhid %s", t->model->name);
+	snprintf((char *)ev.u.create2.phys, sizeof(ev.u.create2.phys),
+		 "%s", t->phys);
+	memcpy(ev.u.create2.rd_data, t->model->rdesc, t->model->rdesc_size);
+	ev.u.create2.rd_size = t->model->rdesc_size;
+	/* The driver only matches USB IDs */
+	ev.u.create2.bus = 0x03;
+	ev.u.create2.vendor = t->model->vendor;
+	ev.u.create2.product = t->model->product;
+	return uhid_write(t->fd, &ev);
+}
+
+/* Answer the last handshake request into a feature report */
+static void uhid_answer(struct uhid_tablet *t, uint8_t *report)
+{
+	const struct uhid_answer *a;
+	size_t i;
+
+	memset(report, 0, UCLOGIC_VIRTUAL_REPORT_SIZE);
+	report[0] = UCLOGIC_VIRTUAL_REPORT_ID;
+	report[1] = EPIPE;
+	for (i = 0; i < t->model->num_answers; i++) {
+		a = &t->model->answers[i];
+		if (a->req != t->req[1] || a->idx != t->req[2])
+			continue;
+		report[1] = 0;
+		report[2] = a->size;
+		if (a->size != 0)
+			memcpy(report + 3, a->data, a->size);
+		break;
+	}
+	t->requests++;
+}
+
+/* Handle an event from uhid */
+static int uhid_handle(struct uhid_tablet *t)
+{
+	struct uhid_event ev;
+	struct uhid_event reply = {};
+	ssize_t rc;
+
+	rc = read(t->fd, &ev, sizeof(ev));
+	if (rc < 0)
+		return errno == EAGAIN ? 0 : -errno;
+
+	switch (ev.type) {
+	case UHID_START:
+		t->started = true;
+		break;
+	case UHID_STOP:
+		t->started = false;
+		break;
+	case UHID_SET_REPORT:
+		reply.type = UHID_SET_REPORT_REPLY;
+		reply.u.set_report_reply.id = ev.u.set_report.id;
+		if (ev.u.set_report.rnum != UCLOGIC_VIRTUAL_REPORT_ID ||
+		    ev.u.set_report.size > sizeof(t->req)) {
+			reply.u.set_report_reply.err = EIO;
+		} else {
+			memset(t->req, 0, sizeof(t->req));
+			memcpy(t->req, ev.u.set_report.data,
+			       ev.u.set_report.size);
+		}
+		return uhid_write(t->fd, &reply);
+	case UHID_GET_REPORT:
+		reply.type = UHID_GET_REPORT_REPLY;
+		reply.u.get_report_reply.id = ev.u.get_report.id;
+		if (ev.u.get_report.rnum != UCLOGIC_VIRTUAL_REPORT_ID) {
+			reply.u.get_report_reply.err = EIO;
+		} else {
+			uhid_answer(t, reply.u.get_report_reply.data);
+			reply.u.get_report_reply.size =
+				UCLOGIC_VIRTUAL_REPORT_SIZE;
+		}
+		return uhid_write(t->fd, &reply);
+	default:
+		break;
+	}
+	return 0;
+}
+
+/* Match an event packet with the X coordinate "x" to a pending report */
+static void uhid_match(struct uhid_run *r, struct uhid_tablet *t,
+		       unsigned int x, uint64_t ns)
+{
+	const struct uhid_sent *s;
+
+	while (t->head != t->tail) {
+		s = &t->pending[t->head++ % UHID_PENDING];
+		if (s->x == x) {
+			r->lat_ns[r->matched++] = ns > s->ns ? ns - s->ns : 0;
+			return;
+		}
+		r->lost++;
+	}
+}
+
+/* Read the events available on a tablet's evdev node */
+static int uhid_read_evdev(struct uhid_run *r, struct uhid_tablet *t)
+{
+	struct input_event ev[64];
+	ssize_t rc;
+	size_t i;
+
+	while ((rc = read(t->evdev_fd, ev, sizeof(ev))) > 0) {
+		for (i = 0; i < rc / sizeof(ev[0]); i++) {
+			if (ev[i].type == EV_ABS && ev[i].code == ABS_X) {
+				t->x = ev[i].value;
+			} else if (ev[i].type == EV_SYN &&
+				   ev[i].code == SYN_DROPPED) {
+				t->dropped = true;
+			} else if (ev[i].type == EV_SYN &&
+				   ev[i].code == SYN_REPORT) {
+				if (!t->dropped && t->x >= 0)
+					uhid_match(r, t, t->x,
+						   ev[i].input_event_sec *
+							1000000000ULL +
+						   ev[i].input_event_usec *
+							1000ULL);
+				t->x = -1;
+				t->dropped = false;
+			}
+		}
+	}
+	return rc < 0 && errno != EAGAIN ? -errno : 0;
+}
+
+/*
+ * Handle the events from uhid and evdev until "until_ns", or only the ones
+ * already available, if that has passed.
+ */
+static int uhid_poll(struct uhid_run *r, uint64_t until_ns)
+{
+	struct uhid_tablet *t;
+	struct timespec ts;
+	uint64_t left_ns;
+	unsigned int i;
+	int ready;
+	int rc;
+
+	do {
+		left_ns = until_ns - uhid_now_ns();
+		if ((int64_t)left_ns < 0)
+			left_ns = 0;
+		ts.tv_sec = left_ns / 1000000000;
+		ts.tv_nsec = left_ns % 1000000000;
+		ready = ppoll(r->pfds, 2 * r->num, &ts, NULL);
+		if (ready < 0 && errno != EINTR)
+			return -errno;
+		for (i = 0; i < r->num && ready > 0; i++) {
+			t = &r->tablets[i];
+			if (r->pfds[2 * i].revents & POLLIN) {
+				rc = uhid_handle(t);
+				if (rc != 0)
+					return rc;
+			}
+			if (r->pfds[2 * i + 1].revents & POLLIN) {
+				rc = uhid_read_evdev(r, t);
+				if (rc != 0)
+					return rc;
+			}
+		}
+	} while (left_ns != 0);
+	return 0;
+}
+
+/*
+ * Start collecting the statistics of a tablet's HID device, as they're off
+ * by default. The in-range timeouts and the hooked reports are only counted
+ * from then on, which is before any report is sent.
+ */
+static void uhid_enable_stats(const char *hid)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	snprintf(path, sizeof(path),
+		 "/sys/kernel/debug/hid/%s/uclogic_stats_enable", hid);
+	fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	if (write(fd, "1", 1) < 0)
+		fprintf(stderr, "failed enabling statistics in %s: %s\n",
+			path, strerror(errno));
+	close(fd);
+}
+
+/*
+ * Find the evdev nodes of the tablets' pens: the ones with the tablets'
+ * physical paths, reporting X and pressure. Find the tablets' uclogic_stats
+ * files too, in the debugfs directories named after their HID devices.
+ */
+static void uhid_find_evdevs(struct uhid_run *r)
+{
+	unsigned long abs[ABS_CNT / (8 * sizeof(long)) + 1];
+	char path[PATH_MAX];
+	char hid[PATH_MAX];
+	char phys[64];
+	struct uhid_tablet *t;
+	unsigned int n, i;
+	int fd;
+
+	for (n = 0; n < 1024; n++) {
+		snprintf(path, sizeof(path), "/dev/input/event%u", n);
+		fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (fd < 0)
+			continue;
+		memset(phys, 0, sizeof(phys));
+		memset(abs, 0, sizeof(abs));
+		t = NULL;
+		if (ioctl(fd, EVIOCGPHYS(sizeof(phys) - 1), phys) >= 0) {
+			for (i = 0; i < r->num && t == NULL; i++)
+				if (r->tablets[i].evdev_fd < 0 &&
+				    strcmp(phys, r->tablets[i].phys) == 0)
+					t = &r->tablets[i];
+		}
+		if (t == NULL ||
+		    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs) < 0 ||
+		    !(abs[ABS_X / (8 * sizeof(long))] &
+		      (1UL << ABS_X % (8 * sizeof(long)))) ||
+		    !(abs[ABS_PRESSURE / (8 * sizeof(long))] &
+		      (1UL << ABS_PRESSURE % (8 * sizeof(long)))) ||
+		    ioctl(fd, EVIOCSCLOCKID, &(int){ CLOCK_MONOTONIC }) < 0) {
+			close(fd);
+			continue;
+		}
+		t->evdev_fd = fd;
+		t->x = -1;
+		i = t - r->tablets;
+		r->pfds[2 * i + 1].fd = fd;
+		r->pfds[2 * i + 1].events = POLLIN;
+
+		snprintf(path, sizeof(path),
+			 "/sys/class/input/event%u/device/device", n);
+		if (realpath(path, hid) != NULL) {
+			snprintf(t->stats_path, sizeof(t->stats_path),
+				 "/sys/kernel/debug/hid/%s/uclogic_stats",
+				 basename(hid));
+			uhid_enable_stats(basename(hid));
+		}
+	}
+}
+
+/*
+ * Sum the in-range timer runs and the hooked reports over the tablets.
+ * Returns false if any tablet's statistics couldn't be read.
+ */
+static bool uhid_read_stats(const struct uhid_run *r,
+			    unsigned long long *ptimeouts,
+			    unsigned long long *phooks)
+{
+	unsigned long long value;
+	char line[64];
+	unsigned int i;
+	FILE *f;
+
+	*ptimeouts = *phooks = 0;
+	for (i = 0; i < r->num; i++) {
+		f = fopen(r->tablets[i].stats_path, "r");
+		if (f == NULL)
+			return false;
+		while (fgets(line, sizeof(line), f) != NULL) {
+			if (sscanf(line, "inrange_timeouts: %llu", &value) == 1)
+				*ptimeouts += value;
+			else if (sscanf(line, "hooks: %llu", &value) == 1)
+				*phooks += value;
+		}
+		fclose(f);
+	}
+	return true;
+}
+
+/* Get the time all CPUs were busy, ns, or zero if unknown */
+static uint64_t uhid_cpu_busy_ns(void)
+{
+	unsigned long long v[8] = {};
+	FILE *f;
+	int n;
+
+	f = fopen("/proc/stat", "r");
+	if (f == NULL)
+		return 0;
+	n = fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+	fclose(f);
+	if (n < 4)
+		return 0;
+	/* All but the idle and I/O wait time */
+	return (v[0] + v[1] + v[2] + v[5] + v[6] + v[7]) * 1000000000ULL /
+		sysconf(_SC_CLK_TCK);
+}
+
+static int uhid_cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Get a latency percentile, in tenths of a percent, us */
+static unsigned long long uhid_permille_us(const struct uhid_run *r,
+					   unsigned int permille)
+{
+	if (r->matched == 0)
+		return 0;
+	return r->lat_ns[(r->matched - 1) * permille / 1000] / 1000;
+}
+
+/*
+ * Send "num" pen reports from each tablet, drawing strokes, "rate" per
+ * second, or as fast as possible, spreading the tablets' reports evenly.
+ * Send the hooked report in place of every "every"-th one, if not zero.
+ */
+static int uhid_draw(struct uhid_run *r, unsigned long num,
+		     unsigned long rate, unsigned long every)
+{
+	const struct uhid_model *m = r->model;
+	struct uhid_event ev = { .type = UHID_INPUT2 };
+	struct uhid_tablet *t;
+	unsigned long total = num * r->num;
+	unsigned long long timeouts[2];
+	unsigned long long hooks[2];
+	char timer_runs[24] = "-";
+	char hook_works[24] = "-";
+	unsigned int requests = 0;
+	unsigned int step;
+	unsigned int x;
+	uint64_t start_ns, ns, cpu_ns, write_ns;
+	unsigned long k, n;
+	unsigned int i;
+	bool stats;
+	int rc;
+
+	stats = uhid_read_stats(r, &timeouts[0], &hooks[0]);
+	cpu_ns = uhid_cpu_busy_ns();
+	start_ns = uhid_now_ns();
+	for (k = 0; k < total; k++) {
+		t = &r->tablets[k % r->num];
+		n = k / r->num;
+
+		/* Handle the events while waiting for the next report */
+		rc = uhid_poll(r, rate == 0 ? 0 : start_ns + k * 1000000000ULL /
+						((uint64_t)rate * r->num));
+		if (rc != 0)
+			return rc;
+
+		write_ns = uhid_now_ns();
+		if (every != 0 && m->hook != NULL && n % every == every - 1) {
+			ev.u.input2.size = m->hook_size;
+			memcpy(ev.u.input2.data, m->hook, m->hook_size);
+		} else {
+			/* Strokes of 100 reports, lifting the pen between them */
+			step = n % 100;
+			x = 1000 + step * 50;
+			ev.u.input2.size = m->pen_size;
+			m->pen(ev.u.input2.data, x, 1000 + (n / 100 % 100) * 50,
+			       step < 90 ? 100 + step * 40 : 0);
+			if (t->tail - t->head == UHID_PENDING) {
+				t->head++;
+				r->lost++;
+			}
+			t->pending[t->tail % UHID_PENDING].x = x;
+			t->pending[t->tail % UHID_PENDING].ns = write_ns;
+			t->tail++;
+		}
+		rc = uhid_write(t->fd, &ev);
+		r->write_ns += uhid_now_ns() - write_ns;
+		if (rc == 0)
+			rc = uhid_read_evdev(r, t);
+		if (rc != 0)
+			return rc;
+	}
+	ns = uhid_now_ns() - start_ns;
+	if (cpu_ns != 0)
+		cpu_ns = uhid_cpu_busy_ns() - cpu_ns;
+	stats = stats && uhid_read_stats(r, &timeouts[1], &hooks[1]);
+
+	/* Give the last events some time to arrive */
+	rc = uhid_poll(r, uhid_now_ns() + 100000000);
+	if (rc != 0)
+		return rc;
+	for (i = 0; i < r->num; i++) {
+		t = &r->tablets[i];
+		r->lost += t->tail - t->head;
+		requests += t->requests;
+	}
+
+	if (stats && ns != 0) {
+		snprintf(timer_runs, sizeof(timer_runs), "%llu",
+			 (timeouts[1] - timeouts[0]) * 1000000000ULL / ns);
+		snprintf(hook_works, sizeof(hook_works), "%llu",
+			 (hooks[1] - hooks[0]) * 1000000000ULL / ns);
+	}
+	qsort(r->lat_ns, r->matched, sizeof(r->lat_ns[0]), uhid_cmp_u64);
+	printf("uclogic_uhid model=%s tablets=%u reports=%lu ns=%llu "
+	       "reports_per_s=%llu handshake_requests=%u "
+	       "write_ns_per_report=%llu cpu_ns_per_report=%llu lost=%lu "
+	       "p50_us=%llu p99_us=%llu p999_us=%llu max_us=%llu "
+	       "timer_runs_per_s=%s hook_works_per_s=%s\n",
+	       m->name, r->num, total, (unsigned long long)ns,
+	       (unsigned long long)(ns ? total * 1000000000ULL / ns : 0),
+	       requests, (unsigned long long)(r->write_ns / total),
+	       (unsigned long long)(cpu_ns / total), r->lost,
+	       uhid_permille_us(r, 500), uhid_permille_us(r, 990),
+	       uhid_permille_us(r, 999), uhid_permille_us(r, 1000),
+	       timer_runs, hook_works);
+	return 0;
+}
+
+/* Create "num_tablets" tablets, and draw with them */
+static int uhid_run(const struct uhid_model *model, unsigned int num_tablets,
+		    unsigned long num, unsigned long rate, unsigned long every)
+{
+	struct uhid_event destroy = { .type = UHID_DESTROY };
+	struct uhid_run r = { .model = model, .num = num_tablets };
+	struct uhid_tablet *t;
+	unsigned int requests = 0;
+	unsigned int found = 0;
+	unsigned int last_found = 0;
+	uint64_t deadline_ns;
+	unsigned int i;
+	int rc = -ENOMEM;
+
+	r.tablets = calloc(num_tablets, sizeof(*r.tablets));
+	r.pfds = calloc(2 * num_tablets, sizeof(*r.pfds));
+	r.lat_ns = calloc(num * num_tablets, sizeof(*r.lat_ns));
+	if (r.tablets == NULL || r.pfds == NULL || r.lat_ns == NULL)
+		goto cleanup;
+	for (i = 0; i < num_tablets; i++) {
+		t = &r.tablets[i];
+		t->fd = t->evdev_fd = -1;
+		r.pfds[2 * i].fd = r.pfds[2 * i + 1].fd = -1;
+	}
+
+	for (i = 0; i < num_tablets; i++) {
+		t = &r.tablets[i];
+		t->model = model;
+		snprintf(t->phys, sizeof(t->phys), "uclogic-uhid/%d/%u",
+			 (int)getpid(), i);
+		t->fd = open("/dev/uhid", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if (t->fd < 0) {
+			rc = -errno;
+			perror("Failed opening /dev/uhid");
+			goto cleanup;
+		}
+		r.pfds[2 * i].fd = t->fd;
+		r.pfds[2 * i].events = POLLIN;
+		rc = uhid_create(t);
+		if (rc != 0)
+			goto cleanup;
+	}
+
+	/* Wait for the driver to bind, answering the handshakes */
+	deadline_ns = uhid_now_ns() + UHID_BIND_TIMEOUT_MS * 1000000ULL;
+	do {
+		rc = uhid_poll(&r, uhid_now_ns() + 100000000);
+		if (rc != 0)
+			goto cleanup;
+		uhid_find_evdevs(&r);
+		for (found = i = 0; i < num_tablets; i++)
+			found += r.tablets[i].evdev_fd >= 0;
+		if (found != last_found) {
+			last_found = found;
+			deadline_ns = uhid_now_ns() +
+				      UHID_BIND_TIMEOUT_MS * 1000000ULL;
+		}
+	} while (found < num_tablets && uhid_now_ns() < deadline_ns);
+	if (found < num_tablets) {
+		for (i = 0; i < num_tablets; i++)
+			requests += r.tablets[i].requests;
+		fprintf(stderr, "No pen evdev node for %u of %u tablets%s\n",
+			num_tablets - found, num_tablets,
+			requests == 0 ?
+				", is hid-uclogic loaded with virtual=1?" : "");
+		rc = -ENODEV;
+		goto cleanup;
+	}
+
+	rc = uhid_draw(&r, num, rate, every);
+
+cleanup:
+	for (i = 0; r.tablets != NULL && i < num_tablets; i++) {
+		t = &r.tablets[i];
+		if (t->evdev_fd >= 0)
+			close(t->evdev_fd);
+		if (t->fd >= 0) {
+			uhid_write(t->fd, &destroy);
+			close(t->fd);
+		}
+	}
+	free(r.lat_ns);
+	free(r.pfds);
+	free(r.tablets);
+	return rc;
+}
+
+int main(int argc, char **argv)
+{
+	const struct uhid_model *model = &uhid_models[0];
+	unsigned long num_tablets = 1;
+	unsigned long num = 10000;
+	unsigned long rate = 200;
+	unsigned long every = 0;
+	bool sweep = false;
+	unsigned int n;
+	size_t i;
+	int opt;
+	int rc;
+
+	while ((opt = getopt(argc, argv, "m:c:sn:r:e:")) != -1) {
+		switch (opt) {
+		case 'm':
+			for (i = 0; i < ARRAY_SIZE(uhid_models); i++)
+				if (strcmp(optarg, uhid_models[i].name) == 0)
+					break;
+			if (i == ARRAY_SIZE(uhid_models))
+				goto usage;
+			model = &uhid_models[i];
+			break;
+		case 'c':
+			num_tablets = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			sweep = true;
+			break;
+		case 'n':
+			num = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			every = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || num == 0 || num_tablets == 0 ||
+	    num_tablets > UHID_TABLETS_MAX)
+		goto usage;
+
+	for (n = sweep ? 1 : num_tablets; ; n = n * 2 < num_tablets ?
+						n * 2 : num_tablets) {
+		rc = uhid_run(model, n, num, rate, every);
+		if (rc != 0) {
+			fprintf(stderr, "Virtual tablets failed: %s\n",
+				strerror(-rc));
+			return 1;
+		}
+		if (n == num_tablets)
+			break;
+	}
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"Usage: %s [-m huion|ugee|ugee-lw] [-c TABLETS] [-s] "
+		"[-n REPORTS] [-r RATE] [-e EVERY]\n", argv[0]);
+	return 2;
+}
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ *  HID driver for UC-Logic devices not fully compliant with HID standard
+ *  - userspace library interface
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+#ifndef _UCLOGIC_USERMODE_H
+#define _UCLOGIC_USERMODE_H
+
+#include "hid-uclogic-params.h"
+#include "hid-uclogic-rdesc.h"
+
+/*
+ * Besides the functions declared in hid-uclogic-params.h and
+ * hid-uclogic-rdesc.h, the library exports these driver-internal ones.
+ */
+
+/* Handle a raw report, like the driver's raw_event and report callbacks */
+extern int uclogic_um_raw_event(struct hid_device *hdev,
+				struct hid_report *report,
+				u8 *data, int size);
+
+/* Let the pen in-range timer expire, if it's pending */
+extern void uclogic_um_inrange_timer_fire(struct uclogic_drvdata *drvdata);
+
+/* Parse the string descriptor of a UGEE v2 device */
+extern int uclogic_um_parse_ugee_v2_desc(
+			const __u8 *str_desc, size_t str_desc_size,
+			s32 *desc_params, size_t desc_params_size,
+			enum uclogic_params_frame_type *frame_type);
+
+#endif /* _UCLOGIC_USERMODE_H */
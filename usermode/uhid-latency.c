@@ -0,0 +1,584 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ *  End-to-end input latency and throughput of the HID drivers, over uhid
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ */
+
+/*
+ * Create a virtual tablet with uhid, presenting the original report
+ * descriptor of a Kye, Polostar, or ViewSonic tablet, inject pen reports
+ * and time each of them from its write to the matching event on the
+ * tablet's evdev node. First measure the latency at a fixed rate, then
+ * keep doubling the rate until reports are lost or can't be sent in time,
+ * to find the maximum sustainable rate. Needs hid-kye, hid-polostar and
+ * hid-viewsonic loaded, write access to /dev/uhid and read access to
+ * /dev/input.
+ *
+ * Usage: uhid-latency [-m MODEL] [-n REPORTS] [-r RATE]
+ *
+ * MODEL is "kye" for a Genius EasyPen i405X, "polostar" for a Polostar
+ * PT-1001, or "viewsonic" for a ViewSonic PD1011, all of them in turn by
+ * default. REPORTS is the number of reports sent at each rate, 10000 by
+ * default. RATE is the number of reports per second the latency is
+ * measured at, and the first rate tried for the maximum, 1000 by default.
+ *
+ * The drivers only recognize the original descriptors by their size, so
+ * a vendor-defined stand-in of the same size is presented instead. The
+ * latencies come from the evdev event timestamps and so have microsecond
+ * resolution.
+ *
+ * Each measurement prints a line like:
+ *
+ *   uhid_latency model=kye rate=1000 reports=10000 lost=0
+ *                reports_per_s=1000 p50_us=4 p90_us=5 p99_us=9 max_us=31
+ *
+ * followed by the maximum sustainable rate for the model:
+ *
+ *   uhid_latency model=kye max_rate=256000
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <linux/input.h>
+#include <linux/uhid.h>
+
+#define ARRAY_SIZE(_a)	(sizeof(_a) / sizeof((_a)[0]))
+
+/* Number of distinct X coordinates used to match events to reports */
+#define UHID_X_STEPS	32
+/* Maximum number of reports waiting for their events */
+#define UHID_PENDING	64
+/* Maximum number of rate doublings looking for the maximum */
+#define UHID_DOUBLINGS	16
+
+/* A model of a tablet */
+struct uhid_model {
+	const char *name;
+	uint16_t vendor;
+	uint16_t product;
+	/* Size of the original report descriptor */
+	size_t rdesc_size;
+	/* Fill in a pen report, returning its size */
+	size_t (*pen)(uint8_t *report, unsigned int x, unsigned int y,
+		      unsigned int pressure);
+	/* Maximum X coordinate in the fixed report descriptor */
+	unsigned int x_max;
+};
+
+static size_t kye_pen(uint8_t *report, unsigned int x, unsigned int y,
+		      unsigned int pressure)
+{
+	report[0] = 0x10;
+	/* In range and tip switch */
+	report[1] = 0x81;
+	report[2] = x;
+	report[3] = x >> 8;
+	report[4] = y;
+	report[5] = y >> 8;
+	report[6] = pressure;
+	report[7] = pressure >> 8;
+	return 8;
+}
+
+static size_t polostar_pen(uint8_t *report, unsigned int x, unsigned int y,
+			   unsigned int pressure)
+{
+	report[0] = 0x09;
+	/* Tip switch */
+	report[1] = 0x01;
+	report[2] = x;
+	report[3] = x >> 8;
+	report[4] = y;
+	report[5] = y >> 8;
+	report[6] = pressure;
+	report[7] = pressure >> 8;
+	return 8;
+}
+
+static size_t viewsonic_pen(uint8_t *report, unsigned int x, unsigned int y,
+			    unsigned int pressure)
+{
+	report[0] = 0x02;
+	report[1] = x;
+	report[2] = x >> 8;
+	report[3] = y;
+	report[4] = y >> 8;
+	/* In range and tip switch */
+	report[5] = 0x06;
+	report[6] = pressure;
+	report[7] = pressure >> 8;
+	report[8] = 0;
+	report[9] = 0;
+	return 10;
+}
+
+static const struct uhid_model uhid_models[] = {
+	{
+		.name = "kye",
+		.vendor = 0x0458,
+		.product = 0x5010,
+		.rdesc_size = 476,
+		.pen = kye_pen,
+		.x_max = 14080,
+	},
+	{
+		.name = "polostar",
+		.vendor = 0x099a,
+		.product = 0x2620,
+		.rdesc_size = 317,
+		.pen = polostar_pen,
+		.x_max = 4096,
+	},
+	{
+		.name = "viewsonic",
+		.vendor = 0x0543,
+		.product = 0xe621,
+		.rdesc_size = 408,
+		.pen = viewsonic_pen,
+		.x_max = 43392,
+	},
+};
+
+/* A report waiting for its events */
+struct uhid_sent {
+	unsigned int x;
+	uint64_t ns;
+};
+
+/* The virtual tablet, and a measurement in progress */
+struct uhid_tablet {
+	int fd;
+	int evdev_fd;
+	const struct uhid_model *model;
+	char phys[64];
+	bool started;
+	/* Reports waiting for their events, from "head" to "tail" */
+	struct uhid_sent pending[UHID_PENDING];
+	unsigned long head;
+	unsigned long tail;
+	/* X coordinate in the event packet being read, or -1 */
+	int x;
+	/* True if the rest of the event packet was dropped */
+	bool dropped;
+	/* Latencies of the matched reports */
+	uint64_t *lat_ns;
+	unsigned long matched;
+	unsigned long lost;
+};
+
+static uint64_t uhid_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void uhid_sleep_until(uint64_t ns)
+{
+	struct timespec ts = {
+		.tv_sec = ns / 1000000000,
+		.tv_nsec = ns % 1000000000,
+	};
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts,
+			       NULL) == EINTR)
+		;
+}
+
+static int uhid_write(int fd, const struct uhid_event *ev)
+{
+	ssize_t rc = write(fd, ev, sizeof(*ev));
+
+	if (rc < 0)
+		return -errno;
+	return rc == sizeof(*ev) ? 0 : -EFAULT;
+}
+
+/*
+ * Create the tablet with a stand-in for its original report descriptor: a
+ * vendor-defined collection of the same size.
+ */
+static int uhid_create(struct uhid_tablet *t)
+{
+	struct uhid_event ev = { .type = UHID_CREATE2 };
+	uint8_t *rdesc = ev.u.create2.rd_data;
+	size_t size = t->model->rdesc_size;
+	size_t i = 0;
+
+	snprintf((char *)ev.u.create2.name, sizeof(ev.u.create2.name),
+		 "uhid-latency %s", t->model->name);
+	snprintf((char *)ev.u.create2.phys, sizeof(ev.u.create2.phys),
+		 "%s", t->phys);
+	/* Usage Page (FF00h), Usage (01h), Collection (Application) */
+	rdesc[i++] = 0x06;
+	rdesc[i++] = 0x00;
+	rdesc[i++] = 0xff;
+	rdesc[i++] = 0x09;
+	rdesc[i++] = 0x01;
+	rdesc[i++] = 0xa1;
+	rdesc[i++] = 0x01;
+	/* Usage (02h) up to the size, with one 3-byte item for odd sizes */
+	if ((size - i - 1) % 2 != 0) {
+		rdesc[i++] = 0x0a;
+		rdesc[i++] = 0x02;
+		rdesc[i++] = 0x00;
+	}
+	while (i < size - 1) {
+		rdesc[i++] = 0x09;
+		rdesc[i++] = 0x02;
+	}
+	/* End Collection */
+	rdesc[i++] = 0xc0;
+	ev.u.create2.rd_size = size;
+	/* The drivers only match USB IDs */
+	ev.u.create2.bus = 0x03;
+	ev.u.create2.vendor = t->model->vendor;
+	ev.u.create2.product = t->model->product;
+	return uhid_write(t->fd, &ev);
+}
+
+/* Handle an event from uhid, accepting any feature report set */
+static int uhid_handle(struct uhid_tablet *t)
+{
+	struct uhid_event ev;
+	struct uhid_event reply = {};
+	ssize_t rc;
+
+	rc = read(t->fd, &ev, sizeof(ev));
+	if (rc < 0)
+		return errno == EAGAIN ? 0 : -errno;
+
+	switch (ev.type) {
+	case UHID_START:
+		t->started = true;
+		break;
+	case UHID_STOP:
+		t->started = false;
+		break;
+	case UHID_SET_REPORT:
+		reply.type = UHID_SET_REPORT_REPLY;
+		reply.u.set_report_reply.id = ev.u.set_report.id;
+		return uhid_write(t->fd, &reply);
+	case UHID_GET_REPORT:
+		reply.type = UHID_GET_REPORT_REPLY;
+		reply.u.get_report_reply.id = ev.u.get_report.id;
+		reply.u.get_report_reply.err = EIO;
+		return uhid_write(t->fd, &reply);
+	default:
+		break;
+	}
+	return 0;
+}
+
+/* Handle the events from uhid, waiting for them up to "timeout_ms" */
+static int uhid_poll(struct uhid_tablet *t, int timeout_ms)
+{
+	struct pollfd pfd = { .fd = t->fd, .events = POLLIN };
+	int rc;
+
+	while ((rc = poll(&pfd, 1, timeout_ms)) > 0) {
+		rc = uhid_handle(t);
+		if (rc != 0)
+			return rc;
+		timeout_ms = 0;
+	}
+	return rc < 0 ? -errno : 0;
+}
+
+/*
+ * Open the evdev node of the tablet's pen: the one with our physical path,
+ * reporting X and pressure. Returns the file descriptor, or -1 if not found.
+ */
+static int uhid_open_evdev(const struct uhid_tablet *t)
+{
+	unsigned long abs[ABS_CNT / (8 * sizeof(long)) + 1];
+	char path[32];
+	char phys[64];
+	unsigned int i;
+	int fd;
+
+	for (i = 0; i < 256; i++) {
+		snprintf(path, sizeof(path), "/dev/input/event%u", i);
+		fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (fd < 0)
+			continue;
+		memset(phys, 0, sizeof(phys));
+		memset(abs, 0, sizeof(abs));
+		if (ioctl(fd, EVIOCGPHYS(sizeof(phys) - 1), phys) >= 0 &&
+		    strcmp(phys, t->phys) == 0 &&
+		    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs) >= 0 &&
+		    abs[ABS_X / (8 * sizeof(long))] &
+			(1UL << ABS_X % (8 * sizeof(long))) &&
+		    abs[ABS_PRESSURE / (8 * sizeof(long))] &
+			(1UL << ABS_PRESSURE % (8 * sizeof(long))))
+			return fd;
+		close(fd);
+	}
+	return -1;
+}
+
+/* Match an event packet with the X coordinate "x" to a pending report */
+static void uhid_match(struct uhid_tablet *t, unsigned int x, uint64_t ns)
+{
+	const struct uhid_sent *s;
+
+	while (t->head != t->tail) {
+		s = &t->pending[t->head++ % UHID_PENDING];
+		if (s->x == x) {
+			t->lat_ns[t->matched++] = ns > s->ns ? ns - s->ns : 0;
+			return;
+		}
+		t->lost++;
+	}
+}
+
+/* Read the events available on the evdev node */
+static int uhid_read_evdev(struct uhid_tablet *t)
+{
+	struct input_event ev[64];
+	ssize_t rc;
+	size_t i;
+
+	while ((rc = read(t->evdev_fd, ev, sizeof(ev))) > 0) {
+		for (i = 0; i < rc / sizeof(ev[0]); i++) {
+			if (ev[i].type == EV_ABS && ev[i].code == ABS_X) {
+				t->x = ev[i].value;
+			} else if (ev[i].type == EV_SYN &&
+				   ev[i].code == SYN_DROPPED) {
+				t->dropped = true;
+			} else if (ev[i].type == EV_SYN &&
+				   ev[i].code == SYN_REPORT) {
+				if (!t->dropped && t->x >= 0)
+					uhid_match(t, t->x,
+						   ev[i].input_event_sec *
+							1000000000ULL +
+						   ev[i].input_event_usec *
+							1000ULL);
+				t->x = -1;
+				t->dropped = false;
+			}
+		}
+	}
+	return rc < 0 && errno != EAGAIN ? -errno : 0;
+}
+
+static int uhid_cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static unsigned long long uhid_pct_us(const struct uhid_tablet *t,
+				      unsigned int pct)
+{
+	if (t->matched == 0)
+		return 0;
+	return t->lat_ns[(t->matched - 1) * pct / 100] / 1000;
+}
+
+/*
+ * Send "num" pen reports, "rate" per second, matching each with its events.
+ * Returns zero and sets "psustained" to whether all the reports arrived and
+ * were sent at least at 95% of the rate, or a negative errno.
+ */
+static int uhid_measure(struct uhid_tablet *t, unsigned long num,
+			unsigned long rate, bool *psustained)
+{
+	struct uhid_event ev = { .type = UHID_INPUT2 };
+	uint64_t start_ns, next_ns, ns;
+	unsigned long n;
+	unsigned int x;
+	int rc;
+
+	t->head = t->tail = 0;
+	t->x = -1;
+	t->dropped = false;
+	t->matched = t->lost = 0;
+
+	start_ns = next_ns = uhid_now_ns();
+	for (n = 0; n < num; n++) {
+		/* Move by several times the input fuzz between reports */
+		x = (n % UHID_X_STEPS + 1) * t->model->x_max /
+			(UHID_X_STEPS + 2);
+		ev.u.input2.size = t->model->pen(ev.u.input2.data, x, 1000,
+						 500);
+		if (t->tail - t->head == UHID_PENDING) {
+			t->head++;
+			t->lost++;
+		}
+		t->pending[t->tail % UHID_PENDING].x = x;
+		t->pending[t->tail % UHID_PENDING].ns = uhid_now_ns();
+		t->tail++;
+		rc = uhid_write(t->fd, &ev);
+		if (rc == 0)
+			rc = uhid_read_evdev(t);
+		if (rc == 0)
+			rc = uhid_poll(t, 0);
+		if (rc != 0)
+			return rc;
+
+		next_ns += 1000000000 / rate;
+		if (next_ns > uhid_now_ns())
+			uhid_sleep_until(next_ns);
+	}
+	ns = uhid_now_ns() - start_ns;
+
+	/* Give the last events some time to arrive */
+	for (n = 0; n < 10 && t->head != t->tail; n++) {
+		uhid_sleep_until(uhid_now_ns() + 10000000);
+		rc = uhid_read_evdev(t);
+		if (rc != 0)
+			return rc;
+	}
+	t->lost += t->tail - t->head;
+
+	qsort(t->lat_ns, t->matched, sizeof(t->lat_ns[0]), uhid_cmp_u64);
+	printf("uhid_latency model=%s rate=%lu reports=%lu lost=%lu "
+	       "reports_per_s=%llu p50_us=%llu p90_us=%llu p99_us=%llu "
+	       "max_us=%llu\n",
+	       t->model->name, rate, num, t->lost,
+	       (unsigned long long)(ns ? num * 1000000000ULL / ns : 0),
+	       uhid_pct_us(t, 50), uhid_pct_us(t, 90), uhid_pct_us(t, 99),
+	       uhid_pct_us(t, 100));
+	*psustained = t->lost == 0 && num * 1000000000ULL / 100 * 95 <=
+					(unsigned long long)rate * ns;
+	return 0;
+}
+
+/* Measure the latency at "rate", then find the maximum sustainable rate */
+static int uhid_run(const struct uhid_model *model, unsigned long num,
+		    unsigned long rate)
+{
+	struct uhid_tablet t = { .model = model, .evdev_fd = -1 };
+	struct uhid_event destroy = { .type = UHID_DESTROY };
+	unsigned long max_rate = 0;
+	bool sustained = true;
+	unsigned int i;
+	int rc;
+
+	snprintf(t.phys, sizeof(t.phys), "uhid-latency/%d/%s",
+		 (int)getpid(), model->name);
+	t.lat_ns = calloc(num, sizeof(t.lat_ns[0]));
+	if (t.lat_ns == NULL)
+		return -ENOMEM;
+	t.fd = open("/dev/uhid", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (t.fd < 0) {
+		rc = -errno;
+		goto cleanup;
+	}
+	rc = uhid_create(&t);
+	if (rc != 0)
+		goto cleanup;
+
+	/* Wait for a driver to bind and for the evdev node to appear */
+	for (i = 0; i < 50 && t.evdev_fd < 0; i++) {
+		rc = uhid_poll(&t, 100);
+		if (rc != 0)
+			goto cleanup;
+		if (t.started)
+			t.evdev_fd = uhid_open_evdev(&t);
+	}
+	if (t.evdev_fd < 0) {
+		fprintf(stderr, "No pen evdev node for the %s tablet, "
+			"is its driver loaded?\n", model->name);
+		rc = -ENODEV;
+		goto cleanup;
+	}
+	rc = ioctl(t.evdev_fd, EVIOCSCLOCKID, &(int){ CLOCK_MONOTONIC });
+	if (rc != 0) {
+		rc = -errno;
+		goto cleanup;
+	}
+
+	for (i = 0; i <= UHID_DOUBLINGS && sustained; i++, rate *= 2) {
+		rc = uhid_measure(&t, num, rate, &sustained);
+		if (rc != 0)
+			goto cleanup;
+		if (sustained)
+			max_rate = rate;
+	}
+	printf("uhid_latency model=%s max_rate=%lu\n", model->name, max_rate);
+
+cleanup:
+	if (t.evdev_fd >= 0)
+		close(t.evdev_fd);
+	if (t.fd >= 0) {
+		uhid_write(t.fd, &destroy);
+		close(t.fd);
+	}
+	free(t.lat_ns);
+	return rc;
+}
+
+int main(int argc, char **argv)
+{
+	const struct uhid_model *model = NULL;
+	unsigned long num = 10000;
+	unsigned long rate = 1000;
+	size_t i;
+	int opt;
+	int rc;
+
+	while ((opt = getopt(argc, argv, "m:n:r:")) != -1) {
+		switch (opt) {
+		case 'm':
+			for (i = 0; i < ARRAY_SIZE(uhid_models); i++)
+				if (strcmp(optarg, uhid_models[i].name) == 0)
+					break;
+			if (i == ARRAY_SIZE(uhid_models))
+				goto usage;
+			model = &uhid_models[i];
+			break;
+		case 'n':
+			num = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || num == 0 || rate == 0)
+		goto usage;
+
+	/* Wake up on time at high rates */
+	prctl(PR_SET_TIMERSLACK, 1UL);
+
+	for (i = 0; i < ARRAY_SIZE(uhid_models); i++) {
+		if (model != NULL && model != &uhid_models[i])
+			continue;
+		rc = uhid_run(&uhid_models[i], num, rate);
+		if (rc != 0) {
+			fprintf(stderr, "Measuring the %s tablet failed: %s\n",
+				uhid_models[i].name, strerror(-rc));
+			return 1;
+		}
+	}
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"Usage: %s [-m kye|polostar|viewsonic] [-n REPORTS] "
+		"[-r RATE]\n", argv[0]);
+	return 2;
+}